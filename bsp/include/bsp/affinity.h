@@ -0,0 +1,312 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_AFFINITY_H__
+#define __BSPLIB_AFFINITY_H__
+
+#include "bsp/topology.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+namespace BspInternal
+{
+    /**
+     * The policies that determine on which logical processor each BSP processor is pinned.
+     */
+
+    enum class AffinityPolicy
+    {
+        /// Threads are not pinned, and the operating system is free to migrate them.
+        None,
+        /// Consecutive processors are placed on hardware threads of the same core, then the same package.
+        Compact,
+        /// Consecutive processors are spread over the packages and cores.
+        Scatter,
+        /// Processors are placed on an explicitly given list of logical processors.
+        Explicit,
+        /// The policy is read from the `BSP_AFFINITY` environment variable.
+        Environment
+    };
+
+    /**
+     * The saved affinity of a thread, so it can be restored after the computation ended.
+     */
+
+    struct ThreadMask
+    {
+#ifdef __linux__
+        cpu_set_t mask;
+#endif
+        bool valid;
+    };
+
+    /**
+     * Computes and applies the thread placement for a BSP computation.
+     */
+
+    class Affinity
+    {
+    public:
+
+        Affinity()
+            : mPolicy( AffinityPolicy::Environment )
+        {
+        }
+
+        /**
+         * Sets the placement policy for the next computations.
+         *
+         * @param   policy The policy.
+         *
+         * @pre policy != Explicit, use SetCpus instead.
+         */
+
+        void SetPolicy( AffinityPolicy policy )
+        {
+            mPolicy = policy;
+        }
+
+        /**
+         * Places the processors on the given logical processors, in order. When there are more processors than
+         * entries, the list is repeated.
+         *
+         * @param   cpus The logical processor identifiers.
+         */
+
+        void SetCpus( const std::vector< uint32_t > &cpus )
+        {
+            mPolicy = cpus.empty() ? AffinityPolicy::None : AffinityPolicy::Explicit;
+            mCpus = cpus;
+        }
+
+        AffinityPolicy GetPolicy() const
+        {
+            return mPolicy;
+        }
+
+        /**
+         * Computes the logical processor for each of the given processors.
+         *
+         * @param   nProcs The amount of processors.
+         *
+         * @return For each processor the logical processor to pin on, or -1 when it should not be pinned.
+         */
+
+        std::vector< int32_t > Map( uint32_t nProcs ) const
+        {
+            AffinityPolicy policy = mPolicy;
+            std::vector< uint32_t > cpus = mCpus;
+
+            if ( policy == AffinityPolicy::Environment )
+            {
+                const char *value = std::getenv( "BSP_AFFINITY" );
+                policy = Parse( value ? value : "", cpus );
+            }
+
+            const Topology &topology = Topology::GetInstance();
+
+            switch ( policy )
+            {
+            case AffinityPolicy::Compact:
+                cpus = topology.GetCompactOrder();
+                break;
+
+            case AffinityPolicy::Scatter:
+                cpus = topology.GetScatterOrder();
+                break;
+
+            case AffinityPolicy::Explicit:
+                break;
+
+            default:
+                cpus.clear();
+                break;
+            }
+
+            std::vector< int32_t > mapping( nProcs, -1 );
+
+            if ( !cpus.empty() )
+            {
+                for ( uint32_t pid = 0; pid < nProcs; ++pid )
+                {
+                    mapping[pid] = static_cast< int32_t >( cpus[pid % cpus.size()] );
+                }
+            }
+
+            return mapping;
+        }
+
+        /**
+         * Parses a placement description as accepted in the `BSP_AFFINITY` environment variable; either `none`,
+         * `compact`, `scatter` or a list of logical processors such as `0,2,4-7`.
+         *
+         * @param   value       The description.
+         * @param [in,out]  cpus The parsed logical processors, when the description is a list.
+         *
+         * @return The described policy, None if the description could not be parsed.
+         */
+
+        static AffinityPolicy Parse( const std::string &value, std::vector< uint32_t > &cpus )
+        {
+            cpus.clear();
+
+            if ( value == "compact" )
+            {
+                return AffinityPolicy::Compact;
+            }
+
+            if ( value == "scatter" )
+            {
+                return AffinityPolicy::Scatter;
+            }
+
+            const char *cursor = value.c_str();
+
+            while ( *cursor )
+            {
+                char *end;
+                const unsigned long first = std::strtoul( cursor, &end, 10 );
+                unsigned long last = first;
+
+                if ( end == cursor )
+                {
+                    cpus.clear();
+                    return AffinityPolicy::None;
+                }
+
+                cursor = end;
+
+                if ( *cursor == '-' )
+                {
+                    last = std::strtoul( ++cursor, &end, 10 );
+
+                    if ( end == cursor || last < first )
+                    {
+                        cpus.clear();
+                        return AffinityPolicy::None;
+                    }
+
+                    cursor = end;
+                }
+
+                for ( unsigned long cpu = first; cpu <= last; ++cpu )
+                {
+                    cpus.push_back( static_cast< uint32_t >( cpu ) );
+                }
+
+                if ( *cursor == ',' )
+                {
+                    ++cursor;
+                }
+                else if ( *cursor )
+                {
+                    cpus.clear();
+                    return AffinityPolicy::None;
+                }
+            }
+
+            return cpus.empty() ? AffinityPolicy::None : AffinityPolicy::Explicit;
+        }
+
+        /**
+         * Pins the calling thread on the given logical processor.
+         *
+         * @param   cpu The logical processor, or -1 to leave the thread unpinned.
+         *
+         * @return The logical processor the thread is pinned on, or -1 when the thread is not pinned.
+         */
+
+        static int32_t PinCurrentThread( int32_t cpu )
+        {
+#ifdef __linux__
+
+            if ( cpu >= 0 && cpu < CPU_SETSIZE )
+            {
+                cpu_set_t mask;
+                CPU_ZERO( &mask );
+                CPU_SET( cpu, &mask );
+
+                if ( pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &mask ) == 0 )
+                {
+                    return cpu;
+                }
+            }
+
+#else
+            ( void )cpu;
+#endif
+            return -1;
+        }
+
+        /**
+         * Saves the affinity of the calling thread.
+         *
+         * @return The saved affinity.
+         */
+
+        static ThreadMask SaveCurrentThread()
+        {
+            ThreadMask saved;
+#ifdef __linux__
+            saved.valid = pthread_getaffinity_np( pthread_self(), sizeof( cpu_set_t ), &saved.mask ) == 0;
+#else
+            saved.valid = false;
+#endif
+            return saved;
+        }
+
+        /**
+         * Restores a previously saved affinity of the calling thread.
+         *
+         * @param   saved The saved affinity.
+         */
+
+        static void RestoreCurrentThread( const ThreadMask &saved )
+        {
+#ifdef __linux__
+
+            if ( saved.valid )
+            {
+                pthread_setaffinity_np( pthread_self(), sizeof( cpu_set_t ), &saved.mask );
+            }
+
+#else
+            ( void )saved;
+#endif
+        }
+
+    private:
+
+        AffinityPolicy mPolicy;
+        std::vector< uint32_t > mCpus;
+    };
+}
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_ALLTOALL_H__
+#define __BSPLIB_ALLTOALL_H__
+
+#include "bsp/group.h"
+
+#include <cstring>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * Exchanges arrays between all members of a group, in one exchange superstep. Every receiver copies the arrays
+     * straight from the senders, ordered by sender, so no member needs the counts of the others and the memory and
+     * traffic per member stay linear in the group size.
+     *
+     * @param   sources                 The array for every receiver, by rank.
+     * @param   counts                  The amount of elements for every receiver, by rank.
+     * @param [out]  received           The received elements, in rank order of the senders.
+     * @param [out]  receivedCounts     The amount of elements received from every sender, by rank.
+     * @param   collective              The collective state.
+     */
+
+    template< typename tPrimitive >
+    void AllToAllv( const tPrimitive *const *sources, const size_t *counts, std::vector< tPrimitive > &received,
+                    std::vector< size_t > &receivedCounts, Collective &collective )
+    {
+        const uint32_t size = collective.Size();
+
+        for ( uint32_t r = 0; r < size; ++r )
+        {
+            collective.ExchangeSpan( r, sources[r], counts[r] * sizeof( tPrimitive ) );
+        }
+
+        std::vector< char > bytes;
+        std::vector< size_t > offsets;
+        collective.Exchange( bytes, offsets );
+
+        // the ranks are ordered like the processor IDs, so the bytes of the members are in rank order
+        size_t total = 0;
+        receivedCounts.resize( size );
+
+        for ( uint32_t s = 0; s < size; ++s )
+        {
+            const uint32_t pid = collective.Pid( s );
+            receivedCounts[s] = ( offsets[pid + 1] - offsets[pid] ) / sizeof( tPrimitive );
+            total += receivedCounts[s];
+        }
+
+        received.resize( total );
+        tPrimitive *destination = received.data();
+
+        for ( uint32_t s = 0; s < size; ++s )
+        {
+            const uint32_t pid = collective.Pid( s );
+
+            if ( receivedCounts[s] > 0 )
+            {
+                memcpy( destination, bytes.data() + offsets[pid], receivedCounts[s] * sizeof( tPrimitive ) );
+                destination += receivedCounts[s];
+            }
+        }
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Exchanges variable amounts of elements between all members of the group, in one superstep. The receivers need
+     * not know how much they receive.
+     *
+     * @param   send                The elements to send, grouped by receiver in rank order.
+     * @param   sendCounts          The amount of elements for every receiver, by rank.
+     * @param [out]  received       The received elements, grouped by sender in rank order.
+     * @param [out]  receivedCounts The amount of elements received from every sender, by rank.
+     * @param   group               The group.
+     */
+
+    template< typename tPrimitive >
+    void AllToAllvPtrs( const tPrimitive *send, const size_t *sendCounts, std::vector< tPrimitive > &received,
+                        std::vector< size_t > &receivedCounts, const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        std::vector< const tPrimitive * > sources( collective.Size() );
+
+        for ( uint32_t r = 0; r < collective.Size(); ++r )
+        {
+            sources[r] = send;
+            send += sendCounts[r];
+        }
+
+        BspInternal::AllToAllv( sources.data(), sendCounts, received, receivedCounts, collective );
+    }
+
+    /**
+     * Exchanges variable amounts of elements between all members of the group, in one superstep.
+     *
+     * @param   send                The elements for every receiver, by rank.
+     * @param [out]  received       The elements received from every sender, by rank.
+     * @param   group               The group.
+     *
+     * @pre send.size() == group.Size().
+     */
+
+    template< typename tPrimitive >
+    void AllToAllv( const std::vector< std::vector< tPrimitive > > &send,
+                    std::vector< std::vector< tPrimitive > > &received, const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        const uint32_t size = collective.Size();
+
+#ifndef BSP_SKIP_CHECKS
+        assert( send.size() == size );
+#endif
+
+        std::vector< const tPrimitive * > sources( size );
+        std::vector< size_t > counts( size );
+
+        for ( uint32_t r = 0; r < size; ++r )
+        {
+            sources[r] = send[r].data();
+            counts[r] = send[r].size();
+        }
+
+        std::vector< tPrimitive > flat;
+        std::vector< size_t > receivedCounts;
+        BspInternal::AllToAllv( sources.data(), counts.data(), flat, receivedCounts, collective );
+
+        BspInternal::Split( flat, receivedCounts, received );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
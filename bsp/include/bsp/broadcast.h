@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_BROADCAST_H__
+#define __BSPLIB_BROADCAST_H__
+
+#include "bsp/group.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/// Broadcasts of which the root sends at most this amount of bytes in total are done in one superstep.
+#ifndef BSP_BROADCAST_ONE_PHASE_BYTES
+#   define BSP_BROADCAST_ONE_PHASE_BYTES 65536
+#endif
+
+/// Broadcasts of which every member would forward at least this amount of bytes are done in two phases.
+#ifndef BSP_BROADCAST_TWO_PHASE_BLOCK
+#   define BSP_BROADCAST_TWO_PHASE_BLOCK 1024
+#endif
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    enum class BroadcastAlgorithm
+    {
+        /// Chooses the algorithm by the message size and the group size.
+        Automatic,
+        /// The root puts the message to every member, in one superstep.
+        OnePhase,
+        /// The root scatters the message in blocks, and every member puts its block to all others, in two supersteps.
+        TwoPhase,
+        /// Every member that has the message puts it to one new member per superstep, in log2( size ) supersteps.
+        Tree
+    };
+
+    /**
+     * Chooses the broadcast algorithm. A small message goes in one superstep, a large message in two phases so that
+     * every member sends about the message size, and a message that is too small to split over a large group goes
+     * down a binomial tree.
+     *
+     * @param   size   The group size.
+     * @param   nbytes The message size in bytes.
+     *
+     * @return The algorithm.
+     */
+
+    inline BroadcastAlgorithm ChooseBroadcast( uint32_t size, size_t nbytes )
+    {
+        if ( size <= 2 || static_cast< uint64_t >( size - 1 ) * nbytes <= BSP_BROADCAST_ONE_PHASE_BYTES )
+        {
+            return BroadcastAlgorithm::OnePhase;
+        }
+
+        if ( nbytes / size >= BSP_BROADCAST_TWO_PHASE_BLOCK )
+        {
+            return BroadcastAlgorithm::TwoPhase;
+        }
+
+        return BroadcastAlgorithm::Tree;
+    }
+
+    /**
+     * Broadcasts bytes from the root to all members of the group. All members call it with the same size and
+     * algorithm.
+     *
+     * @param [in,out]  buffer The message on the root, the destination on the other members.
+     * @param   nbytes         The message size in bytes.
+     * @param   root           The processor ID of the root.
+     * @param   group          The group.
+     * @param   algorithm      The algorithm.
+     *
+     * @pre root is a member of the group.
+     *
+     * @post Every member has the message in its buffer.
+     */
+
+    inline void BroadcastBytes( void *buffer, size_t nbytes, uint32_t root, const Group &group = Group(),
+                                BroadcastAlgorithm algorithm = BroadcastAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        const uint32_t size = collective.Size();
+        const uint32_t rootRank = group.Rank( root );
+        const uint32_t relative = ( collective.Rank() + size - rootRank ) % size;
+
+        if ( algorithm == BroadcastAlgorithm::Automatic )
+        {
+            algorithm = ChooseBroadcast( size, nbytes );
+        }
+
+        collective.Receive( buffer );
+
+        switch ( algorithm )
+        {
+        case BroadcastAlgorithm::TwoPhase:
+            {
+                const size_t block = ( nbytes + size - 1 ) / size;
+                const size_t begin = std::min( nbytes, relative * block );
+                const size_t end = std::min( nbytes, begin + block );
+
+                if ( relative == 0 )
+                {
+                    for ( uint32_t i = 1; i < size; ++i )
+                    {
+                        const size_t offset = std::min( nbytes, i * block );
+                        collective.Put( ( rootRank + i ) % size, static_cast< char * >( buffer ) + offset, offset,
+                                        std::min( nbytes, offset + block ) - offset );
+                    }
+                }
+
+                collective.Sync();
+
+                // the root already has the whole message
+                for ( uint32_t i = 1; i < size; ++i )
+                {
+                    if ( i != relative )
+                    {
+                        collective.Put( ( rootRank + i ) % size, static_cast< char * >( buffer ) + begin, begin, end - begin );
+                    }
+                }
+
+                collective.Sync();
+            }
+            break;
+
+        case BroadcastAlgorithm::Tree:
+            for ( uint32_t mask = 1; mask < size; mask <<= 1 )
+            {
+                if ( relative < mask && relative + mask < size )
+                {
+                    collective.Put( ( rootRank + relative + mask ) % size, buffer, 0, nbytes );
+                }
+
+                collective.Sync();
+            }
+
+            break;
+
+        default:
+            if ( relative == 0 )
+            {
+                for ( uint32_t i = 1; i < size; ++i )
+                {
+                    collective.Put( ( rootRank + i ) % size, buffer, 0, nbytes );
+                }
+            }
+
+            collective.Sync();
+            break;
+        }
+    }
+
+    /**
+     * Broadcasts a value from the root to all members of the group.
+     *
+     * @param [in,out]  value The value on the root, the destination on the other members.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void Broadcast( tPrimitive &value, uint32_t root = 0, const Group &group = Group() )
+    {
+        BroadcastBytes( &value, sizeof( tPrimitive ), root, group );
+    }
+
+    /**
+     * Broadcasts an array from the root to all members of the group.
+     *
+     * @param [in,out]  begin The array on the root, the destination on the other members.
+     * @param   count         The amount of elements, equal on all members.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive >
+    void BroadcastPtrs( tPrimitive *begin, size_t count, uint32_t root = 0, const Group &group = Group(),
+                        BroadcastAlgorithm algorithm = BroadcastAlgorithm::Automatic )
+    {
+        BroadcastBytes( begin, count * sizeof( tPrimitive ), root, group, algorithm );
+    }
+
+    /**
+     * Broadcasts a vector from the root to all members of the group. The other members need not know its size, which
+     * costs an extra superstep.
+     *
+     * @param [in,out]  values The values on the root, resized and overwritten on the other members.
+     * @param   root           The processor ID of the root.
+     * @param   group          The group.
+     */
+
+    template< typename tPrimitive >
+    void Broadcast( std::vector< tPrimitive > &values, uint32_t root = 0, const Group &group = Group() )
+    {
+        uint64_t count = values.size();
+        Broadcast( count, root, group );
+
+        values.resize( static_cast< size_t >( count ) );
+        BroadcastPtrs( values.data(), values.size(), root, group );
+    }
+
+    /**
+     * Broadcasts a string from the root to all members of the group. The other members need not know its size, which
+     * costs an extra superstep.
+     *
+     * @param [in,out]  string The string on the root, resized and overwritten on the other members.
+     * @param   root           The processor ID of the root.
+     * @param   group          The group.
+     */
+
+    inline void Broadcast( std::string &string, uint32_t root = 0, const Group &group = Group() )
+    {
+        uint64_t count = string.size();
+        Broadcast( count, root, group );
+
+        string.resize( static_cast< size_t >( count ) );
+        BroadcastPtrs( &string[0], string.size(), root, group );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -28,6 +28,21 @@
 #endif
 
 #include "bsp/bspExt.h"
+#include "bsp/processor.h"
+#include "bsp/context.h"
+#include "bsp/multiBSP.h"
+#include "bsp/replay.h"
+#include "bsp/broadcast.h"
+#include "bsp/reduce.h"
+#include "bsp/scan.h"
+#include "bsp/allToAll.h"
+#include "bsp/gather.h"
+#include "bsp/exchange.h"
+#include "bsp/sort.h"
+#include "bsp/distributedArray.h"
+#include "bsp/channel.h"
+#include "bsp/future.h"
+#include "bsp/slot.h"
 
 #ifndef BSP_DISABLE_NAMESPACE
 #   define BSP_FULL_NAMESPACE BSP_NAMESPACE::Classic
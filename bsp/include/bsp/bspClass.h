@@ -26,17 +26,33 @@
 #define BSP_SKIP_CHECKS
 
 #include "bsp/communicationQueues.h"
+#include "bsp/affinity.h"
+#include "bsp/fiberScheduler.h"
+#include "bsp/hierarchy.h"
+#include "bsp/profiler.h"
+#include "bsp/costModel.h"
+#include "bsp/communicationMatrix.h"
+#include "bsp/recorder.h"
+#include "bsp/skewHistogram.h"
 #include "bsp/condVarBarrier.h"
 #include "bsp/mixedBarrier.h"
 #include "bsp/requests.h"
 #include "bsp/barrier.h"
 
+#include <array>
 #include <assert.h>
 #include <iterator>
 #include <map>
 #include <stdarg.h>
 #include <chrono>
 #include <future>
+#include <thread>
+#include <type_traits>
+
+/// The time in milliseconds the threads of an aborted program get to stop, before the program is terminated.
+#ifndef BSP_ABORT_TIMEOUT
+#   define BSP_ABORT_TIMEOUT 20000
+#endif
 
 // forward declaration of the main function
 // so we can start this if no other function is given.
@@ -45,13 +61,31 @@ extern int main( int argc, char **argv );
 
 /**
  * The BSP implementation class. By using this class as singleton, we avoid global memory declarations, cross source
- * problems with static variables and ensure proper usage from a header only library.
+ * problems with static variables and ensure proper usage from a header only library. Additional instances can be
+ * created to run independent computations side by side, see BSPLib::Context.
  */
 
 class BSP
 {
+    struct ProcessorData;
+
 public:
 
+    /**
+     * The state of one processor, cached by BSPLib::Processor so that its operations skip the lookups of the
+     * processor ID, the processor data and the communication queues. The queues are looked up on first use.
+     */
+
+    struct Local
+    {
+        uint32_t pid;
+        ProcessorData *data;
+        std::vector< BspInternal::PutRequest > *putQueues;
+        std::vector< BspInternal::GetRequest > *getQueues;
+        std::vector< BspInternal::SendRequest > *sendQueues;
+        BspInternal::StackAllocator *sendBuffers;
+    };
+
     /**
      * Aborts the BSP program with the given error message. The formatting used is the same as in
      * fprintf.
@@ -191,6 +225,366 @@ public:
         return diff.count();
     }
 
+    /**
+     * Sets the policy that determines on which logical processor each processor is pinned, for the computations
+     * started after this call. By default the policy is read from the `BSP_AFFINITY` environment variable.
+     *
+     * @param   policy The placement policy.
+     */
+
+    void SetAffinity( BspInternal::AffinityPolicy policy )
+    {
+        mAffinity.SetPolicy( policy );
+    }
+
+    /**
+     * Pins the processors on the given logical processors, for the computations started after this call. Processor
+     * `pid` is pinned on `cpus[pid % cpus.size()]`.
+     *
+     * @param   cpus The logical processor identifiers, an empty list disables pinning.
+     */
+
+    void SetAffinity( const std::vector< uint32_t > &cpus )
+    {
+        mAffinity.SetCpus( cpus );
+    }
+
+    /**
+     * Gets the logical processor the processor with the given ID is pinned on.
+     *
+     * @param   pid The processor ID.
+     *
+     * @return The logical processor, or -1 when the processor is not pinned.
+     *
+     * @pre Begin has been called.
+     */
+
+    int32_t GetAffinity( uint32_t pid ) const
+    {
+        return pid < mProcessorsData.size() ? mProcessorsData[pid].cpu : -1;
+    }
+
+    /**
+     * Sets the amount of worker threads that run the processors, for the computations started after this call. When
+     * there are more processors than workers, the processors are multiplexed as fibers on the workers, and a
+     * synchronisation point switches between fibers instead of waiting on the operating system. By default the
+     * amount is read from the `BSP_WORKERS` environment variable.
+     *
+     * @param   count The amount of workers, 0 to use one thread per processor.
+     */
+
+    void SetWorkers( uint32_t count )
+    {
+        mWorkerCount = count;
+    }
+
+    /**
+     * Gets the amount of worker threads running the processors.
+     *
+     * @return The amount of workers.
+     *
+     * @pre Begin has been called.
+     */
+
+    uint32_t GetWorkers() const
+    {
+        return mFiberMode ? mActiveWorkers : mProcCount;
+    }
+
+    /**
+     * Enables the profiler for the computations started after this call. Per superstep and processor, the compute
+     * time, barrier wait time, delivery time and communication volume are recorded, and written at the end of the
+     * computation to `prefix.json` as a Chrome trace and to `prefix.csv` as a summary. By default the prefix is read
+     * from the `BSP_PROFILE` environment variable.
+     *
+     * @param   prefix The path prefix of the output files, an empty prefix to use the environment.
+     */
+
+    void SetProfile( const std::string &prefix )
+    {
+        mProfilePrefix = prefix;
+    }
+
+    /**
+     * Enables the cost model for the computations started after this call. Every superstep is compared with the
+     * prediction ( h g + l ) / r of the BSP cost model, using the machine parameters measured by bspbench, and the
+     * supersteps that take more than `tolerance` times the prediction are reported at the end of the computation. By
+     * default the paths are read from the `BSP_COST_MODEL` and `BSP_COST_REPORT` environment variables, and the
+     * tolerance from `BSP_COST_TOLERANCE`.
+     *
+     * @param   paramsPath The path of the machine parameters, an empty path to use the environment.
+     * @param   reportPath The path of the report, an empty path to use the environment or stderr.
+     * @param   tolerance  The ratio of measured to predicted time above which a superstep is reported, zero to use
+     *                     the environment or 2.
+     */
+
+    void SetCostModel( const std::string &paramsPath, const std::string &reportPath = "", double tolerance = 0.0 )
+    {
+        mCostParamsPath = paramsPath;
+        mCostReportPath = reportPath;
+        mCostTolerance = tolerance;
+    }
+
+    /**
+     * Enables the communication matrix for the computations started after this call. At every synchronisation the
+     * messages and bytes that each processor puts, gets and sends to each other processor are added up, and at the
+     * end of the computation the non empty cells are written to `path` as CSV. By default the path is read from the
+     * `BSP_COMM_MATRIX` environment variable.
+     *
+     * @param   path The path of the output file, an empty path to use the environment.
+     */
+
+    void SetCommunicationMatrix( const std::string &path )
+    {
+        mCommMatrixPath = path;
+    }
+
+    /**
+     * Enables recording for the computations started after this call. At every synchronisation the registrations,
+     * tag size changes, and the destinations, offsets and sizes of the puts, gets and sends of every processor are
+     * recorded, without their payloads. At the end of the computation the recording is written to `path`, and can be
+     * replayed with BSPLib::Replay. By default the path is read from the `BSP_RECORD` environment variable.
+     *
+     * @param   path The path of the output file, an empty path to use the environment.
+     */
+
+    void SetRecord( const std::string &path )
+    {
+        mRecordPath = path;
+    }
+
+    /**
+     * Enables the arrival skew histograms for the computations started after this call. At every synchronisation each
+     * processor records how long before the last processor it arrived, which shows the load imbalance of the
+     * supersteps. At the end of the computation the histograms are written to `reportPath` as CSV. By default the
+     * report path is read from the `BSP_SKEW_REPORT` environment variable, which also enables the histograms.
+     *
+     * @param   enabled    Whether to record the histograms, for GetSkewHistograms.
+     * @param   reportPath The path of the report, an empty path to use the environment.
+     */
+
+    void SetSkewHistograms( bool enabled, const std::string &reportPath = "" )
+    {
+        mSkewEnabled = enabled;
+        mSkewReportPath = reportPath;
+    }
+
+    /**
+     * Sets the suffix of the output files of which the paths are read from the environment, so that computations
+     * running side by side in different instances do not overwrite each other's files. The suffix is inserted before
+     * the extension of the file. Explicitly set paths are used as given.
+     *
+     * @param   suffix The suffix, empty for the default instance.
+     */
+
+    void SetOutputSuffix( const std::string &suffix )
+    {
+        mOutputSuffix = suffix;
+    }
+
+    /**
+     * Inserts a suffix in a path, before the extension of the file when it has one.
+     *
+     * @param   path   The path, which is returned unchanged when empty.
+     * @param   suffix The suffix.
+     *
+     * @return The path with the suffix.
+     */
+
+    static std::string InsertSuffix( const std::string &path, const std::string &suffix )
+    {
+        if ( path.empty() || suffix.empty() )
+        {
+            return path;
+        }
+
+        const size_t dot = path.find_last_of( '.' );
+        const size_t separator = path.find_last_of( "/\\" );
+
+        if ( dot == std::string::npos || dot == 0 || ( separator != std::string::npos && dot <= separator + 1 ) )
+        {
+            return path + suffix;
+        }
+
+        return path.substr( 0, dot ) + suffix + path.substr( dot );
+    }
+
+    /**
+     * Gets the arrival skew histograms of every processor of the last computation.
+     *
+     * @return The histograms, empty when they were not enabled.
+     *
+     * @pre The computation has ended.
+     */
+
+    std::vector< BspInternal::SkewHistogram > GetSkewHistograms() const
+    {
+        return mArrivalSkew.GetHistograms();
+    }
+
+    /**
+     * Sets the MultiBSP levels for the computations started after this call. Level 0 is the whole machine, and every
+     * next level splits each group of the previous level into `fanouts[level]` groups of consecutive processors. By
+     * default the levels follow the packages the threads are pinned on: machine, package and core.
+     *
+     * @param   fanouts The fanout per level, an empty list to use the topology.
+     *
+     * @pre The product of the fanouts equals the amount of processors of the next computation.
+     */
+
+    void SetFanouts( const std::vector< uint32_t > &fanouts )
+    {
+        mFanouts = fanouts;
+    }
+
+    /**
+     * Gets the amount of MultiBSP levels, including the machine and processor levels.
+     *
+     * @return The amount of levels.
+     *
+     * @pre Begin has been called.
+     */
+
+    uint32_t GetLevelCount() const
+    {
+        return mHierarchy.GetLevelCount();
+    }
+
+    /**
+     * Gets the amount of processors in the group of the current processor on the given level.
+     *
+     * @param   level The level.
+     *
+     * @return The group size.
+     */
+
+    uint32_t GetGroupSize( uint32_t level ) const
+    {
+        return mHierarchy.GetGroupSize( level );
+    }
+
+    /**
+     * Gets the index of the group of the current processor on the given level.
+     *
+     * @param   level The level.
+     *
+     * @return The group index.
+     */
+
+    uint32_t GetGroupId( uint32_t level )
+    {
+        return mHierarchy.GetGroupId( level, ProcId() );
+    }
+
+    /**
+     * Gets the ID of the current processor within its group on the given level, which lies between 0 and
+     * GetGroupSize( level ) - 1.
+     *
+     * @param   level The level.
+     *
+     * @return The ID within the group.
+     */
+
+    uint32_t GetGroupPid( uint32_t level )
+    {
+        return mHierarchy.GetGroupPid( level, ProcId() );
+    }
+
+    /**
+     * Puts a buffer in a register of a member of the group of the current processor on the given level. The buffer is
+     * delivered on the next synchronisation of a group that holds both processors, at the latest on the next
+     * synchronisation of the given level.
+     *
+     * @param   level       The level.
+     * @param   groupPid    The ID of the destination within the group.
+     * @param   src         Source to write to the other processor.
+     * @param [in,out]  dst The register to write in.
+     * @param   offset      The offset from the register to write at.
+     * @param   nbytes      The size of the buffer in bytes.
+     *
+     * @pre
+     * * Begin has been called.
+     * * dst has been registered.
+     */
+
+    BSP_FORCEINLINE void GroupPut( uint32_t level, uint32_t groupPid, const void *src, void *dst, ptrdiff_t offset,
+                                   size_t nbytes )
+    {
+        uint32_t &tpid = ProcId();
+        const uint32_t pid = mHierarchy.GetPid( level, tpid, groupPid );
+
+        // lets a synchronisation of the whole machine deliver the buffer as well
+        mHasPutRequests[mProcessorsData[tpid].syncBoolIndex] = true;
+
+        if ( mRecorder.IsEnabled() )
+        {
+            mRecorder.UseGroups();
+        }
+
+#ifndef BSP_SKIP_CHECKS
+        assert( src && dst );
+#endif
+
+        const size_t globalId = LocalToGlobal( tpid, dst );
+
+#ifndef BSP_SKIP_CHECKS
+        assert( mProcessorsData[pid].threadRegisterLocation.size() > globalId );
+        assert( mProcessorsData[pid].registers[GlobalToLocal( pid, globalId )].size >= offset + nbytes );
+#endif
+
+        ptrdiff_t bufferLocation = mGroupPutBuffers.GetQueueFromMe( pid, tpid ).Alloc( nbytes,
+                                                                                          reinterpret_cast<const char *>( src ) );
+
+        mGroupPutRequests.GetQueueFromMe( pid, tpid ).emplace_back( BspInternal::PutRequest{ bufferLocation, nullptr, globalId, offset, nbytes } );
+    }
+
+    /**
+     * Synchronises the group of the current processor on the given level, and delivers the buffers put within the
+     * group. Level 0 synchronises the whole machine, as Sync does.
+     *
+     * @param   level The level.
+     *
+     * @pre
+     * * Begin has been called.
+     * * All members of the group call GroupSync with the same level.
+     * * For levels larger than 0, the processors run one per thread.
+     */
+
+    void GroupSync( uint32_t level )
+    {
+        if ( level == 0 )
+        {
+            Sync();
+            return;
+        }
+
+        CheckAborted();
+
+        if ( mFiberMode )
+        {
+            Abort( "Error: group synchronisation is not supported when processors run as fibers.\n" );
+        }
+
+        if ( mRecorder.IsEnabled() )
+        {
+            mRecorder.UseGroups();
+        }
+
+        const uint32_t pid = ProcId();
+
+        mHierarchy.Wait( level, pid, mAbort );
+
+        const uint32_t groupSize = mHierarchy.GetGroupSize( level );
+        const uint32_t first = mHierarchy.GetPid( level, pid, 0 );
+
+        for ( uint32_t owner = first; owner < first + groupSize; ++owner )
+        {
+            ProcessGroupPutRequests( owner, pid );
+        }
+
+        mHierarchy.Wait( level, pid, mAbort );
+    }
+
     /**
      * Initialises the BSP computation process. Please note that the main thread should also call the entry function.
      *
@@ -198,9 +592,10 @@ public:
      *
      * @pre
      *  * If the previous BSP program was terminated using Abort or VAbort:
-     *      * BSPLib will try to end the previous BSP program by notifying all threads that are stuck in a
-     *        synchronisation about the previous abort.
-     *      * After 100 failed tries, the entire program will be terminated by std::terminate().
+     *      * BSPLib will end the previous BSP program by waking all threads that are stuck in a
+     *        synchronisation, and waits for all threads to stop.
+     *      * When the threads have not stopped within BSP_ABORT_TIMEOUT milliseconds, the entire program will be
+     *        terminated by std::terminate().
      *
      * @post
      *  * The previous BSP program has successfully been ended or aborted.
@@ -231,6 +626,18 @@ public:
 #   endif
 #endif
 
+            // wakes every processor that sleeps in a barrier, the others notice the abort on their next call
+            NotifyAbort();
+
+            if ( mFiberMode )
+            {
+                // the processors sharing the main thread can only finish on the main thread
+                mFibers.Exit( 0 );
+            }
+
+            const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() +
+                                                                   std::chrono::milliseconds( BSP_ABORT_TIMEOUT );
+
             for ( auto &thr : mThreads )
             {
 #ifndef BSP_SUPPRESS_ABORT_WARNING
@@ -238,14 +645,8 @@ public:
                 fprintf( stderr, "Determining the status of thread %d.\n", ++i );
 #   endif
 #endif
-                uint32_t count = 0;
 
-                while ( thr.wait_for( std::chrono::milliseconds( 200 ) ) == std::future_status::timeout && count++ < 100 )
-                {
-                    mThreadBarrier.NotifyAbort();
-                }
-
-                if ( count >= 100 )
+                if ( thr.wait_until( deadline ) == std::future_status::timeout )
                 {
                     fprintf( stderr, "Error: could not safely end the previous BSP program. Terminating now." );
                     std::terminate();
@@ -259,6 +660,11 @@ public:
 #endif
                 }
             }
+
+            mThreads.clear();
+
+            // the aborted program never reached End
+            RestoreMainThread();
         }
 
         ProcId() = 0;
@@ -329,50 +735,147 @@ public:
 
         mThreadBarrier.SetSize( maxProcs );
 
-        mThreads.clear();
-        mThreads.reserve( maxProcs );
+        mGroupPutRequests.ResetResize( maxProcs );
+        mGroupPutBuffers.ResetResize( maxProcs );
+        mExchangeRequests.ResetResize( maxProcs );
 
-        for ( uint32_t i = 1; i < mProcCount; ++i )
-        {
-            mThreads.emplace_back( std::async( std::launch::async, [this]( uint32_t pid )
-            {
-                ProcId() = pid;
+        mCostModel.Reset( maxProcs, mCostParamsPath.empty() ? EnvironmentString( "BSP_COST_MODEL" ) : mCostParamsPath,
+                          mCostReportPath.empty() ? EnvironmentOutput( "BSP_COST_REPORT" ) : mCostReportPath,
+                          mCostTolerance > 0.0 ? mCostTolerance : EnvironmentTolerance() );
+        mCommMatrix.Reset( maxProcs, mCommMatrixPath.empty() ? EnvironmentOutput( "BSP_COMM_MATRIX" ) : mCommMatrixPath );
+        mRecorder.Reset( maxProcs, mRecordPath.empty() ? EnvironmentOutput( "BSP_RECORD" ) : mRecordPath );
+        mArrivalSkew.Reset( maxProcs, mSkewEnabled,
+                            mSkewReportPath.empty() ? EnvironmentOutput( "BSP_SKEW_REPORT" ) : mSkewReportPath );
+        mProfiler.Reset( maxProcs, mProfilePrefix.empty() ? EnvironmentPrefix( "BSP_PROFILE" ) : mProfilePrefix,
+                         mCostModel.IsEnabled() );
 
-                try
-                {
-                    mEntry();
-                }
-                catch ( BspInternal::BspAbort & )
-                {
+        const uint32_t workers = mWorkerCount > 0 ? mWorkerCount : EnvironmentWorkers();
+        mFiberMode = workers > 0 && workers < maxProcs;
+        mActiveWorkers = mFiberMode ? workers : maxProcs;
 
-                }
-            }, i ) );
-        }
+        mCpuMapping = mAffinity.Map( mActiveWorkers );
 
-        StartTiming();
-    }
+        // the package level follows where the threads are pinned, fibers and unpinned threads get no package level
+        if ( mFanouts.empty() )
+        {
+            const std::vector< int32_t > packages = mFiberMode ? std::vector< int32_t >( maxProcs, -1 ) :
+                                                    BspInternal::Hierarchy::GetPackages( mCpuMapping );
+            mHierarchy.Reset( maxProcs, BspInternal::Hierarchy::DefaultFanouts( packages ) );
+        }
+        else
+        {
+            mHierarchy.Reset( maxProcs, mFanouts );
+        }
 
-    /**
-     * Ends the BSP computation.
-     *
-     * @pre Begin has been called
-     *
-     * @post
-     *  * Ended is true
-     *  * All threads have synced and ended.
-     *  * The main thread releases all threads.
-     */
+        if ( mCpuMapping[0] >= 0 )
+        {
+            // a mask that is still pending belongs to the caller, the current one may be our own pinning
+            if ( !mMainThreadMask.valid )
+            {
+                mMainThreadMask = BspInternal::Affinity::SaveCurrentThread();
+            }
 
-    void End()
-    {
-        mEnded = true;
+            mProcessorsData[0].cpu = BspInternal::Affinity::PinCurrentThread( mCpuMapping[0] );
+        }
 
-        SyncPoint();
+        mThreads.clear();
 
-        if ( ProcId() == 0 )
+        if ( mFiberMode )
         {
+            mFibers.Reset( maxProcs, workers, [this]
+            {
+                RunEntry();
+            } );
+
+            for ( uint32_t pid : mFibers.GetProcessors( 0 ) )
+            {
+                mProcessorsData[pid].cpu = mProcessorsData[0].cpu;
+            }
+
+            mThreads.reserve( workers );
+
+            for ( uint32_t i = 1; i < workers; ++i )
+            {
+                mThreads.emplace_back( std::async( std::launch::async, [this]( uint32_t worker )
+                {
+                    const int32_t cpu = BspInternal::Affinity::PinCurrentThread( mCpuMapping[worker] );
+
+                    for ( uint32_t pid : mFibers.GetProcessors( worker ) )
+                    {
+                        mProcessorsData[pid].cpu = cpu;
+                    }
+
+                    Current() = this;
+                    mFibers.StartWorker( worker, &ProcId() );
+                    const uint32_t pid = ProcId();
+
+                    RunEntry();
+
+                    mFibers.Exit( pid );
+                }, i ) );
+            }
+
+            mFibers.StartWorker( 0, &ProcId() );
+        }
+        else
+        {
+            mThreads.reserve( maxProcs );
+
+            for ( uint32_t i = 1; i < mProcCount; ++i )
+            {
+                mThreads.emplace_back( std::async( std::launch::async, [this]( uint32_t pid )
+                {
+                    Current() = this;
+                    ProcId() = pid;
+                    mProcessorsData[pid].cpu = BspInternal::Affinity::PinCurrentThread( mCpuMapping[pid] );
+
+                    RunEntry();
+                }, i ) );
+            }
+        }
+
+        StartTiming();
+    }
+
+    /**
+     * Ends the BSP computation.
+     *
+     * @pre Begin has been called
+     *
+     * @post
+     *  * Ended is true
+     *  * All threads have synced and ended.
+     *  * The main thread releases all threads.
+     */
+
+    void End()
+    {
+        mEnded = true;
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.EndRun( ProcId() );
+        }
+
+        ArrivalPoint();
+
+        if ( ProcId() == 0 )
+        {
+            if ( mFiberMode )
+            {
+                mFibers.Exit( 0 );
+            }
+
             mThreads.clear();
 
+            RestoreMainThread();
+
+            mProfiler.Export();
+            mCostModel.Report( mProfiler );
+            mCommMatrix.Export();
+            mRecorder.Export();
+            mArrivalSkew.Report();
+
             mProcCount = 0;
         }
     }
@@ -399,22 +902,45 @@ public:
         uint32_t &pid = ProcId();
         const size_t index = mProcessorsData[ProcId()].syncBoolIndex;
 
+        ++mProcessorsData[pid].superstep;
+
         mProcessorsData[ProcId()].syncBoolIndex = 1 - index;
 
         assert( index == 1 || index == 0 );
 
+        const bool profiling = mProfiler.IsEnabled();
+
+        if ( profiling )
+        {
+            mProfiler.BeginSync( pid );
+        }
+
+        if ( mCommMatrix.IsEnabled() )
+        {
+            // only this processor writes its queues until the barrier
+            mCommMatrix.Capture( pid, mPutRequests.TryGetQueuesFromMe( pid ), mGetRequests.TryGetQueuesFromMe( pid ),
+                                 mTmpSendRequests.TryGetQueuesFromMe( pid ), mGroupPutRequests.TryGetQueuesFromMe( pid ),
+                                 mExchangeRequests.TryGetQueuesFromMe( pid ) );
+        }
+
+        if ( mRecorder.IsEnabled() )
+        {
+            Record( pid );
+        }
+
         if ( pid == 0 )
         {
             ResetChangedBooleans();
         }
 
-        SyncPoint();
+        ArrivalPoint();
 
         const bool registersChanged = mRegistersChanged[index];
         const bool tagSizeChanged = mTagSizeChanged[index];
         const bool hasGetRequests = mHasGetRequests[index];
         const bool hasPutRequests = hasGetRequests || mHasPutRequests[index];
         const bool hasSendRequests = mHasSendRequests[index];
+        const bool hasExchangeRequests = mHasExchangeRequests[index];
 
         if ( tagSizeChanged && pid == 0 && mProcessorsData[0].newTagSize != mTagSize )
         {
@@ -446,7 +972,13 @@ public:
             ProcessPutRequests( pid );
         }
 
-        if ( hasPutRequests || hasSendRequests )
+        if ( hasExchangeRequests )
+        {
+            ProcessExchangeRequests( pid );
+        }
+
+        // the senders keep their exchanged spans alive until the receivers have copied them
+        if ( hasPutRequests || hasSendRequests || hasExchangeRequests )
         {
             SyncPoint();
         }
@@ -462,6 +994,11 @@ public:
         }
 
         SyncPoint();
+
+        if ( profiling )
+        {
+            mProfiler.EndSync( pid );
+        }
     }
 
     /**
@@ -479,15 +1016,20 @@ public:
 
     BSP_FORCEINLINE void PushReg( const void *ident, size_t size )
     {
-        uint32_t &pid = ProcId();
-        mRegistersChanged[mProcessorsData[pid].syncBoolIndex] = true;
+        Local local = GetLocal( ProcId() );
+        PushReg( local, ident, size );
+    }
+
+    BSP_FORCEINLINE void PushReg( Local &local, const void *ident, size_t size )
+    {
+        ProcessorData &data = *local.data;
+        mRegistersChanged[data.syncBoolIndex] = true;
 
 #ifndef BSP_SKIP_CHECKS
-        assert( pid < mProcCount );
-        assert( mProcessorsData.size() > pid );
+        assert( local.pid < mProcCount );
 #endif
 
-        mProcessorsData[pid].pushRequests.emplace_back( BspInternal::PushRequest{ ident, { size, mProcessorsData[pid].registerCount++ } } );
+        data.pushRequests.emplace_back( BspInternal::PushRequest{ ident, { size, data.registerCount++ } } );
     }
 
     /**
@@ -504,15 +1046,20 @@ public:
 
     void PopReg( const void *ident )
     {
-        uint32_t &pid = ProcId();
-        mRegistersChanged[mProcessorsData[pid].syncBoolIndex] = true;
+        Local local = GetLocal( ProcId() );
+        PopReg( local, ident );
+    }
+
+    void PopReg( Local &local, const void *ident )
+    {
+        ProcessorData &data = *local.data;
+        mRegistersChanged[data.syncBoolIndex] = true;
 
 #ifndef BSP_SKIP_CHECKS
-        assert( pid < mProcCount );
-        assert( mProcessorsData.size() > pid );
+        assert( local.pid < mProcCount );
 #endif
 
-        mProcessorsData[pid].popRequests.emplace_back( BspInternal::PopRequest{ ident } );
+        data.popRequests.emplace_back( BspInternal::PopRequest{ ident } );
     }
 
     /**
@@ -535,17 +1082,19 @@ public:
 
     BSP_FORCEINLINE void Put( uint32_t pid, const void *src, void *dst, ptrdiff_t offset, size_t nbytes )
     {
-        uint32_t &tpid = ProcId();
-        mHasPutRequests[mProcessorsData[tpid].syncBoolIndex] = true;
+        Local local = GetLocal( ProcId() );
+        Put( local, pid, src, dst, offset, nbytes );
+    }
 
+    BSP_FORCEINLINE void Put( Local &local, uint32_t pid, const void *src, void *dst, ptrdiff_t offset, size_t nbytes )
+    {
 #ifndef BSP_SKIP_CHECKS
-        assert( tpid < mProcCount );
+        assert( local.pid < mProcCount );
         assert( pid < mProcCount );
         assert( src && dst );
 #endif
 
-        const char *srcBuff = reinterpret_cast<const char *>( src );
-        const size_t globalId = LocalToGlobal( tpid, dst ); //mRegisters[tpid][dst].registerCount;
+        const size_t globalId = LocalToGlobal( *local.data, dst ); //mRegisters[tpid][dst].registerCount;
 
 #ifndef BSP_SKIP_CHECKS
         assert( mProcessorsData[pid].threadRegisterLocation.size() > globalId );
@@ -554,10 +1103,158 @@ public:
         assert( mProcessorsData[pid].registers[GlobalToLocal( pid, globalId )].size >= offset + nbytes );
 #endif
 
-        //const char *dstBuff = reinterpret_cast<const char *>( GlobalToLocal( pid, globalId ) );
-        ptrdiff_t bufferLocation = mProcessorsData[tpid].putBufferStack.Alloc( nbytes, srcBuff );
+        PutId( local, pid, src, globalId, offset, nbytes );
+    }
+
+    /**
+     * Puts the given source data in the register with the given global ID of the given processor, without looking
+     * the register up. Slot registers are written through their slot index.
+     *
+     * @param [in,out]  local The state of this processor.
+     * @param   pid           The destination processor ID.
+     * @param   src           The source data, copied on the call.
+     * @param   globalId      The global ID of the register, see BspInternal::FirstSlotRegister.
+     * @param   offset        The offset in bytes in the register.
+     * @param   nbytes        The size in bytes.
+     */
+
+    BSP_FORCEINLINE void PutId( Local &local, uint32_t pid, const void *src, size_t globalId, ptrdiff_t offset,
+                                size_t nbytes )
+    {
+        const uint32_t tpid = local.pid;
+        ProcessorData &data = *local.data;
+        mHasPutRequests[data.syncBoolIndex] = true;
+
+#ifndef BSP_SKIP_CHECKS
+        assert( pid < mProcCount );
+#endif
+
+        const char *srcBuff = reinterpret_cast<const char *>( src );
+        ptrdiff_t bufferLocation = data.putBufferStack.Alloc( nbytes, srcBuff );
+
+        if ( !local.putQueues )
+        {
+            local.putQueues = mPutRequests.GetQueuesFromMe( tpid );
+        }
+
+        local.putQueues[pid].emplace_back( BspInternal::PutRequest{ bufferLocation, nullptr, globalId, offset, nbytes } );
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountPut( tpid, nbytes );
+        }
+    }
+
+    /**
+     * Sets the buffer that collective puts to this processor write to, until it is set again. Collectives use it to
+     * receive without registering their buffers, which would cost a superstep.
+     *
+     * @param [in,out]  local  The state of the processor.
+     * @param [in,out]  buffer The buffer.
+     *
+     * @pre The buffer is large enough for all collective puts to this processor in the current superstep.
+     */
+
+    BSP_FORCEINLINE void SetCollectiveBuffer( Local &local, void *buffer )
+    {
+        local.data->collectiveBuffer = static_cast< char * >( buffer );
+    }
+
+    /**
+     * Puts a buffer of size nbytes from source pointer src in the collective buffer of the thread with ID pid, at the
+     * given offset. The collective buffer is the one the receiving processor set for the current superstep.
+     *
+     * @param [in,out]  local The state of the processor.
+     * @param   pid           The processor ID.
+     * @param   src           Source to read the buffer from.
+     * @param   offset        The offset in the collective buffer to start writing at.
+     * @param   nbytes        The size of the message in bytes.
+     */
+
+    BSP_FORCEINLINE void CollectivePut( Local &local, uint32_t pid, const void *src, ptrdiff_t offset, size_t nbytes )
+    {
+        const uint32_t tpid = local.pid;
+        ProcessorData &data = *local.data;
+        mHasPutRequests[data.syncBoolIndex] = true;
+
+#ifndef BSP_SKIP_CHECKS
+        assert( tpid < mProcCount );
+        assert( pid < mProcCount );
+#endif
+
+        ptrdiff_t bufferLocation = data.putBufferStack.Alloc( nbytes, static_cast< const char * >( src ) );
+
+        if ( !local.putQueues )
+        {
+            local.putQueues = mPutRequests.GetQueuesFromMe( tpid );
+        }
+
+        local.putQueues[pid].emplace_back( BspInternal::PutRequest{ bufferLocation, nullptr, BspInternal::CollectiveRegister,
+                                                                    offset, nbytes } );
 
-        mPutRequests.GetQueueFromMe( pid, tpid ).emplace_back( BspInternal::PutRequest{ bufferLocation, nullptr, globalId, offset, nbytes } );
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountPut( tpid, nbytes );
+        }
+    }
+
+    /**
+     * Queues a span of bytes for the given processor, to be delivered by the next Exchange. The span is not copied; the
+     * receiver reads it during the exchange.
+     *
+     * @param [in,out]  local The state of the processor.
+     * @param   pid           The processor ID of the receiver.
+     * @param   src           The bytes, which must stay valid until the exchange.
+     * @param   nbytes        The amount of bytes.
+     */
+
+    BSP_FORCEINLINE void ExchangeSpan( Local &local, uint32_t pid, const void *src, size_t nbytes )
+    {
+        if ( nbytes == 0 )
+        {
+            return;
+        }
+
+#ifndef BSP_SKIP_CHECKS
+        assert( pid < mProcCount );
+#endif
+
+        mHasExchangeRequests[local.data->syncBoolIndex] = true;
+        mExchangeRequests.GetQueueFromMe( pid, local.pid ).emplace_back(
+            BspInternal::ExchangeRequest{ static_cast< const char * >( src ), nbytes } );
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountSend( local.pid, nbytes );
+        }
+    }
+
+    /**
+     * Synchronises like Sync, and delivers the spans all processors queued for this processor. Every receiver copies
+     * the spans straight from the memory of the senders into one buffer, ordered by sender, so the exchange takes
+     * one superstep and adds no headers.
+     *
+     * @param [in,out]  local    The state of the processor.
+     * @param [out]  received    The received bytes, ordered by sender and by queue order per sender.
+     * @param [out]  offsets     The offsets of the bytes of every sender in the received bytes, and the total size
+     *                           as last element.
+     *
+     * @pre All processors call Exchange in this superstep.
+     */
+
+    void Exchange( Local &local, std::vector< char > &received, std::vector< size_t > &offsets )
+    {
+        ProcessorData &data = *local.data;
+
+        received.clear();
+        offsets.assign( mProcCount + 1, 0 );
+        data.exchangeData = &received;
+        data.exchangeOffsets = &offsets;
+
+        Sync();
+
+        data.exchangeData = nullptr;
+        data.exchangeOffsets = nullptr;
     }
 
     /**
@@ -580,25 +1277,62 @@ public:
 
     BSP_FORCEINLINE void Get( uint32_t pid, const void *src, ptrdiff_t offset, void *dst, size_t nbytes )
     {
-        uint32_t &tpid = ProcId();
-        mHasGetRequests[mProcessorsData[tpid].syncBoolIndex] = true;
+        Local local = GetLocal( ProcId() );
+        Get( local, pid, src, offset, dst, nbytes );
+    }
 
+    BSP_FORCEINLINE void Get( Local &local, uint32_t pid, const void *src, ptrdiff_t offset, void *dst, size_t nbytes )
+    {
 #ifndef BSP_SKIP_CHECKS
-        assert( tpid < mProcCount );
+        assert( local.pid < mProcCount );
         assert( pid < mProcCount );
         assert( src && dst );
 #endif
 
-        const size_t globalId = LocalToGlobal( tpid, src ); //mRegisters[tpid][src].registerCount;
+        const size_t globalId = LocalToGlobal( *local.data, src ); //mRegisters[tpid][src].registerCount;
 
 #ifndef BSP_SKIP_CHECKS
         assert( mProcessorsData[pid].threadRegisterLocation.size() > globalId );
         assert( mProcessorsData[pid].registers[GlobalToLocal( pid, globalId )].size >= offset + nbytes );
 #endif
 
-        //const char *srcBuff = reinterpret_cast<const char *>( GlobalToLocal( pid, globalId ) );
+        GetId( local, pid, globalId, offset, dst, nbytes );
+    }
+
+    /**
+     * Gets data from the register with the given global ID of the given processor, without looking the register
+     * up. Slot registers are read through their slot index.
+     *
+     * @param [in,out]  local The state of this processor.
+     * @param   pid           The source processor ID.
+     * @param   globalId      The global ID of the register, see BspInternal::FirstSlotRegister.
+     * @param   offset        The offset in bytes in the register.
+     * @param [out]  dst      The destination, written in the next synchronisation.
+     * @param   nbytes        The size in bytes.
+     */
+
+    BSP_FORCEINLINE void GetId( Local &local, uint32_t pid, size_t globalId, ptrdiff_t offset, void *dst,
+                                size_t nbytes )
+    {
+        const uint32_t tpid = local.pid;
+        mHasGetRequests[local.data->syncBoolIndex] = true;
+
+#ifndef BSP_SKIP_CHECKS
+        assert( pid < mProcCount );
+        assert( dst );
+#endif
+
+        if ( !local.getQueues )
+        {
+            local.getQueues = mGetRequests.GetQueuesFromMe( tpid );
+        }
+
+        local.getQueues[pid].emplace_back( BspInternal::GetRequest{ dst, globalId, offset, nbytes } );
 
-        mGetRequests.GetQueueFromMe( pid, tpid ).emplace_back( BspInternal::GetRequest{ dst, globalId, offset, nbytes } );
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountGet( tpid, nbytes );
+        }
     }
 
     /**
@@ -616,24 +1350,187 @@ public:
 
     BSP_FORCEINLINE void Send( uint32_t pid, const void *tag, const void *payload, const size_t size )
     {
-        uint32_t &tpid = ProcId();
-        mHasSendRequests[mProcessorsData[tpid].syncBoolIndex] = true;
+        Local local = GetLocal( ProcId() );
+        Send( local, pid, tag, payload, size );
+    }
+
+    BSP_FORCEINLINE void Send( Local &local, uint32_t pid, const void *tag, const void *payload, const size_t size )
+    {
+        const uint32_t tpid = local.pid;
+        mHasSendRequests[local.data->syncBoolIndex] = true;
 
 #ifndef BSP_SKIP_CHECKS
         assert( pid < mProcCount );
         assert( tpid < mProcCount );
-        assert( mProcessorsData[tpid].newTagSize == mTagSize );
+        assert( local.data->newTagSize == mTagSize );
 #endif // !BSP_SKIP_CHECKS
 
         const char *srcBuff = reinterpret_cast<const char *>( payload );
         const char *tagBuff = reinterpret_cast<const char *>( tag );
 
-        BspInternal::StackAllocator &tmpSendBuffer = mTmpSendBuffers.GetQueueFromMe( pid, tpid );
+        if ( !local.sendQueues )
+        {
+            local.sendQueues = mTmpSendRequests.GetQueuesFromMe( tpid );
+            local.sendBuffers = mTmpSendBuffers.GetQueuesFromMe( tpid );
+        }
+
+        BspInternal::StackAllocator &tmpSendBuffer = local.sendBuffers[pid];
 
         BspInternal::StackAllocator::StackLocation bufferLocation = tmpSendBuffer.Alloc( size, srcBuff );
         BspInternal::StackAllocator::StackLocation tagLocation = tmpSendBuffer.Alloc( mTagSize, tagBuff );
 
-        mTmpSendRequests.GetQueueFromMe( pid, tpid ).emplace_back( BspInternal::SendRequest{ bufferLocation, size, tagLocation, mTagSize } );
+        local.sendQueues[pid].emplace_back( BspInternal::SendRequest{ bufferLocation, size, tagLocation, mTagSize, nullptr } );
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountSend( tpid, size + mTagSize );
+        }
+    }
+
+    /**
+     * Queues a message like Send, and returns its payload in the send buffer for the caller to write, so the payload
+     * needs no copy.
+     *
+     * @param [in,out]  local The state of this processor.
+     * @param   pid           The destination processor ID.
+     * @param   tag           The tag of the message.
+     * @param   size          The size of the payload in bytes.
+     *
+     * @return The payload, which stays valid until the next send of this processor.
+     *
+     * @pre
+     * * Begin has been called.
+     * * Tagsize is equal on all threads.
+     */
+
+    BSP_FORCEINLINE char *SendInPlace( Local &local, uint32_t pid, const void *tag, size_t size )
+    {
+        const uint32_t tpid = local.pid;
+        mHasSendRequests[local.data->syncBoolIndex] = true;
+
+#ifndef BSP_SKIP_CHECKS
+        assert( pid < mProcCount );
+        assert( tpid < mProcCount );
+        assert( local.data->newTagSize == mTagSize );
+#endif // !BSP_SKIP_CHECKS
+
+        if ( !local.sendQueues )
+        {
+            local.sendQueues = mTmpSendRequests.GetQueuesFromMe( tpid );
+            local.sendBuffers = mTmpSendBuffers.GetQueuesFromMe( tpid );
+        }
+
+        BspInternal::StackAllocator &tmpSendBuffer = local.sendBuffers[pid];
+
+        // the tag goes first, since allocating after the payload could move it
+        BspInternal::StackAllocator::StackLocation tagLocation =
+            tmpSendBuffer.Alloc( mTagSize, reinterpret_cast< const char * >( tag ) );
+        BspInternal::StackAllocator::StackLocation bufferLocation;
+        char *payload = tmpSendBuffer.Reserve( size, bufferLocation );
+
+        local.sendQueues[pid].emplace_back( BspInternal::SendRequest{ bufferLocation, size, tagLocation, mTagSize, nullptr } );
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountSend( tpid, size + mTagSize );
+        }
+
+        return payload;
+    }
+
+    /**
+     * Sends a vector to the given processor by handing over its buffer, so the transfer costs O(1) regardless of its
+     * size. The receiver takes the buffer over with MoveOwned, or copies from it with Move.
+     *
+     * @param [in,out]  local   The state of this processor.
+     * @param   pid             The destination processor ID.
+     * @param   tag             The tag of the message.
+     * @param [in,out]  payload The payload, which is empty afterwards.
+     *
+     * @pre
+     * * Begin has been called.
+     * * Tagsize is equal on all threads.
+     */
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void SendMove( Local &local, uint32_t pid, const void *tag, std::vector< tPrimitive > &&payload )
+    {
+        // receivers may copy the payload bytewise with Move
+        static_assert( std::is_trivially_copyable< tPrimitive >::value, "SendMove needs trivially copyable elements" );
+
+        const uint32_t tpid = local.pid;
+        mHasSendRequests[local.data->syncBoolIndex] = true;
+
+#ifndef BSP_SKIP_CHECKS
+        assert( pid < mProcCount );
+        assert( tpid < mProcCount );
+        assert( local.data->newTagSize == mTagSize );
+#endif // !BSP_SKIP_CHECKS
+
+        if ( !local.sendQueues )
+        {
+            local.sendQueues = mTmpSendRequests.GetQueuesFromMe( tpid );
+            local.sendBuffers = mTmpSendBuffers.GetQueuesFromMe( tpid );
+        }
+
+        const size_t size = payload.size() * sizeof( tPrimitive );
+        const char *tagBuff = reinterpret_cast<const char *>( tag );
+
+        BspInternal::StackAllocator::StackLocation tagLocation = local.sendBuffers[pid].Alloc( mTagSize, tagBuff );
+        std::unique_ptr< BspInternal::OwnedPayload > owned( new BspInternal::OwnedVector< tPrimitive >( std::move( payload ) ) );
+
+        local.sendQueues[pid].emplace_back( BspInternal::SendRequest{ 0, size, tagLocation, mTagSize, std::move( owned ) } );
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountSend( tpid, size + mTagSize );
+        }
+    }
+
+    /**
+     * Moves the first message in the queue to the given vector. The vector takes over the buffer of messages sent
+     * with SendMove of the same element type, and copies the payload of all other messages.
+     *
+     * @param [in,out]  local   The state of this processor.
+     * @param [out]  payload    The payload destination.
+     *
+     * @pre Begin has been called.
+     *
+     * @post
+     * * If the queue has no more messages, payload is unchanged.
+     * * The queue cursor for the send queue is moved to the next message.
+     */
+
+    template< typename tPrimitive >
+    BSP_FORCEINLINE void MoveOwned( Local &local, std::vector< tPrimitive > &payload )
+    {
+        static_assert( std::is_trivially_copyable< tPrimitive >::value, "MoveOwned needs trivially copyable elements" );
+
+        ProcessorData &data = *local.data;
+
+        if ( data.sendReceivedIndex >= data.sendRequests.size() )
+        {
+            return;
+        }
+
+        BspInternal::SendRequest &request = data.sendRequests[data.sendReceivedIndex++];
+        BspInternal::OwnedVector< tPrimitive > *owned =
+            dynamic_cast< BspInternal::OwnedVector< tPrimitive > * >( request.owned.get() );
+
+        if ( owned )
+        {
+            payload.swap( owned->vector );
+            request.owned.reset();
+            return;
+        }
+
+        const char *source = request.owned ? request.owned->Data() : data.sendBuffers.Data( request.bufferLocation );
+        payload.resize( request.bufferSize / sizeof( tPrimitive ) );
+
+        if ( !payload.empty() )
+        {
+            memcpy( payload.data(), source, payload.size() * sizeof( tPrimitive ) );
+        }
     }
 
     /**
@@ -650,25 +1547,73 @@ public:
      *      Moves the first message in the queue o the given payload destination.
      * * payload != nullptr.
      *
-     * @post The queue cursor for the send queue is moved to the next message.
+     * @post The queue cursor for the send queue is moved to the next message.
+     */
+
+    BSP_FORCEINLINE void Move( void *payload, size_t max_copy_size_in )
+    {
+        Local local = GetLocal( ProcId() );
+        Move( local, payload, max_copy_size_in );
+    }
+
+    BSP_FORCEINLINE void Move( Local &local, void *payload, size_t max_copy_size_in )
+    {
+        ProcessorData &data = *local.data;
+
+        if ( data.sendRequests.empty() || data.sendReceivedIndex >= data.sendRequests.size() )
+        {
+            return;
+        }
+
+        assert( payload );
+
+        BspInternal::SendRequest &request = data.sendRequests[data.sendReceivedIndex++];
+
+        const size_t copySize = std::min( max_copy_size_in, request.bufferSize );
+
+        if ( request.owned )
+        {
+            memcpy( payload, request.owned->Data(), copySize );
+            return;
+        }
+
+        data.sendBuffers.Extract( request.bufferLocation, copySize, ( char * )payload );
+    }
+
+    /**
+     * Gets the tag and payload of the first message in the queue, without copying them.
+     *
+     * @param [in,out]  local    The state of this processor.
+     * @param [out]  tag         The first byte of the tag.
+     * @param [out]  payload     The first byte of the payload.
+     *
+     * @return The size of the payload in bytes, or -1 when the queue has no more messages.
+     *
+     * @pre Begin has been called.
+     *
+     * @post
+     * * The tag and payload stay valid until the next synchronisation.
+     * * The queue cursor for the send queue is moved to the next message.
      */
 
-    BSP_FORCEINLINE void Move( void *payload, size_t max_copy_size_in )
+    BSP_FORCEINLINE size_t MoveInPlace( Local &local, const char **tag, const char **payload )
     {
-        uint32_t &pid = ProcId();
-        ProcessorData &data = mProcessorsData[pid];
+        ProcessorData &data = *local.data;
 
-        if ( data.sendRequests.empty() || data.sendReceivedIndex >= data.sendRequests.size() )
+        if ( data.sendReceivedIndex >= data.sendRequests.size() )
         {
-            return;
+            return ( size_t ) - 1;
         }
 
-        assert( payload );
+        const BspInternal::SendRequest &request = data.sendRequests[data.sendReceivedIndex++];
 
-        BspInternal::SendRequest &request = data.sendRequests[data.sendReceivedIndex++];
+#ifndef BSP_SKIP_CHECKS
+        assert( request.tagSize == mTagSize );
+#endif // !BSP_SKIP_CHECKS
 
-        const size_t copySize = std::min( max_copy_size_in, request.bufferSize );
-        data.sendBuffers.Extract( request.bufferLocation, copySize, ( char * )payload );
+        *tag = data.sendBuffers.Data( request.tagLocation );
+        *payload = request.owned ? request.owned->Data() : data.sendBuffers.Data( request.bufferLocation );
+        return request.bufferSize;
     }
 
     /**
@@ -732,6 +1677,96 @@ public:
         }
     }
 
+    /**
+     * Binds the given variable to a registration slot of this processor. Unlike PushReg, the binding needs no
+     * synchronisation: communication with the slot is resolved by its index when the next synchronisation processes
+     * it.
+     *
+     * @param [in,out]  local The state of this processor.
+     * @param   slot          The slot index, below BSP_REGISTER_SLOTS.
+     * @param   ident         The variable, or nullptr to unbind the slot.
+     * @param   size          The size of the variable in bytes.
+     */
+
+    BSP_FORCEINLINE void BindSlot( Local &local, size_t slot, const void *ident, size_t size )
+    {
+        assert( slot < BSP_REGISTER_SLOTS );
+        local.data->slots[slot] = BspInternal::RegisterSlot{ ident, size };
+    }
+
+    /**
+     * Gets the amount of synchronisations of the given processor in this computation.
+     *
+     * @param   local The state of the processor.
+     *
+     * @return The superstep number, starting at 0.
+     */
+
+    BSP_FORCEINLINE size_t Superstep( const Local &local ) const
+    {
+        return local.data->superstep;
+    }
+
+    /**
+     * Takes a buffer from the pool of the given processor, which is reused by buffers given back with ReleaseBuffer.
+     *
+     * @param [in,out]  local The state of the processor.
+     * @param   size          The size of the buffer in bytes.
+     *
+     * @return The buffer.
+     */
+
+    BSP_FORCEINLINE std::vector< char > AcquireBuffer( Local &local, size_t size )
+    {
+        ProcessorData &data = *local.data;
+        std::vector< BspInternal::PooledBuffer > &pool = data.bufferPool;
+
+        for ( size_t i = pool.size(); i-- > 0; )
+        {
+            if ( pool[i].superstep < data.superstep )
+            {
+                std::vector< char > buffer( std::move( pool[i].buffer ) );
+                pool[i] = std::move( pool.back() );
+                pool.pop_back();
+                buffer.resize( size );
+
+                return buffer;
+            }
+        }
+
+        return std::vector< char >( size );
+    }
+
+    /**
+     * Gives a buffer back to the pool of the given processor.
+     *
+     * @param [in,out]  local  The state of the processor.
+     * @param [in,out]  buffer The buffer, taken with AcquireBuffer.
+     * @param   superstep      The superstep in which communication may still write to the buffer, so that it is
+     *                         reused after the next synchronisation.
+     */
+
+    BSP_FORCEINLINE void ReleaseBuffer( Local &local, std::vector< char > &&buffer, size_t superstep )
+    {
+        local.data->bufferPool.emplace_back( BspInternal::PooledBuffer{ superstep, std::move( buffer ) } );
+    }
+
+    /**
+     * Gets the state of the given processor, for the operations that take a Local.
+     *
+     * @param   pid The processor ID.
+     *
+     * @return The state, which stays valid until the computation ends.
+     *
+     * @pre Begin has been called.
+     */
+
+    BSP_FORCEINLINE Local GetLocal( uint32_t pid )
+    {
+        assert( pid < mProcessorsData.size() );
+        return Local{ pid, &mProcessorsData[pid], nullptr, nullptr, nullptr, nullptr };
+    }
+
     /**
      * Query if this object is ended.
      *
@@ -744,48 +1779,103 @@ public:
     }
 
     /**
-     * Gets the static instance of the BSP class to support static calls.
+     * Gets the instance the calling thread is bound to, or the static instance when the thread is not bound to any
+     * instance, to support static calls.
      *
      * @return The instance.
      */
 
     static BSP_FORCEINLINE BSP &GetInstance()
     {
+        BSP *current = Current();
+
+        if ( current )
+        {
+            return *current;
+        }
+
         static BSP mBSP;
         return mBSP;
     }
 
+    /**
+     * Gets the instance the calling thread is bound to. The threads started by Begin are bound to the instance that
+     * started them.
+     *
+     * @return The bound instance, or nullptr when the thread uses the static instance.
+     */
+
+    static BSP_FORCEINLINE BSP *&Current()
+    {
+        static BSP_TLS BSP *gCurrent = nullptr;
+
+        return gCurrent;
+    }
+
+    BSP()
+        : mThreadBarrier( 0 ),
+          mCostTolerance( 0.0 ),
+          mProcCount( 0 ),
+          mWorkerCount( 0 ),
+          mActiveWorkers( 0 ),
+          mTagSize( 0 ),
+          mEnded( true ),
+          mSkewEnabled( false ),
+          mFiberMode( false ),
+          mAbort( false )
+    {
+        for ( size_t index = 0; index < 2; ++index )
+        {
+            mRegistersChanged[index] = false;
+            mTagSizeChanged[index] = false;
+            mHasGetRequests[index] = false;
+            mHasPutRequests[index] = false;
+            mHasSendRequests[index] = false;
+            mHasExchangeRequests[index] = false;
+        }
+
+        mMainThreadMask.valid = false;
+    }
+
 private:
 
     struct ProcessorData
     {
         ProcessorData()
             : sendReceivedIndex( 0 ),
+              superstep( 0 ),
               registerCount( 0 ),
               newTagSize( 0 ),
               sendRequestsSize( 0 ),
               pushRequestsSize( 0 ),
               popRequestsSize( 0 ),
               syncBoolIndex( 0 ),
-              putBufferStack( 9064 ),
-              sendBuffers( 9064 )
+              cpu( -1 ),
+              collectiveBuffer( nullptr ),
+              exchangeData( nullptr ),
+              exchangeOffsets( nullptr ),
+              slots()
         {
-            sendRequests.reserve( 9064 );
-            pushRequests.reserve( 9064 );
-            popRequests.reserve( 9064 );
         }
 
         size_t sendReceivedIndex;
+        size_t superstep;
         size_t registerCount;
         size_t newTagSize;
         size_t sendRequestsSize;
         size_t pushRequestsSize;
         size_t popRequestsSize;
         size_t syncBoolIndex;
+        int32_t cpu;
+        char *collectiveBuffer;
+        std::vector< char > *exchangeData;
+        std::vector< size_t > *exchangeOffsets;
+        std::array< BspInternal::RegisterSlot, BSP_REGISTER_SLOTS > slots;
         BspInternal::StackAllocator putBufferStack;
         BspInternal::StackAllocator sendBuffers;
         std::chrono::time_point< std::chrono::high_resolution_clock > startTime;
         std::vector< BspInternal::SendRequest > sendRequests;
+        std::vector< BspInternal::PooledBuffer > bufferPool;
         std::vector< BspInternal::PushRequest > pushRequests;
         std::vector< BspInternal::PopRequest > popRequests;
         std::map< const void *, BspInternal::RegisterInfo > registers;
@@ -793,6 +1883,13 @@ private:
     };
 
     BspInternal::MixedBarrier mThreadBarrier;
+    BspInternal::FiberScheduler mFibers;
+    BspInternal::Hierarchy mHierarchy;
+    BspInternal::Profiler mProfiler;
+    BspInternal::CostModel mCostModel;
+    BspInternal::CommunicationMatrix mCommMatrix;
+    BspInternal::Recorder mRecorder;
+    BspInternal::ArrivalSkew mArrivalSkew;
 
     BspInternal::CommunicationQueues< std::vector< BspInternal::PutRequest > > mPutRequests;
     BspInternal::CommunicationQueues< std::vector< BspInternal::GetRequest > > mGetRequests;
@@ -800,11 +1897,32 @@ private:
     BspInternal::CommunicationQueues< std::vector< BspInternal::SendRequest > > mTmpSendRequests;
     BspInternal::CommunicationQueues< BspInternal::StackAllocator > mTmpSendBuffers;
 
+    BspInternal::CommunicationQueues< std::vector< BspInternal::PutRequest > > mGroupPutRequests;
+    BspInternal::CommunicationQueues< BspInternal::StackAllocator > mGroupPutBuffers;
+
+    BspInternal::CommunicationQueues< std::vector< BspInternal::ExchangeRequest > > mExchangeRequests;
+
     std::vector< ProcessorData > mProcessorsData;
 
+    BspInternal::Affinity mAffinity;
+    BspInternal::ThreadMask mMainThreadMask;
+    std::vector< int32_t > mCpuMapping;
+
+    std::vector< uint32_t > mFanouts;
+    std::string mProfilePrefix;
+    std::string mCostParamsPath;
+    std::string mCostReportPath;
+    double mCostTolerance;
+    std::string mCommMatrixPath;
+    std::string mRecordPath;
+    std::string mSkewReportPath;
+    std::string mOutputSuffix;
+
     std::vector< std::future< void > > mThreads;
     std::function< void() > mEntry;
     uint32_t mProcCount;
+    uint32_t mWorkerCount;
+    uint32_t mActiveWorkers;
     std::atomic_size_t mTagSize;
 
     volatile bool mRegistersChanged[2];
@@ -812,18 +1930,15 @@ private:
     volatile bool mHasGetRequests[2];
     volatile bool mHasPutRequests[2];
     volatile bool mHasSendRequests[2];
+    volatile bool mHasExchangeRequests[2];
 
     bool mEnded;
+    bool mSkewEnabled;
+    bool mFiberMode;
     std::atomic_bool mAbort;
 
-    BSP()
-        : mThreadBarrier( 0 ),
-          mProcCount( 0 ),
-          mTagSize( 0 ),
-          mEnded( true ),
-          mAbort( false )
-    {
-    }
+    BSP( const BSP & );
+    BSP &operator=( const BSP & );
 
     void ResetChangedBooleans()
     {
@@ -833,6 +1948,7 @@ private:
         mHasGetRequests[index] = false;
         mHasPutRequests[index] = false;
         mHasSendRequests[index] = false;
+        mHasExchangeRequests[index] = false;
     }
 
     void StartTiming()
@@ -841,20 +1957,156 @@ private:
         mProcessorsData[ProcId()].startTime = std::chrono::high_resolution_clock::now();
     }
 
-    void SyncPoint()
+    void SyncPoint( BspInternal::MixedBarrier::Clock::time_point *arrival = nullptr )
+    {
+        if ( mProfiler.IsEnabled() )
+        {
+            const BspInternal::Profiler::Clock::time_point since = BspInternal::Profiler::Clock::now();
+            WaitPoint( arrival );
+            mProfiler.AddWait( ProcId(), since );
+        }
+        else
+        {
+            WaitPoint( arrival );
+        }
+    }
+
+    void WaitPoint( BspInternal::MixedBarrier::Clock::time_point *arrival )
+    {
+        if ( mFiberMode )
+        {
+            mFibers.Wait( ProcId(), mAbort, arrival );
+        }
+        else
+        {
+            mThreadBarrier.Wait( mAbort, arrival );
+        }
+    }
+
+    /**
+     * The first sync point of a synchronisation, where the processors arrive after their computation. Records the
+     * arrival skew of the processor when enabled.
+     */
+
+    void ArrivalPoint()
     {
-        mThreadBarrier.Wait( mAbort );
+        if ( mArrivalSkew.IsEnabled() )
+        {
+            const BspInternal::MixedBarrier::Clock::time_point mine = BspInternal::MixedBarrier::Clock::now();
+            BspInternal::MixedBarrier::Clock::time_point last = mine;
+            SyncPoint( &last );
+
+            // a thread that read the clock earlier may still decrement the barrier last
+            const double skew = std::chrono::duration< double, std::micro >( last - mine ).count();
+            mArrivalSkew.Add( ProcId(), skew > 0.0 ? skew : 0.0 );
+        }
+        else
+        {
+            SyncPoint();
+        }
     }
 
     void CheckAborted()
     {
         if ( mAbort )
         {
-            mThreadBarrier.NotifyAbort();
+            NotifyAbort();
             throw BspInternal::BspAbort( "Aborted" );
         }
     }
 
+    void NotifyAbort()
+    {
+        mThreadBarrier.NotifyAbort();
+        mFibers.NotifyAbort();
+        mHierarchy.NotifyAbort();
+    }
+
+    void RestoreMainThread()
+    {
+        BspInternal::Affinity::RestoreCurrentThread( mMainThreadMask );
+        mMainThreadMask.valid = false;
+    }
+
+    void RunEntry()
+    {
+        try
+        {
+            mEntry();
+        }
+        catch ( BspInternal::BspAbort & )
+        {
+
+        }
+    }
+
+    static std::string EnvironmentString( const char *name )
+    {
+        const char *value = std::getenv( name );
+        return value ? value : "";
+    }
+
+    std::string EnvironmentOutput( const char *name ) const
+    {
+        return InsertSuffix( EnvironmentString( name ), mOutputSuffix );
+    }
+
+    std::string EnvironmentPrefix( const char *name ) const
+    {
+        const std::string prefix = EnvironmentString( name );
+        return prefix.empty() ? prefix : prefix + mOutputSuffix;
+    }
+
+    static double EnvironmentTolerance()
+    {
+        const char *value = std::getenv( "BSP_COST_TOLERANCE" );
+        const double tolerance = value ? std::strtod( value, nullptr ) : 0.0;
+        return tolerance > 0.0 ? tolerance : 2.0;
+    }
+
+    static uint32_t EnvironmentWorkers()
+    {
+        const char *value = std::getenv( "BSP_WORKERS" );
+        return value ? static_cast< uint32_t >( std::strtoul( value, nullptr, 10 ) ) : 0;
+    }
+
+    void Record( uint32_t pid )
+    {
+        const ProcessorData &data = mProcessorsData[pid];
+        std::vector< size_t > pushSizes;
+        std::vector< size_t > popIds;
+
+        for ( const auto &pushRequest : data.pushRequests )
+        {
+            pushSizes.push_back( pushRequest.registerInfo.size );
+        }
+
+        for ( const auto &popRequest : data.popRequests )
+        {
+            auto reg = data.registers.find( popRequest.popRegister );
+
+            if ( reg != data.registers.end() )
+            {
+                popIds.push_back( reg->second.registerCount );
+                continue;
+            }
+
+            // popped in the same superstep as it was pushed
+            for ( auto pushRequest = data.pushRequests.rbegin(), end = data.pushRequests.rend(); pushRequest != end; ++pushRequest )
+            {
+                if ( pushRequest->pushRegister == popRequest.popRegister )
+                {
+                    popIds.push_back( pushRequest->registerInfo.registerCount );
+                    break;
+                }
+            }
+        }
+
+        mRecorder.Capture( pid, pushSizes, popIds, data.newTagSize, mPutRequests.TryGetQueuesFromMe( pid ),
+                           mGetRequests.TryGetQueuesFromMe( pid ), mTmpSendRequests.TryGetQueuesFromMe( pid ),
+                           mExchangeRequests.TryGetQueuesFromMe( pid ), data.exchangeData != nullptr );
+    }
+
     BSP_FORCEINLINE void ProcessPushRequests( size_t pid )
     {
         ProcessorData &data = mProcessorsData[pid];
@@ -875,18 +2127,20 @@ private:
     {
         for ( size_t owner = 0; owner < mProcCount; ++owner )
         {
-            std::vector< BspInternal::PutRequest > &putQueue = mPutRequests.GetQueueToMe( owner, pid );
+            std::vector< BspInternal::PutRequest > *putQueue = mPutRequests.TryGetQueueToMe( owner, pid );
 
-            if ( !putQueue.empty() )
+            if ( putQueue && !putQueue->empty() )
             {
-                for ( auto putRequest = putQueue.rbegin(), end = putQueue.rend(); putRequest != end; ++putRequest )
+                for ( auto putRequest = putQueue->rbegin(), end = putQueue->rend(); putRequest != end; ++putRequest )
                 {
                     char *dstBuff;
 
                     if ( putRequest->destination == nullptr )
                     {
-                        dstBuff = static_cast< char * >( const_cast< void * >( GlobalToLocal( pid, putRequest->globalId ) ) )
-                                  + putRequest->offset;
+                        const void *base = putRequest->globalId == BspInternal::CollectiveRegister ?
+                                           mProcessorsData[pid].collectiveBuffer :
+                                           GlobalToLocal( pid, putRequest->globalId, putRequest->offset, putRequest->size );
+                        dstBuff = static_cast< char * >( const_cast< void * >( base ) ) + putRequest->offset;
                     }
                     else
                     {
@@ -894,10 +2148,102 @@ private:
                     }
 
                     mProcessorsData[owner].putBufferStack.Extract( putRequest->bufferLocation, putRequest->size, dstBuff );
+
+                    if ( mProfiler.IsEnabled() )
+                    {
+                        mProfiler.CountReceived( pid, putRequest->size );
+                    }
+                }
+
+                putQueue->clear();
+            }
+
+            ProcessGroupPutRequests( owner, pid );
+        }
+    }
+
+    void ProcessExchangeRequests( uint32_t pid )
+    {
+        ProcessorData &data = mProcessorsData[pid];
+        size_t total = 0;
+
+        for ( size_t owner = 0; owner < mProcCount; ++owner )
+        {
+            const std::vector< BspInternal::ExchangeRequest > *queue = mExchangeRequests.TryGetQueueToMe( owner, pid );
+
+            if ( queue )
+            {
+                for ( const BspInternal::ExchangeRequest &request : *queue )
+                {
+                    total += request.size;
+                }
+            }
+
+            if ( data.exchangeOffsets )
+            {
+                ( *data.exchangeOffsets )[owner + 1] = total;
+            }
+        }
+
+        // spans to processors that synchronise without exchanging are dropped
+        char *destination = nullptr;
+
+        if ( data.exchangeData )
+        {
+            data.exchangeData->resize( total );
+            destination = data.exchangeData->data();
+        }
+
+        for ( size_t owner = 0; owner < mProcCount; ++owner )
+        {
+            std::vector< BspInternal::ExchangeRequest > *queue = mExchangeRequests.TryGetQueueToMe( owner, pid );
+
+            if ( !queue || queue->empty() )
+            {
+                continue;
+            }
+
+            if ( destination )
+            {
+                for ( const BspInternal::ExchangeRequest &request : *queue )
+                {
+                    memcpy( destination, request.data, request.size );
+                    destination += request.size;
                 }
+            }
+
+            queue->clear();
+        }
+
+        if ( mProfiler.IsEnabled() )
+        {
+            mProfiler.CountReceived( pid, destination ? total : 0 );
+        }
+    }
+
+    BSP_FORCEINLINE void ProcessGroupPutRequests( size_t owner, uint32_t pid )
+    {
+        std::vector< BspInternal::PutRequest > *putQueue = mGroupPutRequests.TryGetQueueToMe( owner, pid );
+
+        if ( putQueue && !putQueue->empty() )
+        {
+            BspInternal::StackAllocator &putBuffer = *mGroupPutBuffers.TryGetQueueToMe( owner, pid );
+
+            for ( auto putRequest = putQueue->rbegin(), end = putQueue->rend(); putRequest != end; ++putRequest )
+            {
+                char *dstBuff = static_cast< char * >( const_cast< void * >( GlobalToLocal( pid, putRequest->globalId ) ) )
+                                + putRequest->offset;
+
+                putBuffer.Extract( putRequest->bufferLocation, putRequest->size, dstBuff );
 
-                putQueue.clear();
+                if ( mProfiler.IsEnabled() )
+                {
+                    mProfiler.CountReceived( pid, putRequest->size );
+                }
             }
+
+            putQueue->clear();
+            putBuffer.Clear();
         }
     }
 
@@ -914,23 +2260,30 @@ private:
 
         for ( size_t owner = 0; owner < mProcCount; ++owner )
         {
-            std::vector< BspInternal::SendRequest > &tmpQueue = mTmpSendRequests.GetQueueToMe( owner, pid );
+            std::vector< BspInternal::SendRequest > *tmpQueue = mTmpSendRequests.TryGetQueueToMe( owner, pid );
 
-            if ( !tmpQueue.empty() )
+            if ( tmpQueue && !tmpQueue->empty() )
             {
-                for ( auto &sendRequest : tmpQueue )
+                for ( auto &sendRequest : *tmpQueue )
                 {
                     sendRequest.bufferLocation += offset;
                     sendRequest.tagLocation += offset;
                 }
 
-                std::copy( std::make_move_iterator( tmpQueue.begin() ), std::make_move_iterator( tmpQueue.end() ),
-                           std::back_insert_iterator< std::vector< BspInternal::SendRequest > >( data.sendRequests ) );
-                tmpQueue = std::vector< BspInternal::SendRequest >();
+                data.sendRequests.insert( data.sendRequests.end(), std::make_move_iterator( tmpQueue->begin() ),
+                                          std::make_move_iterator( tmpQueue->end() ) );
+
+                // keeps the capacity, so the queue is sized by the traffic of previous supersteps
+                tmpQueue->clear();
 
-                BspInternal::StackAllocator &tmpBuffer = mTmpSendBuffers.GetQueueToMe( owner, pid );
+                BspInternal::StackAllocator &tmpBuffer = *mTmpSendBuffers.TryGetQueueToMe( owner, pid );
 
                 offset += tmpBuffer.Size();
+
+                if ( mProfiler.IsEnabled() )
+                {
+                    mProfiler.CountReceived( static_cast< uint32_t >( pid ), static_cast< uint64_t >( tmpBuffer.Size() ) );
+                }
                 sendBuffer.Merge( tmpBuffer );
                 tmpBuffer.Clear();
             }
@@ -958,35 +2311,85 @@ private:
 
         for ( uint32_t owner = 0; owner < mProcCount; ++owner )
         {
-            std::vector< BspInternal::GetRequest > &getQueue = mGetRequests.GetQueueToMe( owner, pid );
+            std::vector< BspInternal::GetRequest > *getQueue = mGetRequests.TryGetQueueToMe( owner, pid );
+
+            if ( !getQueue )
+            {
+                continue;
+            }
 
-            for ( auto request = getQueue.rbegin(), end = getQueue.rend(); request != end; ++request )
+            for ( auto request = getQueue->rbegin(), end = getQueue->rend(); request != end; ++request )
             {
                 //const char *srcBuff = reinterpret_cast<const char *>( request->source );
-                const char *srcBuff = reinterpret_cast<const char *>( GlobalToLocal( pid, request->globalId ) ) + request->offset;
+                const char *srcBuff = reinterpret_cast<const char *>( GlobalToLocal( pid, request->globalId, request->offset,
+                                                                                     request->size ) ) + request->offset;
 
                 BspInternal::StackAllocator::StackLocation bufferLocation = data.putBufferStack.Alloc( request->size, srcBuff );
 
                 mPutRequests.GetQueueFromMe( owner, pid ).emplace_back( BspInternal::PutRequest{ bufferLocation, request->destination, 0, 0, request->size } );
+
+                if ( mProfiler.IsEnabled() )
+                {
+                    mProfiler.CountServed( pid, request->size );
+                }
             }
 
-            getQueue.clear();
+            getQueue->clear();
         }
     }
 
     BSP_FORCEINLINE size_t LocalToGlobal( uint32_t pid, const void *reg )
+    {
+        return LocalToGlobal( mProcessorsData[pid], reg );
+    }
+
+    BSP_FORCEINLINE size_t LocalToGlobal( const ProcessorData &data, const void *reg )
     {
 #ifndef BSP_SKIP_CHECKS
-        assert( mProcessorsData[pid].registers.find( reg ) != mProcessorsData[pid].registers.end() );
+        assert( data.registers.find( reg ) != data.registers.end() );
 #endif
-        return ( *mProcessorsData[pid].registers.find( reg ) ).second.registerCount;
+        return ( *data.registers.find( reg ) ).second.registerCount;
     }
 
     BSP_FORCEINLINE const void *GlobalToLocal( uint32_t pid, size_t globalId )
     {
+        if ( globalId >= BspInternal::FirstSlotRegister )
+        {
+            const BspInternal::RegisterSlot &slot = mProcessorsData[pid].slots[globalId - BspInternal::FirstSlotRegister];
+
+#ifndef BSP_SKIP_CHECKS
+            assert( slot.location );
+#endif
+            return slot.location;
+        }
+
         return mProcessorsData[pid].threadRegisterLocation[globalId];
     }
 
+    /**
+     * Resolves a global ID like GlobalToLocal, and checks that the accessed bytes lie within a bound slot. Registers
+     * are checked when the request is queued, but slots are bound at runtime and only resolved here, so a request
+     * outside the bound variable aborts the computation.
+     */
+
+    BSP_FORCEINLINE const void *GlobalToLocal( uint32_t pid, size_t globalId, ptrdiff_t offset, size_t nbytes )
+    {
+        if ( globalId >= BspInternal::FirstSlotRegister && globalId != BspInternal::CollectiveRegister )
+        {
+            const size_t index = globalId - BspInternal::FirstSlotRegister;
+            const BspInternal::RegisterSlot &slot = mProcessorsData[pid].slots[index];
+
+            if ( !slot.location || offset < 0 || static_cast< size_t >( offset ) > slot.size ||
+                    nbytes > slot.size - static_cast< size_t >( offset ) )
+            {
+                Abort( "Error: %zu bytes at offset %td do not lie within slot %zu of processor %u, which is bound to "
+                       "%zu bytes.\n", nbytes, offset, index, pid, slot.location ? slot.size : 0 );
+            }
+        }
+
+        return GlobalToLocal( pid, globalId );
+    }
+
 };
 
 #endif
\ No newline at end of file
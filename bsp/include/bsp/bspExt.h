@@ -173,6 +173,162 @@ namespace BSPLib
         return Classic::Time();
     }
 
+    typedef BspInternal::AffinityPolicy AffinityPolicy;
+
+    /**
+     * Sets the policy that determines on which logical processor each processor is pinned, for the computations
+     * started after this call.
+     *
+     * @param   policy The placement policy.
+     */
+
+    inline void SetAffinity( AffinityPolicy policy )
+    {
+        BSP::GetInstance().SetAffinity( policy );
+    }
+
+    /**
+     * Pins processor `pid` on logical processor `cpus[pid % cpus.size()]`, for the computations started after this
+     * call.
+     *
+     * @param   cpus The logical processor identifiers, an empty list disables pinning.
+     */
+
+    inline void SetAffinity( const std::vector< uint32_t > &cpus )
+    {
+        BSP::GetInstance().SetAffinity( cpus );
+    }
+
+    /**
+     * Gets the logical processor the given processor is pinned on.
+     *
+     * @param   pid The processor ID.
+     *
+     * @return The logical processor, or -1 when the processor is not pinned.
+     */
+
+    inline int32_t GetAffinity( uint32_t pid )
+    {
+        return BSP::GetInstance().GetAffinity( pid );
+    }
+
+    /**
+     * Gets the logical processor the current processor is pinned on.
+     *
+     * @return The logical processor, or -1 when the processor is not pinned.
+     */
+
+    inline int32_t GetAffinity()
+    {
+        return GetAffinity( ProcId() );
+    }
+
+    /**
+     * Sets the amount of worker threads that run the processors, for the computations started after this call. When
+     * there are more processors than workers, the processors run as fibers multiplexed on the workers.
+     *
+     * @param   count The amount of workers, 0 to use one thread per processor.
+     */
+
+    inline void SetWorkers( uint32_t count )
+    {
+        BSP::GetInstance().SetWorkers( count );
+    }
+
+    /**
+     * Gets the amount of worker threads running the processors.
+     *
+     * @return The amount of workers.
+     */
+
+    inline uint32_t GetWorkers()
+    {
+        return BSP::GetInstance().GetWorkers();
+    }
+
+    /**
+     * Enables the profiler for the computations started after this call. At the end of a computation, the compute
+     * time, barrier wait time, delivery time and communication volume per superstep and processor are written to
+     * `prefix.json` as a Chrome trace and to `prefix.csv` as a summary.
+     *
+     * @param   prefix The path prefix of the output files, an empty prefix to use the `BSP_PROFILE` environment
+     *                 variable.
+     */
+
+    inline void SetProfile( const std::string &prefix )
+    {
+        BSP::GetInstance().SetProfile( prefix );
+    }
+
+    /**
+     * Enables the cost model for the computations started after this call. At the end of a computation, every
+     * superstep is compared with the prediction ( h g + l ) / r, using the machine parameters written by bspbench, and
+     * the supersteps that take longer than `tolerance` times the prediction are reported.
+     *
+     * @param   paramsPath The path of the machine parameters, an empty path to use the `BSP_COST_MODEL` environment
+     *                     variable.
+     * @param   reportPath The path of the report, an empty path to use `BSP_COST_REPORT` or stderr.
+     * @param   tolerance  The ratio of measured to predicted time above which a superstep is reported, zero to use
+     *                     `BSP_COST_TOLERANCE` or 2.
+     */
+
+    inline void SetCostModel( const std::string &paramsPath, const std::string &reportPath = "",
+                              double tolerance = 0.0 )
+    {
+        BSP::GetInstance().SetCostModel( paramsPath, reportPath, tolerance );
+    }
+
+    /**
+     * Enables the communication matrix for the computations started after this call. At the end of a computation,
+     * the messages and bytes each processor put, got and sent to each other processor per superstep are written to
+     * `path` as CSV.
+     *
+     * @param   path The path of the output file, an empty path to use the `BSP_COMM_MATRIX` environment variable.
+     */
+
+    inline void SetCommunicationMatrix( const std::string &path )
+    {
+        BSP::GetInstance().SetCommunicationMatrix( path );
+    }
+
+    /**
+     * Enables recording for the computations started after this call. At the end of a computation, the
+     * registrations and the destinations, offsets and sizes of all communication, without payloads, are written to
+     * `path`, to be replayed with Replay.
+     *
+     * @param   path The path of the recording, an empty path to use the `BSP_RECORD` environment variable.
+     */
+
+    inline void SetRecord( const std::string &path )
+    {
+        BSP::GetInstance().SetRecord( path );
+    }
+
+    /**
+     * Enables the arrival skew histograms for the computations started after this call. At every synchronisation each
+     * processor records how long before the last processor it arrived. At the end of a computation the histograms
+     * are written to `reportPath` as CSV.
+     *
+     * @param   enabled    Whether to record the histograms, for GetSkewHistograms.
+     * @param   reportPath The path of the report, an empty path to use the `BSP_SKEW_REPORT` environment variable.
+     */
+
+    inline void SetSkewHistograms( bool enabled, const std::string &reportPath = "" )
+    {
+        BSP::GetInstance().SetSkewHistograms( enabled, reportPath );
+    }
+
+    /**
+     * Gets the arrival skew histograms of every processor of the last computation.
+     *
+     * @return The histograms, empty when they were not enabled.
+     */
+
+    inline std::vector< BspInternal::SkewHistogram > GetSkewHistograms()
+    {
+        return BSP::GetInstance().GetSkewHistograms();
+    }
+
     template< typename tPrimitive >
     void Push( tPrimitive &ident )
     {
@@ -896,6 +1052,46 @@ namespace BSPLib
         SendPtrs( pid, tagContainer, &payload, 1 );
     }
 
+    /**
+     * Sends a vector by handing over its buffer instead of copying it, which is possible because all processors
+     * share one address space. The transfer costs O(1) regardless of the size of the vector.
+     *
+     * @param   pid             The destination processor ID.
+     * @param   tag             The tag of the message.
+     * @param [in,out]  payload The payload, which is empty afterwards.
+     */
+
+    template< typename tPrimitive, typename tTag >
+    void SendMove( uint32_t pid, const tTag &tag, std::vector< tPrimitive > &&payload )
+    {
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.SendMove( local, pid, &tag, std::move( payload ) );
+    }
+
+    template< typename tPrimitive >
+    void SendMove( uint32_t pid, std::vector< tPrimitive > &&payload )
+    {
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.SendMove( local, pid, nullptr, std::move( payload ) );
+    }
+
+    /**
+     * Moves the first message in the queue to the given vector, which takes over the buffer of a message sent with
+     * SendMove of the same element type, and copies the payload of other messages.
+     *
+     * @param [out]  payload The payload destination, sized to the payload.
+     */
+
+    template< typename tPrimitive >
+    void MoveOwned( std::vector< tPrimitive > &payload )
+    {
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.MoveOwned( local, payload );
+    }
+
 #ifndef BSP_DISABLE_NAMESPACE
 }
 #endif
@@ -0,0 +1,335 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_CHANNEL_H__
+#define __BSPLIB_CHANNEL_H__
+
+#include "bsp/bspExt.h"
+
+#include <assert.h>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Serializes values of the given type for channels. A serializer has three static members:
+     *
+     * * `size_t Size( const tValue &value )`, the amount of bytes the value takes.
+     * * `char *Write( const tValue &value, char *out )`, writes the value and returns the end of its bytes.
+     * * `const char *Read( const char *in, const char *end, tValue &value )`, reads the value from the bytes up to
+     *   `end` and returns the end of its bytes, or nullptr when the bytes do not hold a value.
+     *
+     * Read decodes straight from the receive buffer, which has no alignment guarantees, and checks every length it
+     * reads against the bytes that remain; sequence lengths are bounded assuming every value takes at least a byte.
+     * Specialise this template to send other types.
+     *
+     * @tparam  tValue  The value type.
+     * @tparam  tEnable Used to select specialisations with std::enable_if.
+     */
+
+    template< typename tValue, typename tEnable = void >
+    struct Serializer;
+
+    /**
+     * Serializes a trivially copyable value as its bytes.
+     */
+
+    template< typename tValue >
+    struct Serializer< tValue, typename std::enable_if< std::is_trivially_copyable< tValue >::value >::type >
+    {
+        static size_t Size( const tValue & )
+        {
+            return sizeof( tValue );
+        }
+
+        static char *Write( const tValue &value, char *out )
+        {
+            memcpy( out, &value, sizeof( tValue ) );
+            return out + sizeof( tValue );
+        }
+
+        static const char *Read( const char *in, const char *end, tValue &value )
+        {
+            if ( static_cast< size_t >( end - in ) < sizeof( tValue ) )
+            {
+                return nullptr;
+            }
+
+            memcpy( &value, in, sizeof( tValue ) );
+            return in + sizeof( tValue );
+        }
+    };
+
+    /**
+     * Serializes a sequence as its length followed by its elements. Sequences of trivially copyable elements are
+     * copied in one go.
+     */
+
+    template< typename tSequence >
+    struct SequenceSerializer
+    {
+        typedef typename tSequence::value_type Element;
+        typedef std::integral_constant< bool, std::is_trivially_copyable< Element >::value > Flat;
+
+        static size_t Size( const tSequence &sequence )
+        {
+            return sizeof( uint64_t ) + ElementsSize( sequence, Flat() );
+        }
+
+        static char *Write( const tSequence &sequence, char *out )
+        {
+            return WriteElements( sequence, Serializer< uint64_t >::Write( sequence.size(), out ), Flat() );
+        }
+
+        static const char *Read( const char *in, const char *end, tSequence &sequence )
+        {
+            uint64_t count;
+            in = Serializer< uint64_t >::Read( in, end, count );
+
+            // every element takes at least a byte, so a larger count cannot fit in the remaining bytes
+            if ( in == nullptr || count > static_cast< uint64_t >( end - in ) / ( Flat::value ? sizeof( Element ) : 1 ) )
+            {
+                return nullptr;
+            }
+
+            sequence.resize( static_cast< size_t >( count ) );
+
+            return ReadElements( in, end, sequence, Flat() );
+        }
+
+    private:
+
+        static size_t ElementsSize( const tSequence &sequence, std::true_type )
+        {
+            return sequence.size() * sizeof( Element );
+        }
+
+        static size_t ElementsSize( const tSequence &sequence, std::false_type )
+        {
+            size_t size = 0;
+
+            for ( const Element &element : sequence )
+            {
+                size += Serializer< Element >::Size( element );
+            }
+
+            return size;
+        }
+
+        static char *WriteElements( const tSequence &sequence, char *out, std::true_type )
+        {
+            const size_t nbytes = sequence.size() * sizeof( Element );
+
+            if ( nbytes > 0 )
+            {
+                memcpy( out, &*sequence.begin(), nbytes );
+            }
+
+            return out + nbytes;
+        }
+
+        static char *WriteElements( const tSequence &sequence, char *out, std::false_type )
+        {
+            for ( const Element &element : sequence )
+            {
+                out = Serializer< Element >::Write( element, out );
+            }
+
+            return out;
+        }
+
+        static const char *ReadElements( const char *in, const char *, tSequence &sequence, std::true_type )
+        {
+            const size_t nbytes = sequence.size() * sizeof( Element );
+
+            if ( nbytes > 0 )
+            {
+                memcpy( &*sequence.begin(), in, nbytes );
+            }
+
+            return in + nbytes;
+        }
+
+        static const char *ReadElements( const char *in, const char *end, tSequence &sequence, std::false_type )
+        {
+            for ( Element &element : sequence )
+            {
+                in = Serializer< Element >::Read( in, end, element );
+
+                if ( in == nullptr )
+                {
+                    return nullptr;
+                }
+            }
+
+            return in;
+        }
+    };
+
+    template< typename tChar, typename tTraits, typename tAllocator >
+    struct Serializer< std::basic_string< tChar, tTraits, tAllocator > >
+        : SequenceSerializer< std::basic_string< tChar, tTraits, tAllocator > >
+    {
+    };
+
+    template< typename tElement, typename tAllocator >
+    struct Serializer< std::vector< tElement, tAllocator > >
+        : SequenceSerializer< std::vector< tElement, tAllocator > >
+    {
+    };
+
+    /**
+     * Serializes a pair that is not trivially copyable as its first value followed by its second value.
+     */
+
+    template< typename tFirst, typename tSecond >
+    struct Serializer < std::pair< tFirst, tSecond >,
+        typename std::enable_if < !std::is_trivially_copyable< std::pair< tFirst, tSecond > >::value >::type >
+    {
+        static size_t Size( const std::pair< tFirst, tSecond > &pair )
+        {
+            return Serializer< tFirst >::Size( pair.first ) + Serializer< tSecond >::Size( pair.second );
+        }
+
+        static char *Write( const std::pair< tFirst, tSecond > &pair, char *out )
+        {
+            return Serializer< tSecond >::Write( pair.second, Serializer< tFirst >::Write( pair.first, out ) );
+        }
+
+        static const char *Read( const char *in, const char *end, std::pair< tFirst, tSecond > &pair )
+        {
+            in = Serializer< tFirst >::Read( in, end, pair.first );
+            return in == nullptr ? nullptr : Serializer< tSecond >::Read( in, end, pair.second );
+        }
+    };
+
+    /**
+     * A typed view on the message queue, that serializes the values it sends and decodes the messages it receives
+     * straight from the receive buffer. Every value is one message, of which the tag is sent as the BSP tag.
+     *
+     * @tparam  tTag   The tag type, which is trivially copyable.
+     * @tparam  tValue The value type, for which Serializer is specialised.
+     *
+     * @pre
+     * * The tag size is sizeof( tTag ) when sending and receiving.
+     * * The messages in the queue were sent by channels of the same value type.
+     */
+
+    template< typename tTag, typename tValue >
+    class Channel
+    {
+    public:
+
+        Channel()
+            : mBSP( BSP::GetInstance() ),
+              mLocal( mBSP.GetLocal( mBSP.ProcId() ) )
+        {
+        }
+
+        /**
+         * Sends a value, which is serialized on the call straight into the send buffer.
+         *
+         * @param   pid   The destination processor ID.
+         * @param   tag   The tag.
+         * @param   value The value.
+         */
+
+        void Send( uint32_t pid, const tTag &tag, const tValue &value )
+        {
+            if ( std::is_trivially_copyable< tValue >::value )
+            {
+                mBSP.Send( mLocal, pid, &tag, &value, sizeof( tValue ) );
+                return;
+            }
+
+            const size_t size = Serializer< tValue >::Size( value );
+            char *payload = mBSP.SendInPlace( mLocal, pid, &tag, size );
+            char *end = Serializer< tValue >::Write( value, payload );
+
+            assert( end == payload + size );
+            ( void )end;
+        }
+
+        /**
+         * Receives the next value in the queue.
+         *
+         * @param [out]  tag   The tag.
+         * @param [out]  value The value.
+         *
+         * @return false when the queue has no more messages.
+         */
+
+        bool Receive( tTag &tag, tValue &value )
+        {
+            const char *tagData;
+            const char *payload;
+            const size_t size = mBSP.MoveInPlace( mLocal, &tagData, &payload );
+
+            if ( size == ( size_t ) - 1 )
+            {
+                return false;
+            }
+
+            memcpy( &tag, tagData, sizeof( tTag ) );
+
+            // a message of another value type does not end where the value does
+            if ( Serializer< tValue >::Read( payload, payload + size, value ) != payload + size )
+            {
+                mBSP.Abort( "Error: a channel received a message of %zu bytes that does not hold its value type.\n",
+                            size );
+            }
+
+            return true;
+        }
+
+        /**
+         * Receives the next value in the queue, and skips its tag.
+         *
+         * @param [out]  value The value.
+         *
+         * @return false when the queue has no more messages.
+         */
+
+        bool Receive( tValue &value )
+        {
+            tTag tag;
+            return Receive( tag, value );
+        }
+
+    private:
+
+        BSP &mBSP;
+        BSP::Local mLocal;
+    };
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,272 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_COMMUNICATIONMATRIX_H__
+#define __BSPLIB_COMMUNICATIONMATRIX_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * The communication from one processor to another in one superstep. Gets are counted for the processor that
+     * requested them, with the processor that owns the memory as target.
+     */
+
+    struct CommunicationCell
+    {
+        uint64_t puts;
+        uint64_t putBytes;
+        uint64_t gets;
+        uint64_t getBytes;
+        uint64_t sends;
+        uint64_t sendBytes;
+        uint64_t exchanges;
+        uint64_t exchangeBytes;
+
+        bool IsEmpty() const
+        {
+            return puts == 0 && gets == 0 && sends == 0 && exchanges == 0;
+        }
+    };
+
+    /**
+     * Records the p x p matrix of messages and bytes between the processors in every superstep. At synchronisation
+     * every processor adds up its own outgoing queues, so recording needs no synchronisation, and only the cells of
+     * processors that communicated are stored.
+     */
+
+    class CommunicationMatrix
+    {
+    public:
+
+        struct Entry
+        {
+            uint32_t superstep;
+            uint32_t target;
+            CommunicationCell cell;
+        };
+
+        CommunicationMatrix()
+            : mEnabled( false )
+        {
+        }
+
+        /**
+         * Starts recording a computation.
+         *
+         * @param   nProcs The amount of processors.
+         * @param   path   The path of the output file, an empty path disables recording.
+         */
+
+        void Reset( uint32_t nProcs, const std::string &path )
+        {
+            mPath = path;
+            mEnabled = !path.empty();
+            mProcessors.clear();
+
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            for ( uint32_t pid = 0; pid < nProcs; ++pid )
+            {
+                mProcessors.emplace_back( new Processor() );
+            }
+        }
+
+        bool IsEnabled() const
+        {
+            return mEnabled;
+        }
+
+        /**
+         * Records the outgoing queues of a processor in the current superstep, and moves it to the next superstep.
+         *
+         * @param   pid         The processor ID.
+         * @param   putQueues   The put queues of the processor per target, or nullptr.
+         * @param   getQueues   The get queues of the processor per target, or nullptr.
+         * @param   sendQueues  The send queues of the processor per target, or nullptr.
+         * @param   groupQueues The MultiBSP group put queues of the processor per target, or nullptr.
+         * @param   exchangeQueues The exchange spans of the processor per target, or nullptr.
+         */
+
+        template< typename tPutQueue, typename tGetQueue, typename tSendQueue, typename tExchangeQueue >
+        void Capture( uint32_t pid, const tPutQueue *putQueues, const tGetQueue *getQueues, const tSendQueue *sendQueues,
+                      const tPutQueue *groupQueues, const tExchangeQueue *exchangeQueues )
+        {
+            Processor &processor = *mProcessors[pid];
+
+            for ( uint32_t target = 0, end = static_cast< uint32_t >( mProcessors.size() ); target < end; ++target )
+            {
+                CommunicationCell cell = CommunicationCell();
+
+                AddPuts( cell, putQueues, target );
+                AddPuts( cell, groupQueues, target );
+
+                if ( getQueues )
+                {
+                    for ( const auto &request : getQueues[target] )
+                    {
+                        ++cell.gets;
+                        cell.getBytes += request.size;
+                    }
+                }
+
+                if ( sendQueues )
+                {
+                    for ( const auto &request : sendQueues[target] )
+                    {
+                        ++cell.sends;
+                        cell.sendBytes += request.bufferSize + request.tagSize;
+                    }
+                }
+
+                if ( exchangeQueues )
+                {
+                    for ( const auto &request : exchangeQueues[target] )
+                    {
+                        ++cell.exchanges;
+                        cell.exchangeBytes += request.size;
+                    }
+                }
+
+                if ( !cell.IsEmpty() )
+                {
+                    processor.entries.push_back( Entry{ processor.superstep, target, cell } );
+                }
+            }
+
+            ++processor.superstep;
+        }
+
+        /**
+         * Gets the recorded cells of which a processor is the source.
+         *
+         * @param   pid The processor ID.
+         *
+         * @return The non empty cells, ordered by superstep and target.
+         */
+
+        const std::vector< Entry > &GetEntries( uint32_t pid ) const
+        {
+            return mProcessors[pid]->entries;
+        }
+
+        /**
+         * Writes the matrix as CSV, with a line per superstep, source and target that communicated.
+         *
+         * @pre All processors have ended.
+         */
+
+        void Export() const
+        {
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            FILE *file = fopen( mPath.c_str(), "w" );
+
+            if ( !file )
+            {
+                fprintf( stderr, "Warning: could not write the communication matrix to `%s`.\n", mPath.c_str() );
+                return;
+            }
+
+            fprintf( file, "superstep,source,target,puts,put_bytes,gets,get_bytes,sends,send_bytes,exchanges,"
+                     "exchange_bytes\n" );
+
+            // the entries of every processor are ordered by superstep, so merging them orders the file
+            std::vector< size_t > cursors( mProcessors.size(), 0 );
+            uint32_t stepCount = 0;
+
+            for ( const auto &processor : mProcessors )
+            {
+                stepCount = std::max( stepCount, processor->superstep );
+            }
+
+            for ( uint32_t step = 0; step < stepCount; ++step )
+            {
+                for ( size_t pid = 0; pid < mProcessors.size(); ++pid )
+                {
+                    const std::vector< Entry > &entries = mProcessors[pid]->entries;
+
+                    for ( size_t &i = cursors[pid]; i < entries.size() && entries[i].superstep == step; ++i )
+                    {
+                        const CommunicationCell &cell = entries[i].cell;
+
+                        fprintf( file, "%u,%zu,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", step, pid, entries[i].target,
+                                 Count( cell.puts ), Count( cell.putBytes ), Count( cell.gets ), Count( cell.getBytes ),
+                                 Count( cell.sends ), Count( cell.sendBytes ), Count( cell.exchanges ),
+                                 Count( cell.exchangeBytes ) );
+                    }
+                }
+            }
+
+            fclose( file );
+        }
+
+    private:
+
+        struct Processor
+        {
+            Processor()
+                : superstep( 0 )
+            {
+            }
+
+            std::vector< Entry > entries;
+            uint32_t superstep;
+        };
+
+        std::vector< std::unique_ptr< Processor > > mProcessors;
+        std::string mPath;
+        bool mEnabled;
+
+        template< typename tPutQueue >
+        static void AddPuts( CommunicationCell &cell, const tPutQueue *queues, uint32_t target )
+        {
+            if ( queues )
+            {
+                for ( const auto &request : queues[target] )
+                {
+                    ++cell.puts;
+                    cell.putBytes += request.size;
+                }
+            }
+        }
+
+        static unsigned long long Count( uint64_t value )
+        {
+            return static_cast< unsigned long long >( value );
+        }
+    };
+}
+
+#endif
@@ -23,6 +23,7 @@
 #ifndef __BSPLIB_COMMUNICATIONQUEUES_H__
 #define __BSPLIB_COMMUNICATIONQUEUES_H__
 
+#include <memory>
 #include <vector>
 
 
@@ -32,6 +33,10 @@ namespace BspInternal
      * A communication queue implementation. Allows easier
      * implementation of communication queues of various types.
      *
+     * The queues of a processor are only created when it first communicates, so the memory
+     * scales with the processors that communicate instead of with the square of the
+     * processor count.
+     *
      * @tparam  tQueue Type of the queue.
      */
 
@@ -52,8 +57,7 @@ namespace BspInternal
          */
 
         explicit CommunicationQueues( std::size_t nProcs )
-            : mQueues( 0 ),
-              mProcCount( nProcs )
+            : mProcCount( nProcs )
         {
             ResetResize( nProcs );
         }
@@ -67,9 +71,8 @@ namespace BspInternal
 
         void ResetResize( std::size_t maxProcs )
         {
-            std::size_t maxProcsSqr = maxProcs * maxProcs;
-            mQueues.clear();
-            mQueues.resize( maxProcsSqr );
+            mRows.clear();
+            mRows.resize( maxProcs );
 
             mProcCount = maxProcs;
         }
@@ -80,16 +83,18 @@ namespace BspInternal
          * @param   source Source to get the queues from.
          * @param   me     Processors to get the queues to.
          *
-         * @return The queue.
+         * @return The queue, or nullptr when the source has not communicated yet.
          */
 
-        inline tQueue &GetQueueToMe( std::size_t source, std::size_t me )
+        inline tQueue *TryGetQueueToMe( std::size_t source, std::size_t me )
         {
-            return GetQueue( source, me );
+            tQueue *row = mRows[source].get();
+            return row ? row + me : nullptr;
         }
 
         /**
          * Gets the queues of the current processor communicating to the source processor.
+         * Creates the queues of the current processor on first use.
          *
          * @param   target The processor to get the queues for.
          * @param   me     The processor to get the queues from.
@@ -99,24 +104,53 @@ namespace BspInternal
 
         inline tQueue &GetQueueFromMe( std::size_t target, std::size_t me )
         {
-            return GetQueue( me, target );
+            std::unique_ptr< tQueue[] > &row = mRows[me];
+
+            if ( !row )
+            {
+                row.reset( new tQueue[mProcCount] );
+            }
+
+            return row[target];
         }
 
-    private:
+        /**
+         * Gets the queues of the current processor to all processors, indexed by the target processor.
+         * Creates the queues of the current processor on first use. The queues stay valid until
+         * ResetResize is called.
+         *
+         * @param   me The processor to get the queues from.
+         *
+         * @return The queues.
+         */
 
-        /// an abomination we have to live with,
-        /// a flattened std::vector< std::vector <> > but without
-        /// inneficient cache thrashing.
-        std::vector< tQueue > mQueues;
+        inline tQueue *GetQueuesFromMe( std::size_t me )
+        {
+            return &GetQueueFromMe( 0, me );
+        }
 
-        /// The amount of processors that may use the queue
-        std::size_t mProcCount;
+        /**
+         * Gets the queues of the current processor to all processors, indexed by the target processor.
+         *
+         * @param   me The processor to get the queues from.
+         *
+         * @return The queues, or nullptr when the processor has not communicated yet.
+         */
 
-        tQueue &GetQueue( std::size_t owner, std::size_t target )
+        inline tQueue *TryGetQueuesFromMe( std::size_t me )
         {
-            return mQueues[owner * mProcCount + target];
+            return mRows[me].get();
         }
+
+    private:
+
+        /// The queues per owning processor, a flattened p * p matrix
+        /// of which only the rows of communicating processors exist.
+        std::vector< std::unique_ptr< tQueue[] > > mRows;
+
+        /// The amount of processors that may use the queue
+        std::size_t mProcCount;
     };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,251 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_CONTEXT_H__
+#define __BSPLIB_CONTEXT_H__
+
+#include "bsp/processor.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * An independent BSP computation environment, with its own barrier, communication queues and registers. Several
+     * contexts can run computations side by side in the same process, for example each on its own set of cores.
+     * While a thread is bound to a context, the classic and modern interfaces operate on that context.
+     */
+
+    class Context
+    {
+    public:
+
+        /**
+         * Binds the calling thread to a context for the lifetime of the binding. The previous binding and processor
+         * ID of the thread are restored on destruction.
+         */
+
+        class Binding
+        {
+        public:
+
+            explicit Binding( Context &context )
+                : mPrevious( BSP::Current() ),
+                  mPreviousPid( BSP::GetInstance().ProcId() )
+            {
+                BSP::Current() = context.mBSP.get();
+            }
+
+            ~Binding()
+            {
+                BSP::Current() = mPrevious;
+                BSP::GetInstance().ProcId() = mPreviousPid;
+            }
+
+        private:
+
+            BSP *mPrevious;
+            uint32_t mPreviousPid;
+
+            Binding( const Binding & );
+            Binding &operator=( const Binding & );
+        };
+
+        Context()
+            : mBSP( new BSP )
+        {
+            mBSP->SetOutputSuffix( NextOutputSuffix() );
+        }
+
+        /**
+         * Constructs a context of which the processors are pinned on the given logical processors.
+         *
+         * @param   cpus The logical processor identifiers.
+         */
+
+        explicit Context( const std::vector< uint32_t > &cpus )
+            : mBSP( new BSP )
+        {
+            mBSP->SetOutputSuffix( NextOutputSuffix() );
+            mBSP->SetAffinity( cpus );
+        }
+
+        /**
+         * Executes the by func given BSP program in this context. The calling thread becomes processor 0, and is
+         * bound to this context for the duration of the computation.
+         *
+         * @param   func  The function to execute BSP style.
+         * @param   nProc The number of processors to use.
+         *
+         * @return true if it succeeds, false if it fails.
+         */
+
+        bool Execute( std::function< void() > func, uint32_t nProc )
+        {
+            Binding binding( *this );
+            return BSP_NAMESPACE::Execute( func, nProc );
+        }
+
+        /**
+         * Executes the by func given BSP program in this context, and passes every processor a handle to itself.
+         *
+         * @param   func  The function to execute BSP style.
+         * @param   nProc The number of processors to use.
+         *
+         * @return true if it succeeds, false if it fails.
+         */
+
+        bool Execute( std::function< void( Processor & ) > func, uint32_t nProc )
+        {
+            Binding binding( *this );
+            return BSP_NAMESPACE::Execute( func, nProc );
+        }
+
+        /**
+         * Sets the placement policy of the processors of this context.
+         *
+         * @param   policy The placement policy.
+         */
+
+        void SetAffinity( AffinityPolicy policy )
+        {
+            mBSP->SetAffinity( policy );
+        }
+
+        /**
+         * Pins processor `pid` of this context on logical processor `cpus[pid % cpus.size()]`.
+         *
+         * @param   cpus The logical processor identifiers.
+         */
+
+        void SetAffinity( const std::vector< uint32_t > &cpus )
+        {
+            mBSP->SetAffinity( cpus );
+        }
+
+        /**
+         * Sets the amount of worker threads that run the processors of this context.
+         *
+         * @param   count The amount of workers, 0 to use one thread per processor.
+         */
+
+        void SetWorkers( uint32_t count )
+        {
+            mBSP->SetWorkers( count );
+        }
+
+        /**
+         * Enables the profiler for the computations of this context.
+         *
+         * @param   prefix The path prefix of the output files.
+         */
+
+        void SetProfile( const std::string &prefix )
+        {
+            mBSP->SetProfile( prefix );
+        }
+
+        /**
+         * Enables the cost model for the computations of this context.
+         *
+         * @param   paramsPath The path of the machine parameters.
+         * @param   reportPath The path of the report, an empty path to use the `BSP_COST_REPORT` environment variable
+         *                     with the suffix of this context, or stderr when it is not set.
+         * @param   tolerance  The ratio of measured to predicted time above which a superstep is reported.
+         */
+
+        void SetCostModel( const std::string &paramsPath, const std::string &reportPath = "", double tolerance = 0.0 )
+        {
+            mBSP->SetCostModel( paramsPath, reportPath, tolerance );
+        }
+
+        /**
+         * Enables the communication matrix for the computations of this context.
+         *
+         * @param   path The path of the output file.
+         */
+
+        void SetCommunicationMatrix( const std::string &path )
+        {
+            mBSP->SetCommunicationMatrix( path );
+        }
+
+        /**
+         * Enables recording for the computations of this context.
+         *
+         * @param   path The path of the recording.
+         */
+
+        void SetRecord( const std::string &path )
+        {
+            mBSP->SetRecord( path );
+        }
+
+        /**
+         * Enables the arrival skew histograms for the computations of this context.
+         *
+         * @param   enabled    Whether to record the histograms.
+         * @param   reportPath The path of the report, an empty path to use the `BSP_SKEW_REPORT` environment variable
+         *                     with the suffix of this context.
+         */
+
+        void SetSkewHistograms( bool enabled, const std::string &reportPath = "" )
+        {
+            mBSP->SetSkewHistograms( enabled, reportPath );
+        }
+
+        /**
+         * Gets the arrival skew histograms of the last computation of this context.
+         *
+         * @return The histograms.
+         */
+
+        std::vector< BspInternal::SkewHistogram > GetSkewHistograms() const
+        {
+            return mBSP->GetSkewHistograms();
+        }
+
+    private:
+
+        std::unique_ptr< BSP > mBSP;
+
+        /// Gets a suffix for the output files of a new context, unique within the process.
+        static std::string NextOutputSuffix()
+        {
+            static std::atomic< uint32_t > count( 0 );
+            return "-context" + std::to_string( ++count );
+        }
+
+        Context( const Context & );
+        Context &operator=( const Context & );
+    };
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,345 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_COSTMODEL_H__
+#define __BSPLIB_COSTMODEL_H__
+
+#include "bsp/profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * The BSP parameters of a machine, as measured by bspbench. The computing rate r is in flop/s, and the
+     * communication cost g per word and the synchronisation cost l are in flops.
+     */
+
+    struct MachineParams
+    {
+        MachineParams()
+            : p( 0 ),
+              r( 0.0 ),
+              g( 0.0 ),
+              l( 0.0 ),
+              word( 8.0 )
+        {
+        }
+
+        uint32_t p;
+        double r;
+        double g;
+        double l;
+
+        /// The size of a word in bytes
+        double word;
+
+        /**
+         * Reads the parameters from a file with a `name value` pair per line.
+         *
+         * @param   path The path of the file.
+         *
+         * @return true if r, g and l were read, and r and the word size are positive, false otherwise.
+         */
+
+        bool Load( const std::string &path )
+        {
+            FILE *file = fopen( path.c_str(), "r" );
+
+            if ( !file )
+            {
+                return false;
+            }
+
+            char name[32];
+            double value;
+            bool readR = false;
+            bool readG = false;
+            bool readL = false;
+
+            while ( fscanf( file, "%31s %lf", name, &value ) == 2 )
+            {
+                if ( !strcmp( name, "p" ) )
+                {
+                    p = static_cast< uint32_t >( value );
+                }
+                else if ( !strcmp( name, "r" ) )
+                {
+                    r = value;
+                    readR = true;
+                }
+                else if ( !strcmp( name, "g" ) )
+                {
+                    g = value;
+                    readG = true;
+                }
+                else if ( !strcmp( name, "l" ) )
+                {
+                    l = value;
+                    readL = true;
+                }
+                else if ( !strcmp( name, "word" ) )
+                {
+                    word = value;
+                }
+            }
+
+            fclose( file );
+
+            return readR && readG && readL && r > 0.0 && word > 0.0;
+        }
+
+        /**
+         * Writes the parameters to a file that Load can read.
+         *
+         * @param   path The path of the file.
+         *
+         * @return true if it succeeds, false if it fails.
+         */
+
+        bool Save( const std::string &path ) const
+        {
+            FILE *file = fopen( path.c_str(), "w" );
+
+            if ( !file )
+            {
+                return false;
+            }
+
+            fprintf( file, "p %u\nr %.17g\ng %.17g\nl %.17g\nword %g\n", p, r, g, l, word );
+            fclose( file );
+
+            return true;
+        }
+
+        /**
+         * Predicts the time of the communication and synchronisation of a superstep, T = ( h g + l ) / r.
+         *
+         * @param   hBytes The h-relation in bytes.
+         *
+         * @return The time in microseconds.
+         */
+
+        double Predict( uint64_t hBytes ) const
+        {
+            return ( static_cast< double >( hBytes ) / word * g + l ) / r * 1e6;
+        }
+    };
+
+    /**
+     * The cost of one superstep, combined over all processors.
+     */
+
+    struct SuperstepCost
+    {
+        /// The longest compute phase in microseconds
+        double work;
+
+        /// The largest amount of bytes a processor sent or received
+        uint64_t h;
+
+        /// The predicted communication and synchronisation time in microseconds
+        double predicted;
+
+        /// The measured time from the last processor entering the synchronisation until the last leaving it
+        double actual;
+
+        bool deviates;
+    };
+
+    /**
+     * Applies the BSP cost model to the recorded supersteps. For every superstep the h-relation is the largest
+     * amount of data a processor sent or received, and its communication and synchronisation are predicted to take
+     * ( h g + l ) / r. Supersteps of which the measured synchronisation takes longer than `tolerance` times the
+     * prediction are flagged.
+     */
+
+    class CostModel
+    {
+    public:
+
+        CostModel()
+            : mTolerance( 2.0 ),
+              mEnabled( false )
+        {
+        }
+
+        /**
+         * Prepares the cost model for a computation.
+         *
+         * @param   nProcs     The amount of processors of the computation.
+         * @param   paramsPath The path of the parameters written by bspbench, an empty path disables the model.
+         * @param   reportPath The path to write the report to, an empty path writes to stderr.
+         * @param   tolerance  The ratio of measured to predicted time above which a superstep is flagged.
+         */
+
+        void Reset( uint32_t nProcs, const std::string &paramsPath, const std::string &reportPath, double tolerance )
+        {
+            mReportPath = reportPath;
+            mTolerance = tolerance;
+            mParams = MachineParams();
+            mEnabled = false;
+
+            if ( paramsPath.empty() )
+            {
+                return;
+            }
+
+            mEnabled = mParams.Load( paramsPath );
+
+            if ( !mEnabled )
+            {
+                fprintf( stderr, "Warning: could not read r, g and l from the BSP parameters in `%s`.\n",
+                         paramsPath.c_str() );
+            }
+            else if ( mParams.p != 0 && mParams.p != nProcs )
+            {
+                // g and l grow with the amount of processors, so the predictions are off
+                fprintf( stderr, "Warning: the BSP parameters in `%s` were measured on %u processors, but the "
+                         "computation runs on %u.\n", paramsPath.c_str(), mParams.p, nProcs );
+            }
+        }
+
+        bool IsEnabled() const
+        {
+            return mEnabled;
+        }
+
+        const MachineParams &GetParams() const
+        {
+            return mParams;
+        }
+
+        /**
+         * Computes the cost of every recorded superstep.
+         *
+         * @param   profiler The records.
+         *
+         * @return The costs per superstep.
+         */
+
+        std::vector< SuperstepCost > Evaluate( const Profiler &profiler ) const
+        {
+            std::vector< SuperstepCost > costs;
+            const uint32_t nProcs = profiler.GetProcessorCount();
+
+            for ( size_t step = 0; ; ++step )
+            {
+                SuperstepCost cost = SuperstepCost();
+                double lastArrival = 0.0;
+                double lastDeparture = 0.0;
+                bool found = false;
+
+                for ( uint32_t pid = 0; pid < nProcs; ++pid )
+                {
+                    const std::vector< SuperstepProfile > &steps = profiler.GetSupersteps( pid );
+
+                    if ( step >= steps.size() )
+                    {
+                        continue;
+                    }
+
+                    const SuperstepProfile &profile = steps[step];
+                    found = true;
+
+                    cost.work = std::max( cost.work, profile.syncStart - profile.start );
+                    cost.h = std::max( cost.h, std::max( profile.SentBytes(), profile.receivedBytes ) );
+                    lastArrival = std::max( lastArrival, profile.syncStart );
+                    lastDeparture = std::max( lastDeparture, profile.end );
+                }
+
+                if ( !found )
+                {
+                    break;
+                }
+
+                cost.predicted = mParams.Predict( cost.h );
+                cost.actual = lastDeparture - lastArrival;
+                cost.deviates = cost.actual > mTolerance * cost.predicted;
+
+                costs.push_back( cost );
+            }
+
+            return costs;
+        }
+
+        /**
+         * Writes the cost of every superstep, and marks the supersteps that deviate from the model.
+         *
+         * @param   profiler The records.
+         */
+
+        void Report( const Profiler &profiler ) const
+        {
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            FILE *file = mReportPath.empty() ? stderr : fopen( mReportPath.c_str(), "w" );
+
+            if ( !file )
+            {
+                fprintf( stderr, "Warning: could not write the cost report to `%s`.\n", mReportPath.c_str() );
+                return;
+            }
+
+            const std::vector< SuperstepCost > costs = Evaluate( profiler );
+            size_t deviating = 0;
+
+            fprintf( file, "BSP cost model: p= %u, r= %.3f Mflop/s, g= %.1f, l= %.1f\n", mParams.p, mParams.r / 1e6,
+                     mParams.g, mParams.l );
+            fprintf( file, "superstep,work_us,h_bytes,predicted_us,actual_us,ratio,deviates\n" );
+
+            for ( size_t step = 0; step < costs.size(); ++step )
+            {
+                const SuperstepCost &cost = costs[step];
+                deviating += cost.deviates ? 1 : 0;
+
+                fprintf( file, "%zu,%.3f,%llu,%.3f,%.3f,%.2f,%d\n", step, cost.work,
+                         static_cast< unsigned long long >( cost.h ), cost.predicted, cost.actual,
+                         cost.predicted > 0.0 ? cost.actual / cost.predicted : 0.0, cost.deviates ? 1 : 0 );
+            }
+
+            fprintf( file, "%zu of %zu supersteps took more than %.1f times the predicted time.\n", deviating,
+                     costs.size(), mTolerance );
+
+            if ( file != stderr )
+            {
+                fclose( file );
+            }
+        }
+
+    private:
+
+        MachineParams mParams;
+        std::string mReportPath;
+        double mTolerance;
+        bool mEnabled;
+    };
+}
+
+#endif
@@ -0,0 +1,281 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_DISTRIBUTEDARRAY_H__
+#define __BSPLIB_DISTRIBUTEDARRAY_H__
+
+#include "bsp/bspExt.h"
+#include "bsp/distribution.h"
+
+#include <assert.h>
+#include <deque>
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * An array of which the elements are distributed over all processors. Every processor stores the elements it
+     * owns in local storage, which is registered, so that other processors can read and write them. The distribution
+     * is a template argument, so the index arithmetic is inlined.
+     *
+     * Remote reads and writes complete at the next synchronisation, like Get and Put. Range reads of a
+     * distribution that is not contiguous land in a staging buffer, and complete at Sync of the array.
+     *
+     * @tparam  tPrimitive    The element type, which is trivially copyable.
+     * @tparam  tDistribution The distribution, such as BlockDistribution, CyclicDistribution or
+     *                        BlockCyclicDistribution.
+     */
+
+    template< typename tPrimitive, typename tDistribution = BlockDistribution >
+    class DistributedArray
+    {
+    public:
+
+        /**
+         * Creates the local storage and registers it. Remote access is possible after the next synchronisation.
+         *
+         * @param   size The global amount of elements.
+         *
+         * @pre All processors create the array in the same order.
+         */
+
+        explicit DistributedArray( size_t size )
+            : mDistribution( size, NProcs() ),
+              mPid( ProcId() ),
+              mLocalSize( mDistribution.LocalSize( mPid ) ),
+              // registrations are identified by their address, so empty parts still need storage
+              mLocal( std::max< size_t >( 1, mLocalSize ) )
+        {
+            Classic::Push( mLocal.data(), mLocalSize * sizeof( tPrimitive ) );
+        }
+
+        /**
+         * Deregisters the local storage.
+         *
+         * @pre All processors destroy the array in the same order.
+         */
+
+        ~DistributedArray()
+        {
+            Classic::Pop( mLocal.data() );
+        }
+
+        size_t Size() const
+        {
+            return mDistribution.Size();
+        }
+
+        const tDistribution &GetDistribution() const
+        {
+            return mDistribution;
+        }
+
+        size_t LocalSize() const
+        {
+            return mLocalSize;
+        }
+
+        tPrimitive *LocalData()
+        {
+            return mLocal.data();
+        }
+
+        const tPrimitive *LocalData() const
+        {
+            return mLocal.data();
+        }
+
+        /**
+         * Gets a local element by its local index.
+         */
+
+        tPrimitive &operator[]( size_t local )
+        {
+            return mLocal[local];
+        }
+
+        const tPrimitive &operator[]( size_t local ) const
+        {
+            return mLocal[local];
+        }
+
+        size_t GlobalIndex( size_t local ) const
+        {
+            return mDistribution.GlobalIndex( mPid, local );
+        }
+
+        bool IsLocal( size_t global ) const
+        {
+            return mDistribution.Owner( global ) == mPid;
+        }
+
+        /**
+         * Writes an element. The value is copied on the call.
+         *
+         * @param   global The global index.
+         * @param   value  The value.
+         */
+
+        void Put( size_t global, const tPrimitive &value )
+        {
+            Classic::Put( mDistribution.Owner( global ), &value, mLocal.data(),
+                          mDistribution.LocalIndex( global ) * sizeof( tPrimitive ), sizeof( tPrimitive ) );
+        }
+
+        /**
+         * Reads an element, which arrives in the next synchronisation.
+         *
+         * @param   global      The global index.
+         * @param [out]  value  The value.
+         */
+
+        void Get( size_t global, tPrimitive &value )
+        {
+            Classic::Get( mDistribution.Owner( global ), mLocal.data(),
+                          mDistribution.LocalIndex( global ) * sizeof( tPrimitive ), &value, sizeof( tPrimitive ) );
+        }
+
+        /**
+         * Writes the elements of a global range, with one put per owner.
+         *
+         * @param   first The first global index.
+         * @param   count The amount of elements.
+         * @param   src   The values, copied on the call.
+         */
+
+        void PutRange( size_t first, size_t count, const tPrimitive *src )
+        {
+            std::vector< tPrimitive > packed;
+
+            for ( uint32_t owner = 0; owner < mDistribution.NProcs(); ++owner )
+            {
+                const size_t begin = mDistribution.LocalCount( owner, first );
+                const size_t end = mDistribution.LocalCount( owner, first + count );
+
+                if ( begin == end )
+                {
+                    continue;
+                }
+
+                const tPrimitive *values = src + ( mDistribution.GlobalIndex( owner, begin ) - first );
+
+                if ( !tDistribution::Contiguous )
+                {
+                    packed.clear();
+
+                    for ( size_t local = begin; local < end; ++local )
+                    {
+                        packed.push_back( src[mDistribution.GlobalIndex( owner, local ) - first] );
+                    }
+
+                    values = packed.data();
+                }
+
+                Classic::Put( owner, values, mLocal.data(), begin * sizeof( tPrimitive ),
+                              ( end - begin ) * sizeof( tPrimitive ) );
+            }
+        }
+
+        /**
+         * Reads the elements of a global range, with one get per owner. For contiguous distributions the values
+         * arrive in the next synchronisation, for others in the next Sync of this array.
+         *
+         * @param   first       The first global index.
+         * @param   count       The amount of elements.
+         * @param [out]  dst    The values.
+         */
+
+        void GetRange( size_t first, size_t count, tPrimitive *dst )
+        {
+            for ( uint32_t owner = 0; owner < mDistribution.NProcs(); ++owner )
+            {
+                const size_t begin = mDistribution.LocalCount( owner, first );
+                const size_t end = mDistribution.LocalCount( owner, first + count );
+
+                if ( begin == end )
+                {
+                    continue;
+                }
+
+                tPrimitive *values = dst + ( mDistribution.GlobalIndex( owner, begin ) - first );
+
+                if ( !tDistribution::Contiguous )
+                {
+                    mPendingReads.emplace_back( PendingRead{ owner, begin, std::vector< tPrimitive >( end - begin ),
+                                                             dst, first } );
+                    values = mPendingReads.back().buffer.data();
+                }
+
+                Classic::Get( owner, mLocal.data(), begin * sizeof( tPrimitive ), values,
+                              ( end - begin ) * sizeof( tPrimitive ) );
+            }
+        }
+
+        /**
+         * Synchronises, and completes the range reads of this array.
+         */
+
+        void Sync()
+        {
+            Classic::Sync();
+
+            for ( const PendingRead &read : mPendingReads )
+            {
+                for ( size_t i = 0; i < read.buffer.size(); ++i )
+                {
+                    read.dst[mDistribution.GlobalIndex( read.owner, read.begin + i ) - read.first] = read.buffer[i];
+                }
+            }
+
+            mPendingReads.clear();
+        }
+
+    private:
+
+        struct PendingRead
+        {
+            uint32_t owner;
+            size_t begin;
+            std::vector< tPrimitive > buffer;
+            tPrimitive *dst;
+            size_t first;
+        };
+
+        tDistribution mDistribution;
+        uint32_t mPid;
+        size_t mLocalSize;
+        std::vector< tPrimitive > mLocal;
+        // a deque, since the pending gets write to the buffers of earlier reads while later ones are queued
+        std::deque< PendingRead > mPendingReads;
+
+        DistributedArray( const DistributedArray & );
+        DistributedArray &operator=( const DistributedArray & );
+    };
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_DISTRIBUTION_H__
+#define __BSPLIB_DISTRIBUTION_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Distributes the global indices 0 .. size - 1 in blocks of ceil( size / p ) consecutive indices, of which
+     * processor s owns block s.
+     */
+
+    class BlockDistribution
+    {
+    public:
+
+        /// Whether the indices of every processor are consecutive.
+        static const bool Contiguous = true;
+
+        BlockDistribution( size_t size, uint32_t nProcs )
+            : mSize( size ),
+              mNProcs( nProcs ),
+              mBlock( std::max< size_t >( 1, ( size + nProcs - 1 ) / nProcs ) )
+        {
+        }
+
+        size_t Size() const
+        {
+            return mSize;
+        }
+
+        uint32_t NProcs() const
+        {
+            return mNProcs;
+        }
+
+        uint32_t Owner( size_t global ) const
+        {
+            return static_cast< uint32_t >( global / mBlock );
+        }
+
+        size_t LocalIndex( size_t global ) const
+        {
+            return global % mBlock;
+        }
+
+        size_t GlobalIndex( uint32_t pid, size_t local ) const
+        {
+            return pid * mBlock + local;
+        }
+
+        /**
+         * Gets the amount of indices the given processor owns below the given global index.
+         */
+
+        size_t LocalCount( uint32_t pid, size_t global ) const
+        {
+            const size_t first = pid * mBlock;
+            return global > first ? std::min( global - first, LocalSize( pid ) ) : 0;
+        }
+
+        size_t LocalSize( uint32_t pid ) const
+        {
+            const size_t first = std::min( mSize, pid * mBlock );
+            return std::min( mBlock, mSize - first );
+        }
+
+    private:
+
+        size_t mSize;
+        uint32_t mNProcs;
+        size_t mBlock;
+    };
+
+    /**
+     * Distributes the global indices in blocks of tBlock consecutive indices, which are dealt to the processors in
+     * turn. Index i is owned by processor ( i / tBlock ) mod p.
+     *
+     * @tparam  tBlock The block size.
+     */
+
+    template< size_t tBlock >
+    class BlockCyclicDistribution
+    {
+    public:
+
+        /// Whether the indices of every processor are consecutive.
+        static const bool Contiguous = false;
+
+        BlockCyclicDistribution( size_t size, uint32_t nProcs )
+            : mSize( size ),
+              mNProcs( nProcs )
+        {
+        }
+
+        size_t Size() const
+        {
+            return mSize;
+        }
+
+        uint32_t NProcs() const
+        {
+            return mNProcs;
+        }
+
+        uint32_t Owner( size_t global ) const
+        {
+            return static_cast< uint32_t >( ( global / tBlock ) % mNProcs );
+        }
+
+        size_t LocalIndex( size_t global ) const
+        {
+            return global / ( tBlock * mNProcs ) * tBlock + global % tBlock;
+        }
+
+        size_t GlobalIndex( uint32_t pid, size_t local ) const
+        {
+            return local / tBlock * tBlock * mNProcs + pid * tBlock + local % tBlock;
+        }
+
+        /**
+         * Gets the amount of indices the given processor owns below the given global index.
+         */
+
+        size_t LocalCount( uint32_t pid, size_t global ) const
+        {
+            const size_t cycle = tBlock * mNProcs;
+            const size_t first = pid * tBlock;
+            const size_t rest = global % cycle;
+
+            return global / cycle * tBlock + ( rest > first ? std::min( rest - first, tBlock ) : 0 );
+        }
+
+        size_t LocalSize( uint32_t pid ) const
+        {
+            return LocalCount( pid, mSize );
+        }
+
+    private:
+
+        size_t mSize;
+        uint32_t mNProcs;
+    };
+
+    /**
+     * Distributes the global indices cyclically, index i is owned by processor i mod p. This is the distribution of
+     * the vectors in BSPedupack, of which the local size is nloc( p, s, n ).
+     */
+
+    typedef BlockCyclicDistribution< 1 > CyclicDistribution;
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
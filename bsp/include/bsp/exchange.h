@@ -0,0 +1,170 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_EXCHANGE_H__
+#define __BSPLIB_EXCHANGE_H__
+
+#include "bsp/bspExt.h"
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /// A span of bytes for the processor with the given ID.
+    struct ExchangeSpan
+    {
+        uint32_t pid;
+        const void *data;
+        size_t nbytes;
+    };
+
+    /**
+     * The bytes a processor received in a sparse exchange, stored contiguously and ordered by sender.
+     */
+
+    class ExchangeBuffer
+    {
+    public:
+
+        /**
+         * Gets the amount of bytes received from the given processor.
+         */
+
+        size_t Size( uint32_t pid ) const
+        {
+            return mOffsets.empty() ? 0 : mOffsets[pid + 1] - mOffsets[pid];
+        }
+
+        /**
+         * Gets the bytes received from the given processor. The senders are packed back to back, so the bytes have no
+         * alignment guarantees; use Copy to read elements.
+         */
+
+        const char *Data( uint32_t pid ) const
+        {
+            return mData.data() + ( mOffsets.empty() ? 0 : mOffsets[pid] );
+        }
+
+        /**
+         * Gets the amount of bytes received from all processors.
+         */
+
+        size_t TotalSize() const
+        {
+            return mData.size();
+        }
+
+        /**
+         * Gets the amount of elements received from the given processor.
+         *
+         * @pre All processors sent spans of tPrimitive to this processor.
+         */
+
+        template< typename tPrimitive >
+        size_t Count( uint32_t pid ) const
+        {
+            return Size( pid ) / sizeof( tPrimitive );
+        }
+
+        /**
+         * Copies the elements received from the given processor.
+         *
+         * @param   pid       The sender.
+         * @param [out]  out  The destination, which holds Count< tPrimitive >( pid ) elements.
+         *
+         * @return The end of the copied elements.
+         *
+         * @pre All processors sent spans of tPrimitive to this processor.
+         */
+
+        template< typename tPrimitive >
+        tPrimitive *Copy( uint32_t pid, tPrimitive *out ) const
+        {
+            static_assert( std::is_trivially_copyable< tPrimitive >::value, "exchanged elements are copied as bytes" );
+
+            const size_t count = Count< tPrimitive >( pid );
+
+            if ( count > 0 )
+            {
+                memcpy( out, Data( pid ), count * sizeof( tPrimitive ) );
+            }
+
+            return out + count;
+        }
+
+    private:
+
+        std::vector< char > mData;
+        std::vector< size_t > mOffsets;
+
+        friend void Exchange( const ExchangeSpan *, size_t, ExchangeBuffer & );
+    };
+
+    /**
+     * Ends the superstep like Sync, and delivers the given spans to their processors. The receivers need not know
+     * which processors send to them. The spans are copied once, straight from the memory of the sender into the
+     * buffer of the receiver, without a tag or header per message.
+     *
+     * @param   spans         The spans to send. Spans to the same processor arrive in this order.
+     * @param   count         The amount of spans.
+     * @param [out]  received The bytes received from every processor.
+     *
+     * @pre All processors call Exchange in this superstep.
+     */
+
+    inline void Exchange( const ExchangeSpan *spans, size_t count, ExchangeBuffer &received )
+    {
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( ProcId() );
+
+        for ( size_t i = 0; i < count; ++i )
+        {
+            bsp.ExchangeSpan( local, spans[i].pid, spans[i].data, spans[i].nbytes );
+        }
+
+        bsp.Exchange( local, received.mData, received.mOffsets );
+    }
+
+    /**
+     * Ends the superstep like Sync, and delivers the given spans to their processors.
+     *
+     * @param   spans         The spans to send. Spans to the same processor arrive in this order.
+     * @param [out]  received The bytes received from every processor.
+     *
+     * @pre All processors call Exchange in this superstep.
+     */
+
+    inline void Exchange( const std::vector< ExchangeSpan > &spans, ExchangeBuffer &received )
+    {
+        Exchange( spans.data(), spans.size(), received );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
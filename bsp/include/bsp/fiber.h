@@ -0,0 +1,210 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_FIBER_H__
+#define __BSPLIB_FIBER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <ucontext.h>
+#endif
+
+namespace BspInternal
+{
+    /**
+     * A user level execution context with its own stack. Switching between fibers is cooperative and does not involve
+     * the operating system scheduler. A default constructed fiber represents the native context of the thread that
+     * switches away from it.
+     */
+
+    class Fiber
+    {
+    public:
+
+        typedef void( *Entry )( void * );
+
+        Fiber()
+            : mEntry( nullptr ),
+              mArgument( nullptr ),
+              mStack( nullptr ),
+              mHandle( nullptr )
+        {
+        }
+
+        ~Fiber()
+        {
+            Destroy();
+        }
+
+        /**
+         * Creates the fiber with its own stack. The entry function will run the first time the fiber is switched to,
+         * and may never return.
+         *
+         * @param   entry     The entry function.
+         * @param   argument  The argument passed to the entry function.
+         * @param   stackSize The size of the stack in bytes.
+         *
+         * @return true if it succeeds, false if it fails.
+         */
+
+        bool Create( Entry entry, void *argument, size_t stackSize )
+        {
+            Destroy();
+
+            mEntry = entry;
+            mArgument = argument;
+
+#ifdef _WIN32
+            mHandle = CreateFiber( stackSize, &Fiber::Trampoline, this );
+            return mHandle != nullptr;
+#else
+            mStack = static_cast< char * >( std::malloc( stackSize ) );
+
+            if ( !mStack || getcontext( &mContext ) != 0 )
+            {
+                return false;
+            }
+
+            mContext.uc_stack.ss_sp = mStack;
+            mContext.uc_stack.ss_size = stackSize;
+            mContext.uc_link = nullptr;
+
+            // makecontext only passes int arguments, so the pointer is split in two halves
+            const uint64_t self = reinterpret_cast< uintptr_t >( this );
+            makecontext( &mContext, reinterpret_cast< void( * )() >( &Fiber::Trampoline ), 2,
+                         static_cast< uint32_t >( self >> 32 ), static_cast< uint32_t >( self ) );
+            return true;
+#endif
+        }
+
+        /**
+         * Prepares the calling thread for switching to fibers, with `native` as the fiber representing the thread.
+         *
+         * @param [in,out]  native The fiber that represents the calling thread.
+         */
+
+        static void ConvertThread( Fiber &native )
+        {
+#ifdef _WIN32
+            native.mHandle = ConvertThreadToFiber( nullptr );
+            native.mConverted = true;
+#else
+            ( void )native;
+#endif
+        }
+
+        /**
+         * Restores the calling thread after it stopped switching between fibers.
+         *
+         * @param [in,out]  native The fiber that represents the calling thread.
+         */
+
+        static void RevertThread( Fiber &native )
+        {
+#ifdef _WIN32
+
+            if ( native.mConverted )
+            {
+                ConvertFiberToThread();
+                native.mHandle = nullptr;
+                native.mConverted = false;
+            }
+
+#else
+            ( void )native;
+#endif
+        }
+
+        /**
+         * Saves the current context in `from` and continues executing `to`.
+         *
+         * @param [in,out]  from The fiber that is currently running.
+         * @param [in,out]  to   The fiber to continue.
+         */
+
+        static void Switch( Fiber &from, Fiber &to )
+        {
+#ifdef _WIN32
+            ( void )from;
+            SwitchToFiber( to.mHandle );
+#else
+            swapcontext( &from.mContext, &to.mContext );
+#endif
+        }
+
+    private:
+
+        Entry mEntry;
+        void *mArgument;
+        char *mStack;
+        void *mHandle;
+
+#ifdef _WIN32
+        bool mConverted = false;
+
+        static VOID CALLBACK Trampoline( PVOID self )
+        {
+            Fiber *fiber = static_cast< Fiber * >( self );
+            fiber->mEntry( fiber->mArgument );
+        }
+#else
+        ucontext_t mContext;
+
+        static void Trampoline( uint32_t high, uint32_t low )
+        {
+            Fiber *fiber = reinterpret_cast< Fiber * >( static_cast< uintptr_t >( ( static_cast< uint64_t >( high ) << 32 ) | low ) );
+            fiber->mEntry( fiber->mArgument );
+        }
+#endif
+
+        void Destroy()
+        {
+#ifdef _WIN32
+
+            if ( mHandle && !mConverted )
+            {
+                DeleteFiber( mHandle );
+            }
+
+#endif
+            std::free( mStack );
+            mStack = nullptr;
+            mHandle = nullptr;
+        }
+
+        Fiber( const Fiber & );
+        Fiber &operator=( const Fiber & );
+    };
+}
+
+#endif
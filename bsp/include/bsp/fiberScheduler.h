@@ -0,0 +1,320 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_FIBERSCHEDULER_H__
+#define __BSPLIB_FIBERSCHEDULER_H__
+
+#ifndef BSP_FIBER_STACK_SIZE
+#   define BSP_FIBER_STACK_SIZE 262144
+#endif
+
+#include "bsp/bspAbort.h"
+#include "bsp/fiber.h"
+#include "bsp/mixedBarrier.h"
+
+#include <atomic>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * Multiplexes the processors of a BSP computation on a smaller set of worker threads. Every worker runs its first
+     * processor on its native stack, and the other processors as fibers. On a synchronisation point a processor
+     * switches to the next processor of the same worker, and only the last processor of the worker to arrive waits
+     * for the other workers.
+     */
+
+    class FiberScheduler
+    {
+    public:
+
+        FiberScheduler()
+            : mWorkerBarrier( 0 )
+        {
+        }
+
+        /**
+         * Distributes the processors in contiguous blocks over the workers.
+         *
+         * @param   nProcs   The amount of processors.
+         * @param   nWorkers The amount of worker threads.
+         * @param   body     The function a fiber runs for a processor. The processor ID has already been set.
+         *
+         * @pre 0 < nWorkers <= nProcs.
+         */
+
+        void Reset( uint32_t nProcs, uint32_t nWorkers, std::function< void() > body )
+        {
+            mBody = body;
+            mWorkers.clear();
+            mWorkerOf.resize( nProcs );
+            mLocalIndex.resize( nProcs );
+
+            for ( uint32_t worker = 0; worker < nWorkers; ++worker )
+            {
+                std::unique_ptr< Worker > data( new Worker );
+                const uint32_t first = static_cast< uint32_t >( static_cast< uint64_t >( nProcs ) * worker / nWorkers );
+                const uint32_t last = static_cast< uint32_t >( static_cast< uint64_t >( nProcs ) * ( worker + 1 ) / nWorkers );
+
+                for ( uint32_t pid = first; pid < last; ++pid )
+                {
+                    mWorkerOf[pid] = worker;
+                    mLocalIndex[pid] = pid - first;
+                    data->pids.push_back( pid );
+                }
+
+                mWorkers.emplace_back( std::move( data ) );
+            }
+
+            mWorkerBarrier.SetSize( nWorkers );
+        }
+
+        /**
+         * Gets the processors run by the given worker.
+         *
+         * @param   worker The worker.
+         *
+         * @return The processor IDs, of which the first runs on the native stack of the worker.
+         */
+
+        const std::vector< uint32_t > &GetProcessors( uint32_t worker ) const
+        {
+            return mWorkers[worker]->pids;
+        }
+
+        /**
+         * Creates the fibers of the given worker. Should be called on the thread of the worker.
+         *
+         * @param   worker          The worker.
+         * @param [in,out]  pidSlot The thread local processor ID of the worker thread, updated on every switch.
+         *
+         * @post *pidSlot is the first processor of the worker.
+         */
+
+        void StartWorker( uint32_t worker, uint32_t *pidSlot )
+        {
+            Worker &data = *mWorkers[worker];
+            const size_t count = data.pids.size();
+
+            data.pidSlot = pidSlot;
+            data.current = 0;
+            data.arrived = 0;
+            data.alive = count;
+            data.finished.assign( count, false );
+            data.arguments.resize( count );
+            data.fibers.clear();
+
+            data.fibers.emplace_back( new Fiber );
+            Fiber::ConvertThread( *data.fibers[0] );
+
+            for ( size_t i = 1; i < count; ++i )
+            {
+                data.arguments[i] = Argument{ this, data.pids[i] };
+                data.fibers.emplace_back( new Fiber );
+
+                if ( !data.fibers[i]->Create( &FiberScheduler::Run, &data.arguments[i], BSP_FIBER_STACK_SIZE ) )
+                {
+                    fprintf( stderr, "Error: could not allocate the stack for processor %u. Terminating now.", data.pids[i] );
+                    std::terminate();
+                }
+            }
+
+            *pidSlot = data.pids[0];
+        }
+
+        /**
+         * Waits for all processors to reach the sync point. Other processors of the same worker are run while waiting.
+         *
+         * @param   pid             The processor ID of the caller.
+         * @param   aborted         Check whether the process should be aborted.
+         * @param [in,out]  arrival If non-null, the time the caller arrived, which is replaced by the time the last
+         *                          processor arrived. All processors must either pass an arrival or not.
+         *
+         * @post all processors have reached the sync point.
+         */
+
+        void Wait( uint32_t pid, const std::atomic_bool &aborted, MixedBarrier::Clock::time_point *arrival = nullptr )
+        {
+            Worker &data = *mWorkers[mWorkerOf[pid]];
+
+            if ( aborted )
+            {
+                throw BspAbort( "Aborted" );
+            }
+
+            if ( ++data.arrived < data.alive )
+            {
+                SwitchTo( data, Next( data ) );
+            }
+            else
+            {
+                data.arrived = 0;
+
+                // the processors of a worker run one after another, so the last of them arrived last
+                if ( arrival )
+                {
+                    data.lastArrival = *arrival;
+                    mWorkerBarrier.Wait( aborted, &data.lastArrival );
+                }
+                else
+                {
+                    mWorkerBarrier.Wait( aborted );
+                }
+            }
+
+            if ( aborted )
+            {
+                throw BspAbort( "Aborted" );
+            }
+
+            if ( arrival )
+            {
+                *arrival = data.lastArrival;
+            }
+        }
+
+        /**
+         * Marks the given processor as finished. When called from a fiber, it continues with the other processors of
+         * the worker and never returns. When called from the native stack, it returns after all processors of the
+         * worker have finished.
+         *
+         * @param   pid The processor ID of the caller.
+         */
+
+        void Exit( uint32_t pid )
+        {
+            Worker &data = *mWorkers[mWorkerOf[pid]];
+            const size_t self = mLocalIndex[pid];
+
+            if ( data.finished.empty() || data.finished[self] )
+            {
+                return;
+            }
+
+            data.finished[self] = true;
+            --data.alive;
+
+            if ( self == 0 )
+            {
+                while ( data.alive > 0 )
+                {
+                    SwitchTo( data, Next( data ) );
+                }
+
+                Fiber::RevertThread( *data.fibers[0] );
+                *data.pidSlot = pid;
+            }
+            else
+            {
+                SwitchTo( data, data.alive > 0 ? Next( data ) : 0 );
+            }
+        }
+
+        /**
+         * Wakes up the workers waiting for each other, so they notice the abort.
+         */
+
+        void NotifyAbort()
+        {
+            mWorkerBarrier.NotifyAbort();
+        }
+
+    private:
+
+        struct Argument
+        {
+            FiberScheduler *scheduler;
+            uint32_t pid;
+        };
+
+        struct Worker
+        {
+            std::vector< uint32_t > pids;
+            std::vector< std::unique_ptr< Fiber > > fibers;
+            std::vector< Argument > arguments;
+            std::vector< bool > finished;
+            uint32_t *pidSlot;
+            size_t current;
+            size_t arrived;
+            size_t alive;
+            MixedBarrier::Clock::time_point lastArrival;
+        };
+
+        MixedBarrier mWorkerBarrier;
+
+        std::vector< std::unique_ptr< Worker > > mWorkers;
+        std::vector< uint32_t > mWorkerOf;
+        std::vector< uint32_t > mLocalIndex;
+        std::function< void() > mBody;
+
+        static size_t Next( const Worker &data )
+        {
+            const size_t count = data.pids.size();
+
+            for ( size_t i = 1; i <= count; ++i )
+            {
+                const size_t candidate = ( data.current + i ) % count;
+
+                if ( !data.finished[candidate] )
+                {
+                    return candidate;
+                }
+            }
+
+            return 0;
+        }
+
+        static void SwitchTo( Worker &data, size_t target )
+        {
+            const size_t self = data.current;
+
+            if ( self != target )
+            {
+                data.current = target;
+                *data.pidSlot = data.pids[target];
+                Fiber::Switch( *data.fibers[self], *data.fibers[target] );
+            }
+        }
+
+        static void Run( void *argument )
+        {
+            Argument &arg = *static_cast< Argument * >( argument );
+
+            try
+            {
+                arg.scheduler->mBody();
+            }
+            catch ( ... )
+            {
+                // mimic the threaded behaviour, where the exception ends up in an unused future
+            }
+
+            arg.scheduler->Exit( arg.pid );
+        }
+    };
+}
+
+#endif
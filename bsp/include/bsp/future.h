@@ -0,0 +1,251 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_FUTURE_H__
+#define __BSPLIB_FUTURE_H__
+
+#include "bsp/bspExt.h"
+
+#include <assert.h>
+#include <utility>
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * The result of a get, which becomes readable after the next synchronisation. Its storage is taken from a pool
+     * of the processor, and given back when the future is destroyed, so repeated gets do not allocate.
+     *
+     * @tparam  tPrimitive The element type.
+     */
+
+    template< typename tPrimitive >
+    class Future
+    {
+    public:
+
+        Future()
+            : mBSP( nullptr ),
+              mCount( 0 ),
+              mSuperstep( 0 )
+        {
+        }
+
+        /**
+         * Gets the given elements of a registered variable of another processor.
+         *
+         * @param [in,out]  bsp   The BSP instance.
+         * @param [in,out]  local The state of this processor.
+         * @param   pid           The source processor ID.
+         * @param   src           The registered variable.
+         * @param   offset        The offset in elements.
+         * @param   count         The amount of elements.
+         */
+
+        Future( BSP &bsp, BSP::Local &local, uint32_t pid, const tPrimitive *src, size_t offset, size_t count )
+            : mBSP( &bsp ),
+              mLocal( local ),
+              mBuffer( bsp.AcquireBuffer( local, count * sizeof( tPrimitive ) ) ),
+              mCount( count ),
+              mSuperstep( bsp.Superstep( local ) )
+        {
+            if ( count > 0 )
+            {
+                bsp.Get( local, pid, src, offset * sizeof( tPrimitive ), mBuffer.data(), count * sizeof( tPrimitive ) );
+            }
+        }
+
+        Future( Future &&other )
+            : mBSP( other.mBSP ),
+              mLocal( other.mLocal ),
+              mBuffer( std::move( other.mBuffer ) ),
+              mCount( other.mCount ),
+              mSuperstep( other.mSuperstep )
+        {
+            other.mBSP = nullptr;
+        }
+
+        Future &operator=( Future &&other )
+        {
+            if ( this != &other )
+            {
+                Release();
+
+                mBSP = other.mBSP;
+                mLocal = other.mLocal;
+                mBuffer = std::move( other.mBuffer );
+                mCount = other.mCount;
+                mSuperstep = other.mSuperstep;
+                other.mBSP = nullptr;
+            }
+
+            return *this;
+        }
+
+        /**
+         * Gives the storage back to the pool. A future destroyed before the next synchronisation keeps its storage
+         * from being reused until then, since the get still writes to it.
+         *
+         * @pre The computation that created the future has not ended.
+         */
+
+        ~Future()
+        {
+            Release();
+        }
+
+        /**
+         * Query if the values have arrived, which is after the next synchronisation.
+         */
+
+        bool IsReady() const
+        {
+            return mBSP && mBSP->Superstep( mLocal ) > mSuperstep;
+        }
+
+        size_t Size() const
+        {
+            return mCount;
+        }
+
+        /**
+         * Gets the values.
+         *
+         * @pre IsReady().
+         */
+
+        const tPrimitive *Data() const
+        {
+            assert( IsReady() );
+            return reinterpret_cast< const tPrimitive * >( mBuffer.data() );
+        }
+
+        const tPrimitive *begin() const
+        {
+            return Data();
+        }
+
+        const tPrimitive *end() const
+        {
+            return Data() + mCount;
+        }
+
+        const tPrimitive &operator[]( size_t index ) const
+        {
+            assert( index < mCount );
+            return Data()[index];
+        }
+
+        /**
+         * Gets the first value, of a future of a single variable.
+         *
+         * @pre IsReady().
+         */
+
+        const tPrimitive &Value() const
+        {
+            return ( *this )[0];
+        }
+
+    private:
+
+        BSP *mBSP;
+        BSP::Local mLocal;
+        std::vector< char > mBuffer;
+        size_t mCount;
+        size_t mSuperstep;
+
+        void Release()
+        {
+            if ( mBSP )
+            {
+                mBSP->ReleaseBuffer( mLocal, std::move( mBuffer ), mSuperstep );
+                mBSP = nullptr;
+            }
+        }
+
+        Future( const Future & );
+        Future &operator=( const Future & );
+    };
+
+    /**
+     * Gets the given elements of a registered array of another processor, of which the result becomes readable
+     * after the next synchronisation.
+     *
+     * @param   pid    The source processor ID.
+     * @param   begin  The begin of the registered array.
+     * @param   offset The offset in elements.
+     * @param   count  The amount of elements.
+     *
+     * @return The future of the values.
+     */
+
+    template< typename tPrimitive >
+    Future< tPrimitive > GetAsyncPtrs( uint32_t pid, const tPrimitive *begin, size_t offset, size_t count )
+    {
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        return Future< tPrimitive >( bsp, local, pid, begin, offset, count );
+    }
+
+    /**
+     * Gets the given elements of a registered variable of another processor, of which the result becomes readable
+     * after the next synchronisation.
+     *
+     * @param   pid    The source processor ID.
+     * @param   src    The registered variable, for example the begin of a registered array.
+     * @param   offset The offset in elements.
+     * @param   count  The amount of elements.
+     *
+     * @return The future of the values.
+     */
+
+    template< typename tPrimitive >
+    Future< tPrimitive > GetAsync( uint32_t pid, const tPrimitive &src, size_t offset, size_t count )
+    {
+        return GetAsyncPtrs( pid, &src, offset, count );
+    }
+
+    /**
+     * Gets a registered variable of another processor, of which the result becomes readable after the next
+     * synchronisation.
+     *
+     * @param   pid The source processor ID.
+     * @param   src The registered variable.
+     *
+     * @return The future of the value.
+     */
+
+    template< typename tPrimitive >
+    Future< tPrimitive > GetAsync( uint32_t pid, const tPrimitive &src )
+    {
+        return GetAsync( pid, src, 0, 1 );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,510 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_GATHER_H__
+#define __BSPLIB_GATHER_H__
+
+#include "bsp/group.h"
+
+#include <algorithm>
+#include <vector>
+
+/// All-gathers on groups of at least this size may use Bruck's algorithm.
+#ifndef BSP_ALLGATHER_BRUCK_SIZE
+#   define BSP_ALLGATHER_BRUCK_SIZE 32
+#endif
+
+/// All-gathers of which every member contributes at most this amount of bytes may use Bruck's algorithm.
+#ifndef BSP_ALLGATHER_BRUCK_BYTES
+#   define BSP_ALLGATHER_BRUCK_BYTES 4096
+#endif
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    enum class AllGatherAlgorithm
+    {
+        /// Chooses the algorithm by the data size and the group size.
+        Automatic,
+        /// Every member puts its data to all other members, in one superstep.
+        OnePhase,
+        /// Every member forwards the data it has to the member 1, 2, 4, ... ranks lower, in ceil( log2( size ) )
+        /// supersteps.
+        Bruck
+    };
+
+    /**
+     * Chooses the all-gather algorithm. Both algorithms send the same amount of bytes, but on large groups with small
+     * data Bruck's algorithm needs far fewer puts, of which the overhead outweighs the extra supersteps.
+     *
+     * @param   size   The group size.
+     * @param   nbytes The largest amount of bytes a member contributes.
+     *
+     * @return The algorithm.
+     */
+
+    inline AllGatherAlgorithm ChooseAllGather( uint32_t size, size_t nbytes )
+    {
+        if ( size >= BSP_ALLGATHER_BRUCK_SIZE && nbytes <= BSP_ALLGATHER_BRUCK_BYTES )
+        {
+            return AllGatherAlgorithm::Bruck;
+        }
+
+        return AllGatherAlgorithm::OnePhase;
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+namespace BspInternal
+{
+    /**
+     * Gets the amount of elements of the given amount of consecutive ranks, wrapping around after the last rank.
+     */
+
+    inline size_t RangeCount( const std::vector< size_t > &counts, uint32_t first, uint32_t length )
+    {
+        const uint32_t size = static_cast< uint32_t >( counts.size() );
+        size_t total = 0;
+
+        for ( uint32_t i = 0; i < length; ++i )
+        {
+            total += counts[( first + i ) % size];
+        }
+
+        return total;
+    }
+
+    /**
+     * Gathers the data of all members of a group on all members, of which all members know the sizes.
+     *
+     * @param   send           The data of this member.
+     * @param   counts         The amount of elements of every member, by rank.
+     * @param [out]  received  The data of all members in rank order.
+     * @param   collective     The collective state.
+     * @param   algorithm      The algorithm.
+     */
+
+    template< typename tPrimitive >
+    void AllGather( const tPrimitive *send, const std::vector< size_t > &counts, tPrimitive *received,
+                    Collective &collective, BSP_NAMESPACE::AllGatherAlgorithm algorithm )
+    {
+        typedef BSP_NAMESPACE::AllGatherAlgorithm Algorithm;
+
+        const uint32_t size = collective.Size();
+        const uint32_t rank = collective.Rank();
+        const size_t offset = RangeCount( counts, 0, rank );
+        const size_t count = counts[rank];
+
+        if ( algorithm == Algorithm::Automatic )
+        {
+            algorithm = BSP_NAMESPACE::ChooseAllGather( size, *std::max_element( counts.begin(), counts.end() ) *
+                                                        sizeof( tPrimitive ) );
+        }
+
+        if ( algorithm == Algorithm::Bruck )
+        {
+            // the buffer holds the data of this rank and the ranks after it, wrapping around after the last rank
+            const size_t total = RangeCount( counts, 0, size );
+            std::vector< tPrimitive > buffer( total );
+            std::copy( send, send + count, buffer.begin() );
+
+            for ( uint32_t distance = 1; distance < size; distance <<= 1 )
+            {
+                const uint32_t blocks = std::min( distance, size - distance );
+                const uint32_t target = ( rank + size - distance ) % size;
+
+                collective.Receive( buffer.data() );
+                collective.Put( target, buffer.data(), RangeCount( counts, target, distance ) * sizeof( tPrimitive ),
+                                RangeCount( counts, rank, blocks ) * sizeof( tPrimitive ) );
+                collective.Sync();
+            }
+
+            std::copy( buffer.begin(), buffer.begin() + ( total - offset ), received + offset );
+            std::copy( buffer.begin() + ( total - offset ), buffer.end(), received );
+            return;
+        }
+
+        collective.Receive( received );
+
+        for ( uint32_t r = 0; r < size; ++r )
+        {
+            if ( r != rank )
+            {
+                collective.Put( r, send, offset * sizeof( tPrimitive ), count * sizeof( tPrimitive ) );
+            }
+        }
+
+        std::copy( send, send + count, received + offset );
+        collective.Sync();
+    }
+
+    /**
+     * Gathers the amount of elements of all members on all members.
+     */
+
+    inline std::vector< size_t > AllGatherCounts( size_t count, Collective &collective )
+    {
+        const uint64_t own = count;
+        std::vector< uint64_t > counts( collective.Size() );
+        AllGather( &own, std::vector< size_t >( collective.Size(), 1 ), counts.data(), collective,
+                   BSP_NAMESPACE::AllGatherAlgorithm::Automatic );
+
+        return std::vector< size_t >( counts.begin(), counts.end() );
+    }
+
+    /**
+     * Gathers the data of all members of a group on the root.
+     *
+     * @param   send           The data of this member.
+     * @param   count          The amount of elements of this member.
+     * @param   offset         The offset of the data of this member on the root.
+     * @param [out]  received  The data of all members in rank order, only used on the root.
+     * @param   root           The rank of the root.
+     * @param   collective     The collective state.
+     */
+
+    template< typename tPrimitive >
+    void Gather( const tPrimitive *send, size_t count, size_t offset, tPrimitive *received, uint32_t root,
+                 Collective &collective )
+    {
+        collective.Receive( received );
+
+        if ( collective.Rank() == root )
+        {
+            std::copy( send, send + count, received + offset );
+        }
+        else
+        {
+            collective.Put( root, send, offset * sizeof( tPrimitive ), count * sizeof( tPrimitive ) );
+        }
+
+        collective.Sync();
+    }
+
+    /**
+     * Scatters the data of the root over all members of a group.
+     *
+     * @param   send           The data for all members in rank order, only used on the root.
+     * @param   counts         The amount of elements for every member, only used on the root.
+     * @param [out]  received  The data of this member.
+     * @param   root           The rank of the root.
+     * @param   collective     The collective state.
+     */
+
+    template< typename tPrimitive >
+    void Scatter( const tPrimitive *send, const std::vector< size_t > &counts, tPrimitive *received, uint32_t root,
+                  Collective &collective )
+    {
+        collective.Receive( received );
+
+        if ( collective.Rank() == root )
+        {
+            for ( uint32_t r = 0; r < collective.Size(); ++r )
+            {
+                if ( r == root )
+                {
+                    std::copy( send, send + counts[r], received );
+                }
+                else
+                {
+                    collective.Put( r, send, 0, counts[r] * sizeof( tPrimitive ) );
+                }
+
+                send += counts[r];
+            }
+        }
+
+        collective.Sync();
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Gathers the same amount of elements of every member of the group on the root, in one superstep.
+     *
+     * @param   send          The elements of this member.
+     * @param   count         The amount of elements, equal on all members.
+     * @param [out]  received The elements of all members in rank order, on the root. Holds count * group.Size()
+     *                        elements.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void GatherPtrs( const tPrimitive *send, size_t count, tPrimitive *received, uint32_t root = 0,
+                     const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Gather( send, count, collective.Rank() * count, received, group.Rank( root ), collective );
+    }
+
+    /**
+     * Gathers a variable amount of elements of every member of the group on the root, in two supersteps.
+     *
+     * @param   send                The elements of this member.
+     * @param   count               The amount of elements of this member.
+     * @param [out]  received       The elements of all members in rank order, on the root.
+     * @param [out]  receivedCounts The amount of elements of every member, by rank.
+     * @param   root                The processor ID of the root.
+     * @param   group               The group.
+     */
+
+    template< typename tPrimitive >
+    void GathervPtrs( const tPrimitive *send, size_t count, std::vector< tPrimitive > &received,
+                      std::vector< size_t > &receivedCounts, uint32_t root = 0, const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        receivedCounts = BspInternal::AllGatherCounts( count, collective );
+
+        const uint32_t rootRank = group.Rank( root );
+
+        if ( collective.Rank() == rootRank )
+        {
+            received.resize( BspInternal::RangeCount( receivedCounts, 0, collective.Size() ) );
+        }
+
+        BspInternal::Gather( send, count, BspInternal::RangeCount( receivedCounts, 0, collective.Rank() ),
+                             received.data(), rootRank, collective );
+    }
+
+    /**
+     * Gathers the same amount of elements of every member of the group on all members.
+     *
+     * @param   send          The elements of this member.
+     * @param   count         The amount of elements, equal on all members.
+     * @param [out]  received The elements of all members in rank order. Holds count * group.Size() elements.
+     * @param   group         The group.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive >
+    void AllGatherPtrs( const tPrimitive *send, size_t count, tPrimitive *received, const Group &group = Group(),
+                        AllGatherAlgorithm algorithm = AllGatherAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::AllGather( send, std::vector< size_t >( collective.Size(), count ), received, collective,
+                                algorithm );
+    }
+
+    /**
+     * Gathers a variable amount of elements of every member of the group on all members. The sizes are exchanged
+     * first, which costs an extra superstep.
+     *
+     * @param   send                The elements of this member.
+     * @param   count               The amount of elements of this member.
+     * @param [out]  received       The elements of all members in rank order.
+     * @param [out]  receivedCounts The amount of elements of every member, by rank.
+     * @param   group               The group.
+     * @param   algorithm           The algorithm.
+     */
+
+    template< typename tPrimitive >
+    void AllGathervPtrs( const tPrimitive *send, size_t count, std::vector< tPrimitive > &received,
+                         std::vector< size_t > &receivedCounts, const Group &group = Group(),
+                         AllGatherAlgorithm algorithm = AllGatherAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        receivedCounts = BspInternal::AllGatherCounts( count, collective );
+        received.resize( BspInternal::RangeCount( receivedCounts, 0, collective.Size() ) );
+
+        BspInternal::AllGather( send, receivedCounts, received.data(), collective, algorithm );
+    }
+
+    /**
+     * Scatters the same amount of elements from the root to every member of the group, in one superstep.
+     *
+     * @param   send          The elements for all members in rank order, on the root. Holds count * group.Size()
+     *                        elements.
+     * @param [out]  received The elements of this member.
+     * @param   count         The amount of elements per member.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void ScatterPtrs( const tPrimitive *send, tPrimitive *received, size_t count, uint32_t root = 0,
+                      const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Scatter( send, std::vector< size_t >( collective.Size(), count ), received, group.Rank( root ),
+                              collective );
+    }
+
+    /**
+     * Scatters a variable amount of elements from the root to every member of the group, in two supersteps.
+     *
+     * @param   send          The elements for all members in rank order, on the root.
+     * @param   sendCounts    The amount of elements for every member by rank, on the root.
+     * @param [out]  received The elements of this member.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void ScattervPtrs( const tPrimitive *send, const size_t *sendCounts, std::vector< tPrimitive > &received,
+                       uint32_t root = 0, const Group &group = Group() )
+    {
+        BspInternal::Collective collective( group );
+        const uint32_t size = collective.Size();
+        const uint32_t rootRank = group.Rank( root );
+        const bool isRoot = collective.Rank() == rootRank;
+
+        std::vector< uint64_t > counts( isRoot ? sendCounts : nullptr, isRoot ? sendCounts + size : nullptr );
+        uint64_t count = 0;
+        BspInternal::Scatter( counts.data(), std::vector< size_t >( size, 1 ), &count, rootRank, collective );
+
+        received.resize( static_cast< size_t >( count ) );
+        BspInternal::Scatter( send, std::vector< size_t >( counts.begin(), counts.end() ), received.data(), rootRank,
+                              collective );
+    }
+
+    /**
+     * Gathers a value of every member of the group on the root.
+     *
+     * @param   value         The value of this member.
+     * @param [out]  received The values of all members in rank order, on the root.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void Gather( const tPrimitive &value, std::vector< tPrimitive > &received, uint32_t root = 0,
+                 const Group &group = Group() )
+    {
+        if ( ProcId() == root )
+        {
+            received.resize( group.Size() );
+        }
+
+        GatherPtrs( &value, 1, received.data(), root, group );
+    }
+
+    /**
+     * Gathers the vectors of all members of the group on the root.
+     *
+     * @param   send          The elements of this member.
+     * @param [out]  received The elements of every member by rank, on the root.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void Gather( const std::vector< tPrimitive > &send, std::vector< std::vector< tPrimitive > > &received,
+                 uint32_t root = 0, const Group &group = Group() )
+    {
+        std::vector< tPrimitive > flat;
+        std::vector< size_t > counts;
+        GathervPtrs( send.data(), send.size(), flat, counts, root, group );
+
+        if ( ProcId() == root )
+        {
+            BspInternal::Split( flat, counts, received );
+        }
+    }
+
+    /**
+     * Gathers a value of every member of the group on all members.
+     *
+     * @param   value         The value of this member.
+     * @param [out]  received The values of all members in rank order.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void AllGather( const tPrimitive &value, std::vector< tPrimitive > &received, const Group &group = Group() )
+    {
+        received.resize( group.Size() );
+        AllGatherPtrs( &value, 1, received.data(), group );
+    }
+
+    /**
+     * Gathers the vectors of all members of the group on all members.
+     *
+     * @param   send          The elements of this member.
+     * @param [out]  received The elements of every member by rank.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void AllGather( const std::vector< tPrimitive > &send, std::vector< std::vector< tPrimitive > > &received,
+                    const Group &group = Group() )
+    {
+        std::vector< tPrimitive > flat;
+        std::vector< size_t > counts;
+        AllGathervPtrs( send.data(), send.size(), flat, counts, group );
+        BspInternal::Split( flat, counts, received );
+    }
+
+    /**
+     * Scatters a value from the root to every member of the group.
+     *
+     * @param   send          The values for all members in rank order, on the root.
+     * @param [out]  value    The value of this member.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void Scatter( const std::vector< tPrimitive > &send, tPrimitive &value, uint32_t root = 0,
+                  const Group &group = Group() )
+    {
+        ScatterPtrs( send.data(), &value, 1, root, group );
+    }
+
+    /**
+     * Scatters vectors from the root to every member of the group.
+     *
+     * @param   send          The elements for every member by rank, on the root.
+     * @param [out]  received The elements of this member.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive >
+    void Scatter( const std::vector< std::vector< tPrimitive > > &send, std::vector< tPrimitive > &received,
+                  uint32_t root = 0, const Group &group = Group() )
+    {
+        std::vector< tPrimitive > flat;
+        std::vector< size_t > counts;
+
+        for ( const std::vector< tPrimitive > &part : send )
+        {
+            flat.insert( flat.end(), part.begin(), part.end() );
+            counts.push_back( part.size() );
+        }
+
+        ScattervPtrs( flat.data(), counts.data(), received, root, group );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_GROUP_H__
+#define __BSPLIB_GROUP_H__
+
+#include "bsp/bspExt.h"
+
+#include <assert.h>
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * A group of processors that a collective operates on: `size` processors starting at `first`, `stride` apart.
+     * The default group holds all processors. Row and column groups of a cyclic 2D distribution over M x N
+     * processors, with processor s = i + j M, are `Group( j * M, 1, M )` and `Group( i, M, N )`.
+     *
+     * Collectives synchronise, so all processors call a collective together, each with the group it belongs to. The
+     * groups of one call must have the same size, so that every group takes the same amount of supersteps.
+     */
+
+    class Group
+    {
+    public:
+
+        /**
+         * Constructs the group of all processors.
+         */
+
+        Group()
+            : mFirst( 0 ),
+              mStride( 1 ),
+              mSize( 0 )
+        {
+        }
+
+        /**
+         * Constructor.
+         *
+         * @param   first  The first processor ID.
+         * @param   stride The distance between the processor IDs.
+         * @param   size   The amount of processors.
+         */
+
+        Group( uint32_t first, uint32_t stride, uint32_t size )
+            : mFirst( first ),
+              mStride( stride ),
+              mSize( size )
+        {
+        }
+
+        uint32_t Size() const
+        {
+            return mSize > 0 ? mSize : NProcs();
+        }
+
+        /**
+         * Gets the processor ID of a member.
+         *
+         * @param   rank The rank of the member in the group.
+         *
+         * @return The processor ID.
+         */
+
+        uint32_t Pid( uint32_t rank ) const
+        {
+            return mFirst + rank * mStride;
+        }
+
+        /**
+         * Gets the rank of a processor in the group.
+         *
+         * @param   pid The processor ID.
+         *
+         * @return The rank.
+         *
+         * @pre Contains( pid ).
+         */
+
+        uint32_t Rank( uint32_t pid ) const
+        {
+            return ( pid - mFirst ) / mStride;
+        }
+
+        bool Contains( uint32_t pid ) const
+        {
+            return pid >= mFirst && ( pid - mFirst ) % mStride == 0 && ( pid - mFirst ) / mStride < Size();
+        }
+
+    private:
+
+        uint32_t mFirst;
+        uint32_t mStride;
+        uint32_t mSize;
+    };
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+namespace BspInternal
+{
+    /**
+     * The state of the current processor in a collective over a group. Puts go straight to the collective buffers of
+     * the receivers, so collectives need neither registrations nor tags.
+     */
+
+    class Collective
+    {
+    public:
+
+        explicit Collective( const BSP_NAMESPACE::Group &group )
+            : mBSP( BSP::GetInstance() ),
+              mLocal( mBSP.GetLocal( mBSP.ProcId() ) ),
+              mGroup( group ),
+              mSize( group.Size() ),
+              mRank( group.Rank( mLocal.pid ) )
+        {
+#ifndef BSP_SKIP_CHECKS
+            assert( group.Contains( mLocal.pid ) );
+            assert( group.Pid( mSize - 1 ) < mBSP.NProcs() );
+#endif
+        }
+
+        uint32_t Size() const
+        {
+            return mSize;
+        }
+
+        uint32_t Rank() const
+        {
+            return mRank;
+        }
+
+        uint32_t Pid( uint32_t rank ) const
+        {
+            return mGroup.Pid( rank );
+        }
+
+        /**
+         * Sets the buffer that puts to this processor write to, in the current superstep.
+         */
+
+        void Receive( void *buffer )
+        {
+            mBSP.SetCollectiveBuffer( mLocal, buffer );
+        }
+
+        /**
+         * Puts bytes in the receive buffer of another member.
+         *
+         * @param   rank   The rank of the receiver.
+         * @param   src    The bytes, copied on the call.
+         * @param   offset The offset in the receive buffer in bytes.
+         * @param   nbytes The amount of bytes.
+         */
+
+        void Put( uint32_t rank, const void *src, size_t offset, size_t nbytes )
+        {
+            if ( nbytes > 0 )
+            {
+                mBSP.CollectivePut( mLocal, mGroup.Pid( rank ), src, static_cast< ptrdiff_t >( offset ), nbytes );
+            }
+        }
+
+        /**
+         * Queues bytes for another member, to be delivered by the next Exchange.
+         *
+         * @param   rank   The rank of the receiver.
+         * @param   src    The bytes, which must stay valid until the exchange.
+         * @param   nbytes The amount of bytes.
+         */
+
+        void ExchangeSpan( uint32_t rank, const void *src, size_t nbytes )
+        {
+            mBSP.ExchangeSpan( mLocal, mGroup.Pid( rank ), src, nbytes );
+        }
+
+        /**
+         * Synchronises, and delivers the bytes queued for this processor ordered by sender.
+         *
+         * @param [out]  received The received bytes.
+         * @param [out]  offsets  The offsets of the bytes of every sender by processor ID, and the total size.
+         */
+
+        void Exchange( std::vector< char > &received, std::vector< size_t > &offsets )
+        {
+            mBSP.Exchange( mLocal, received, offsets );
+        }
+
+        void Sync()
+        {
+            mBSP.Sync();
+        }
+
+    private:
+
+        BSP &mBSP;
+        BSP::Local mLocal;
+        BSP_NAMESPACE::Group mGroup;
+        uint32_t mSize;
+        uint32_t mRank;
+    };
+
+    /**
+     * Splits concatenated data in vectors of the given sizes.
+     */
+
+    template< typename tPrimitive >
+    void Split( const std::vector< tPrimitive > &flat, const std::vector< size_t > &counts,
+                std::vector< std::vector< tPrimitive > > &parts )
+    {
+        typename std::vector< tPrimitive >::const_iterator it = flat.begin();
+        parts.resize( counts.size() );
+
+        for ( size_t i = 0; i < counts.size(); ++i )
+        {
+            parts[i].assign( it, it + counts[i] );
+            it += counts[i];
+        }
+    }
+}
+
+#endif
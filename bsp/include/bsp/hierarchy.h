@@ -0,0 +1,249 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_HIERARCHY_H__
+#define __BSPLIB_HIERARCHY_H__
+
+#include "bsp/mixedBarrier.h"
+#include "bsp/topology.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * The levels of a MultiBSP computation. Level 0 is the whole machine, and every next level splits each group of
+     * the previous level into `fanout` groups of consecutive processors. The last level holds single processors. Every
+     * group with more than one processor has its own barrier, so groups on the same level synchronise independently.
+     */
+
+    class Hierarchy
+    {
+    public:
+
+        /**
+         * Gets the fanouts that follow the packages the processors are pinned on: machine, package and core. The
+         * package level has a group per run of consecutive processors on the same package. When a processor is not
+         * pinned, a package holds more than one run, or the runs differ in size, the package level spans the whole
+         * machine.
+         *
+         * @param   packages The package of every processor, or -1 when it is not pinned.
+         *
+         * @return The fanouts.
+         */
+
+        static std::vector< uint32_t > DefaultFanouts( const std::vector< int32_t > &packages )
+        {
+            const uint32_t nProcs = static_cast< uint32_t >( packages.size() );
+            std::vector< int32_t > seen;
+            uint32_t runSize = 0;
+
+            for ( uint32_t pid = 0; pid < nProcs; ++pid )
+            {
+                if ( packages[pid] < 0 )
+                {
+                    return { 1, nProcs };
+                }
+
+                if ( pid > 0 && packages[pid] == packages[pid - 1] )
+                {
+                    continue;
+                }
+
+                // the first run sets the size of all runs
+                if ( pid > 0 && runSize == 0 )
+                {
+                    runSize = pid;
+                }
+
+                if ( std::find( seen.begin(), seen.end(), packages[pid] ) != seen.end() || pid != runSize * seen.size() )
+                {
+                    return { 1, nProcs };
+                }
+
+                seen.push_back( packages[pid] );
+            }
+
+            const uint32_t groups = static_cast< uint32_t >( seen.size() );
+
+            if ( groups > 1 && nProcs == runSize * groups )
+            {
+                return { groups, nProcs / groups };
+            }
+
+            return { 1, nProcs };
+        }
+
+        /**
+         * Gets the packages of the logical processors the processors are pinned on.
+         *
+         * @param   cpus The logical processor of every processor, or -1 when it is not pinned.
+         *
+         * @return The package of every processor, or -1 when it is not pinned.
+         */
+
+        static std::vector< int32_t > GetPackages( const std::vector< int32_t > &cpus )
+        {
+            const Topology &topology = Topology::GetInstance();
+            std::vector< int32_t > packages( cpus.size(), -1 );
+
+            for ( size_t pid = 0; pid < cpus.size(); ++pid )
+            {
+                if ( cpus[pid] >= 0 )
+                {
+                    packages[pid] = static_cast< int32_t >( topology.GetPackage( static_cast< uint32_t >( cpus[pid] ) ) );
+                }
+            }
+
+            return packages;
+        }
+
+        /**
+         * Builds the levels for the given processors.
+         *
+         * @param   nProcs  The amount of processors.
+         * @param   fanouts The amount of groups every group is split into, per level.
+         *
+         * @pre The product of the fanouts equals nProcs.
+         */
+
+        void Reset( uint32_t nProcs, const std::vector< uint32_t > &fanouts )
+        {
+            uint32_t size = nProcs;
+
+            mGroupSizes.assign( 1, nProcs );
+
+            for ( uint32_t fanout : fanouts )
+            {
+                assert( fanout > 0 && size % fanout == 0 );
+                size /= fanout;
+                mGroupSizes.push_back( size );
+            }
+
+            assert( size == 1 );
+
+            mBarriers.clear();
+            mBarriers.resize( mGroupSizes.size() );
+
+            // level 0 synchronises on the barrier of the computation itself
+            for ( size_t level = 1; level < mGroupSizes.size(); ++level )
+            {
+                const uint32_t groupSize = mGroupSizes[level];
+
+                if ( groupSize > 1 )
+                {
+                    mBarriers[level].reserve( nProcs / groupSize );
+
+                    for ( uint32_t group = 0; group < nProcs / groupSize; ++group )
+                    {
+                        mBarriers[level].emplace_back( new MixedBarrier( groupSize ) );
+                    }
+                }
+            }
+        }
+
+        uint32_t GetLevelCount() const
+        {
+            return static_cast< uint32_t >( mGroupSizes.size() );
+        }
+
+        uint32_t GetGroupSize( uint32_t level ) const
+        {
+            assert( level < mGroupSizes.size() );
+            return mGroupSizes[level];
+        }
+
+        uint32_t GetGroupId( uint32_t level, uint32_t pid ) const
+        {
+            return pid / GetGroupSize( level );
+        }
+
+        uint32_t GetGroupPid( uint32_t level, uint32_t pid ) const
+        {
+            return pid % GetGroupSize( level );
+        }
+
+        /**
+         * Gets the processor ID of a member of the group of the given processor.
+         *
+         * @param   level    The level.
+         * @param   pid      The processor ID of a member of the group.
+         * @param   groupPid The ID of the member to find within the group.
+         *
+         * @return The processor ID.
+         */
+
+        uint32_t GetPid( uint32_t level, uint32_t pid, uint32_t groupPid ) const
+        {
+            assert( groupPid < GetGroupSize( level ) );
+            return GetGroupId( level, pid ) * GetGroupSize( level ) + groupPid;
+        }
+
+        /**
+         * Waits for the other members of the group of the given processor.
+         *
+         * @param   level   The level, larger than 0.
+         * @param   pid     The processor ID.
+         * @param   aborted Whether the computation has been aborted.
+         */
+
+        void Wait( uint32_t level, uint32_t pid, const std::atomic_bool &aborted )
+        {
+            assert( level > 0 );
+
+            if ( GetGroupSize( level ) > 1 )
+            {
+                mBarriers[level][GetGroupId( level, pid )]->Wait( aborted );
+            }
+            else if ( aborted )
+            {
+                throw BspAbort( "Aborted" );
+            }
+        }
+
+        /**
+         * Wakes the processors waiting in any group, after an abort.
+         */
+
+        void NotifyAbort()
+        {
+            for ( auto &level : mBarriers )
+            {
+                for ( auto &barrier : level )
+                {
+                    barrier->NotifyAbort();
+                }
+            }
+        }
+
+    private:
+
+        std::vector< uint32_t > mGroupSizes;
+        std::vector< std::vector< std::unique_ptr< MixedBarrier > > > mBarriers;
+    };
+}
+
+#endif
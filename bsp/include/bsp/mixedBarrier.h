@@ -27,7 +27,9 @@
 
 #include "bsp/bspAbort.h"
 
+#include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <mutex>
 
 namespace BspInternal
@@ -42,6 +44,8 @@ namespace BspInternal
     {
     public:
 
+        typedef std::chrono::high_resolution_clock Clock;
+
         /**
          * Constructor.
          *
@@ -53,7 +57,8 @@ namespace BspInternal
               mPreviousCon( &mConVar2 ),
               mCount( count ),
               mMax( count ),
-              mSpaces( count )
+              mSpaces( count ),
+              mGeneration( 0 )
         {
         }
 
@@ -77,15 +82,17 @@ namespace BspInternal
          * true.
          *
          * @param [in,out]  aborted Check whether the process should be aborted.
+         * @param [in,out]  arrival If non-null, the time this thread arrived, which is replaced by the time the last
+         *                          thread arrived. All threads must either pass an arrival or not.
          *
          * @pre if aborted == true, all threads quit computations.
          *
          * @post all threads have waited for each other to reach the barrier.
          */
 
-        void Wait( const std::atomic_bool &aborted )
+        void Wait( const std::atomic_bool &aborted, Clock::time_point *arrival = nullptr )
         {
-            const uint32_t myGeneration = mGeneration;
+            const uint_fast32_t myGeneration = mGeneration;
 
             if ( aborted )
             {
@@ -96,6 +103,13 @@ namespace BspInternal
             {
                 mSpaces = mMax;
                 std::lock_guard< std::mutex > condVarLoc( mCondVarMutex );
+
+                // published by the generation change, and only overwritten after every thread passed the next barrier
+                if ( arrival )
+                {
+                    mLastArrival = *arrival;
+                }
+
                 ++mGeneration;
                 Reset();
             }
@@ -103,32 +117,41 @@ namespace BspInternal
             {
                 size_t i = 0;
 
+                // an abort also bumps the generation, so spinning needs no separate check
                 while ( mGeneration == myGeneration && ++i < BSP_SPIN_ITERATIONS )
                 {
-                    if ( ( i & 127 ) == 0 && aborted )
-                    {
-                        Abort();
-                    }
                 }
 
                 if ( i >= BSP_SPIN_ITERATIONS )
                 {
                     std::unique_lock< std::mutex > condVarLoc( mCondVarMutex );
-                    mCurrentCon->wait( condVarLoc, [&] {return mGeneration != myGeneration;} );
+                    mCurrentCon->wait( condVarLoc, [&] {return mGeneration != myGeneration || aborted;} );
                 }
             }
 
             if ( aborted )
             {
-                mCurrentCon->notify_all();
-                throw BspAbort( "Aborted" );
+                Abort();
+            }
+
+            if ( arrival )
+            {
+                *arrival = mLastArrival;
             }
         }
 
+        /**
+         * Wakes all threads waiting on the barrier, after `aborted` has been set. The generation is changed under the
+         * lock, so a thread that is about to sleep cannot miss the wake up.
+         */
+
         void NotifyAbort()
         {
-            mCurrentCon->notify_all();
+            std::lock_guard< std::mutex > condVarLoc( mCondVarMutex );
             ++mGeneration;
+
+            mConVar1.notify_all();
+            mConVar2.notify_all();
         }
 
     private:
@@ -146,6 +169,8 @@ namespace BspInternal
         std::atomic_uint_fast32_t mSpaces;
         std::atomic_uint_fast32_t mGeneration;
 
+        Clock::time_point mLastArrival;
+
         void Reset()
         {
             mCount = mMax;
@@ -158,7 +183,7 @@ namespace BspInternal
 
         void Abort()
         {
-            mCurrentCon->notify_all();
+            NotifyAbort();
             throw BspAbort( "Aborted" );
         }
 
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_MULTIBSP_H__
+#define __BSPLIB_MULTIBSP_H__
+
+#include "bsp/bspExt.h"
+
+#include <vector>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * The MultiBSP interface. The processors are organised in nested groups: level 0 is the whole machine, and every
+     * next level splits each group into smaller groups of consecutive processors, by default one per package and
+     * then one per core. Every group synchronises and communicates on its own, so an algorithm only pays for the
+     * level that its data moves on.
+     */
+
+    namespace MultiBSP
+    {
+        /**
+         * Sets the fanout per level for the computations started after this call. For example `{ 2, 8 }` on 16
+         * processors gives 2 groups of 8 processors on level 1, and single processors on level 2.
+         *
+         * @param   fanouts The fanouts, an empty list to follow the machine topology.
+         */
+
+        inline void SetFanouts( const std::vector< uint32_t > &fanouts )
+        {
+            BSP::GetInstance().SetFanouts( fanouts );
+        }
+
+        /**
+         * Gets the amount of levels, including the machine and the processor levels.
+         *
+         * @return The amount of levels.
+         */
+
+        inline uint32_t Levels()
+        {
+            return BSP::GetInstance().GetLevelCount();
+        }
+
+        /**
+         * Gets the amount of processors in the group of the current processor.
+         *
+         * @param   level The level.
+         *
+         * @return The group size.
+         */
+
+        inline uint32_t GroupSize( uint32_t level )
+        {
+            return BSP::GetInstance().GetGroupSize( level );
+        }
+
+        /**
+         * Gets the index of the group of the current processor among the groups of the given level.
+         *
+         * @param   level The level.
+         *
+         * @return The group index.
+         */
+
+        inline uint32_t GroupId( uint32_t level )
+        {
+            return BSP::GetInstance().GetGroupId( level );
+        }
+
+        /**
+         * Gets the ID of the current processor within its group, which lies between 0 and GroupSize( level ) - 1.
+         *
+         * @param   level The level.
+         *
+         * @return The ID within the group.
+         */
+
+        inline uint32_t GroupPid( uint32_t level )
+        {
+            return BSP::GetInstance().GetGroupPid( level );
+        }
+
+        /**
+         * Synchronises the group of the current processor, and delivers the communication within the group. Level 0
+         * is equal to BSPLib::Sync().
+         *
+         * @param   level The level.
+         */
+
+        inline void Sync( uint32_t level )
+        {
+            BSP::GetInstance().GroupSync( level );
+        }
+
+        template< typename tPrimitive >
+        void Put( uint32_t level, uint32_t groupPid, tPrimitive &src, tPrimitive &dst )
+        {
+            BSP::GetInstance().GroupPut( level, groupPid, &src, &dst, 0, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void Put( uint32_t level, uint32_t groupPid, tPrimitive &var )
+        {
+            Put( level, groupPid, var, var );
+        }
+
+        template< typename tPrimitive >
+        void PutPtrs( uint32_t level, uint32_t groupPid, tPrimitive *srcBegin, size_t count, tPrimitive *resultBegin,
+                      size_t offset )
+        {
+            BSP::GetInstance().GroupPut( level, groupPid, srcBegin, resultBegin, offset * sizeof( tPrimitive ),
+                                         count * sizeof( tPrimitive ) );
+        }
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_PROCESSOR_H__
+#define __BSPLIB_PROCESSOR_H__
+
+#include "bsp/bspExt.h"
+#include "bsp/future.h"
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * A handle to the current processor, passed to the SPMD function by Execute. The handle caches the processor ID,
+     * the processor data and the communication queues of the processor, so its operations are plain member calls
+     * without thread local or singleton lookups. Use it in tight communication loops.
+     *
+     * A handle belongs to the processor it was passed to, and is valid until the computation ends.
+     */
+
+    class Processor
+    {
+    public:
+
+        explicit Processor( BSP &bsp )
+            : mBSP( bsp ),
+              mLocal( bsp.GetLocal( bsp.ProcId() ) ),
+              mNProcs( bsp.NProcs() )
+        {
+        }
+
+        uint32_t ProcId() const
+        {
+            return mLocal.pid;
+        }
+
+        uint32_t NProcs() const
+        {
+            return mNProcs;
+        }
+
+        double Time()
+        {
+            return mBSP.Time();
+        }
+
+        void Sync()
+        {
+            mBSP.Sync();
+        }
+
+        template< typename tPrimitive >
+        void Push( tPrimitive &ident )
+        {
+            mBSP.PushReg( mLocal, &ident, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void PushPtrs( tPrimitive *begin, size_t count )
+        {
+            mBSP.PushReg( mLocal, begin, count * sizeof( tPrimitive ) );
+        }
+
+        void Pop( const void *ident )
+        {
+            mBSP.PopReg( mLocal, ident );
+        }
+
+        template< typename tPrimitive >
+        void Put( uint32_t pid, tPrimitive &src, tPrimitive &dst )
+        {
+            mBSP.Put( mLocal, pid, &src, &dst, 0, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void Put( uint32_t pid, tPrimitive &var )
+        {
+            Put( pid, var, var );
+        }
+
+        template< typename tPrimitive >
+        void PutPtrs( uint32_t pid, tPrimitive *srcBegin, size_t count, tPrimitive *resultBegin, size_t offset )
+        {
+            mBSP.Put( mLocal, pid, srcBegin, resultBegin, offset * sizeof( tPrimitive ), count * sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void Get( uint32_t pid, tPrimitive &src, tPrimitive &dst )
+        {
+            mBSP.Get( mLocal, pid, &src, 0, &dst, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void Get( uint32_t pid, tPrimitive &var )
+        {
+            Get( pid, var, var );
+        }
+
+        template< typename tPrimitive >
+        void GetPtrs( uint32_t pid, tPrimitive *srcBegin, size_t offset, tPrimitive *resultBegin, size_t count )
+        {
+            mBSP.Get( mLocal, pid, srcBegin, offset * sizeof( tPrimitive ), resultBegin, count * sizeof( tPrimitive ) );
+        }
+
+        template< size_t tSlot, typename tPrimitive >
+        void PutSlot( uint32_t pid, const tPrimitive &src )
+        {
+            static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+            mBSP.PutId( mLocal, pid, &src, BspInternal::FirstSlotRegister + tSlot, 0, sizeof( tPrimitive ) );
+        }
+
+        template< size_t tSlot, typename tPrimitive >
+        void GetSlot( uint32_t pid, tPrimitive &dst )
+        {
+            static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+            mBSP.GetId( mLocal, pid, BspInternal::FirstSlotRegister + tSlot, 0, &dst, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        Future< tPrimitive > GetAsync( uint32_t pid, const tPrimitive &src )
+        {
+            return Future< tPrimitive >( mBSP, mLocal, pid, &src, 0, 1 );
+        }
+
+        template< typename tPrimitive >
+        Future< tPrimitive > GetAsyncPtrs( uint32_t pid, const tPrimitive *begin, size_t offset, size_t count )
+        {
+            return Future< tPrimitive >( mBSP, mLocal, pid, begin, offset, count );
+        }
+
+        template< typename tPrimitive >
+        void Send( uint32_t pid, const tPrimitive &payload )
+        {
+            mBSP.Send( mLocal, pid, nullptr, &payload, sizeof( tPrimitive ) );
+        }
+
+        template< typename tTag, typename tPrimitive >
+        void Send( uint32_t pid, const tTag &tag, const tPrimitive &payload )
+        {
+            mBSP.Send( mLocal, pid, &tag, &payload, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void SendPtrs( uint32_t pid, const tPrimitive *begin, size_t count )
+        {
+            mBSP.Send( mLocal, pid, nullptr, begin, count * sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void Move( tPrimitive &payload )
+        {
+            mBSP.Move( mLocal, &payload, sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void MovePtrs( tPrimitive *begin, size_t count )
+        {
+            mBSP.Move( mLocal, begin, count * sizeof( tPrimitive ) );
+        }
+
+        template< typename tPrimitive >
+        void SendMove( uint32_t pid, std::vector< tPrimitive > &&payload )
+        {
+            mBSP.SendMove( mLocal, pid, nullptr, std::move( payload ) );
+        }
+
+        template< typename tTag, typename tPrimitive >
+        void SendMove( uint32_t pid, const tTag &tag, std::vector< tPrimitive > &&payload )
+        {
+            mBSP.SendMove( mLocal, pid, &tag, std::move( payload ) );
+        }
+
+        template< typename tPrimitive >
+        void MoveOwned( std::vector< tPrimitive > &payload )
+        {
+            mBSP.MoveOwned( mLocal, payload );
+        }
+
+    private:
+
+        BSP &mBSP;
+        BSP::Local mLocal;
+        uint32_t mNProcs;
+
+        Processor( const Processor & );
+        Processor &operator=( const Processor & );
+    };
+
+    /**
+     * Executes the by func given BSP program, and passes every processor a handle to itself.
+     *
+     * @param   func  The function to execute BSP style.
+     * @param   nProc The number of processors to use.
+     *
+     * @return true if it succeeds, false if it fails.
+     */
+
+    inline bool Execute( std::function< void( Processor & ) > func, uint32_t nProc )
+    {
+        return Execute( std::function< void() >( [func]
+        {
+            Processor processor( BSP::GetInstance() );
+            func( processor );
+        } ), nProc );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,379 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_PROFILER_H__
+#define __BSPLIB_PROFILER_H__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The size of a cache line in bytes, used to pad data that different threads write.
+#ifndef BSP_CACHE_LINE_SIZE
+#   define BSP_CACHE_LINE_SIZE 64
+#endif
+
+namespace BspInternal
+{
+    /**
+     * The measurements of one processor in one superstep. Times are in microseconds since the start of the
+     * computation.
+     */
+
+    struct SuperstepProfile
+    {
+        double start;
+        double syncStart;
+        double end;
+        double wait;
+        uint64_t puts;
+        uint64_t putBytes;
+        uint64_t gets;
+        uint64_t getBytes;
+        uint64_t sends;
+        uint64_t sendBytes;
+        uint64_t servedBytes;
+        uint64_t receivedBytes;
+
+        /**
+         * Gets the amount of bytes the processor sent, by puts, sends and answering gets.
+         */
+
+        uint64_t SentBytes() const
+        {
+            return putBytes + sendBytes + servedBytes;
+        }
+    };
+
+    /**
+     * Records per superstep and per processor the compute time, the time waiting in barriers, the time delivering
+     * communication and the communication volume. Every processor only writes its own records, so recording needs
+     * no synchronisation. At the end of the computation the records are written as a Chrome trace, which can be
+     * opened in chrome://tracing or Perfetto, and as a CSV summary.
+     */
+
+    class Profiler
+    {
+    public:
+
+        typedef std::chrono::high_resolution_clock Clock;
+
+        Profiler()
+            : mEnabled( false )
+        {
+        }
+
+        /**
+         * Starts recording a computation.
+         *
+         * @param   nProcs The amount of processors.
+         * @param   prefix The path prefix of the output files, an empty prefix writes no files.
+         * @param   record Whether to record without writing files, for other consumers of the records.
+         */
+
+        void Reset( uint32_t nProcs, const std::string &prefix, bool record )
+        {
+            mPrefix = prefix;
+            mEnabled = !prefix.empty() || record;
+            mProcessors.clear();
+
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            mEpoch = Clock::now();
+
+            for ( uint32_t pid = 0; pid < nProcs; ++pid )
+            {
+                mProcessors.emplace_back( new Processor() );
+            }
+        }
+
+        bool IsEnabled() const
+        {
+            return mEnabled;
+        }
+
+        void CountPut( uint32_t pid, size_t nbytes )
+        {
+            SuperstepProfile &current = mProcessors[pid]->current;
+            ++current.puts;
+            current.putBytes += nbytes;
+        }
+
+        void CountGet( uint32_t pid, size_t nbytes )
+        {
+            SuperstepProfile &current = mProcessors[pid]->current;
+            ++current.gets;
+            current.getBytes += nbytes;
+        }
+
+        void CountSend( uint32_t pid, size_t nbytes )
+        {
+            SuperstepProfile &current = mProcessors[pid]->current;
+            ++current.sends;
+            current.sendBytes += nbytes;
+        }
+
+        /**
+         * Counts the bytes a processor reads from its own registers to answer gets of other processors.
+         */
+
+        void CountServed( uint32_t pid, uint64_t nbytes )
+        {
+            mProcessors[pid]->current.servedBytes += nbytes;
+        }
+
+        /**
+         * Counts the bytes delivered to a processor during the synchronisation.
+         */
+
+        void CountReceived( uint32_t pid, uint64_t nbytes )
+        {
+            mProcessors[pid]->current.receivedBytes += nbytes;
+        }
+
+        uint32_t GetProcessorCount() const
+        {
+            return static_cast< uint32_t >( mProcessors.size() );
+        }
+
+        /**
+         * Marks the end of the compute phase of the current superstep.
+         */
+
+        void BeginSync( uint32_t pid )
+        {
+            mProcessors[pid]->current.syncStart = Now();
+        }
+
+        /**
+         * Adds time spent waiting in a barrier to the current superstep.
+         *
+         * @param   pid    The processor ID.
+         * @param   since  The moment the processor started waiting.
+         */
+
+        void AddWait( uint32_t pid, Clock::time_point since )
+        {
+            mProcessors[pid]->current.wait += std::chrono::duration< double, std::micro >( Clock::now() - since ).count();
+        }
+
+        /**
+         * Closes the current superstep, and starts the next one.
+         */
+
+        void EndSync( uint32_t pid )
+        {
+            Processor &processor = *mProcessors[pid];
+            processor.current.end = Now();
+            processor.steps.push_back( processor.current );
+
+            processor.current = SuperstepProfile();
+            processor.current.start = processor.steps.back().end;
+        }
+
+        /**
+         * Closes the last superstep, which ends without communication.
+         */
+
+        void EndRun( uint32_t pid )
+        {
+            BeginSync( pid );
+            EndSync( pid );
+        }
+
+        /**
+         * Gets the recorded supersteps of a processor.
+         *
+         * @param   pid The processor ID.
+         *
+         * @return The supersteps.
+         */
+
+        const std::vector< SuperstepProfile > &GetSupersteps( uint32_t pid ) const
+        {
+            return mProcessors[pid]->steps;
+        }
+
+        /**
+         * Writes the Chrome trace to `prefix.json` and the summary to `prefix.csv`.
+         *
+         * @pre All processors have ended.
+         */
+
+        void Export() const
+        {
+            if ( mPrefix.empty() )
+            {
+                return;
+            }
+
+            ExportTrace( mPrefix + ".json" );
+            ExportSummary( mPrefix + ".csv" );
+        }
+
+    private:
+
+        /// The counters of a processor, padded on both sides so that they do not share a cache line with the
+        /// counters of another processor or other heap objects, even when the allocations are adjacent.
+        struct Processor
+        {
+            Processor()
+                : current()
+            {
+            }
+
+            char frontPadding[BSP_CACHE_LINE_SIZE];
+            SuperstepProfile current;
+            std::vector< SuperstepProfile > steps;
+            char backPadding[BSP_CACHE_LINE_SIZE];
+        };
+
+        std::vector< std::unique_ptr< Processor > > mProcessors;
+        std::string mPrefix;
+        Clock::time_point mEpoch;
+        bool mEnabled;
+
+        double Now() const
+        {
+            return std::chrono::duration< double, std::micro >( Clock::now() - mEpoch ).count();
+        }
+
+        void ExportTrace( const std::string &path ) const
+        {
+            FILE *file = fopen( path.c_str(), "w" );
+
+            if ( !file )
+            {
+                fprintf( stderr, "Warning: could not write the profile to `%s`.\n", path.c_str() );
+                return;
+            }
+
+            fprintf( file, "{\"traceEvents\":[\n" );
+
+            bool first = true;
+
+            for ( size_t pid = 0; pid < mProcessors.size(); ++pid )
+            {
+                const std::vector< SuperstepProfile > &steps = mProcessors[pid]->steps;
+
+                for ( size_t step = 0; step < steps.size(); ++step )
+                {
+                    const SuperstepProfile &profile = steps[step];
+
+                    fprintf( file, "%s{\"name\":\"compute\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"args\":{\"superstep\":%zu}}",
+                             first ? "" : ",\n", pid, profile.start, profile.syncStart - profile.start, step );
+
+                    fprintf( file, ",\n{\"name\":\"sync\",\"ph\":\"X\",\"pid\":0,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f,"
+                             "\"args\":{\"superstep\":%zu,\"wait\":%.3f,\"delivery\":%.3f,"
+                             "\"puts\":%llu,\"putBytes\":%llu,\"gets\":%llu,\"getBytes\":%llu,"
+                             "\"sends\":%llu,\"sendBytes\":%llu}}",
+                             pid, profile.syncStart, profile.end - profile.syncStart, step, profile.wait,
+                             Delivery( profile ), Count( profile.puts ), Count( profile.putBytes ), Count( profile.gets ),
+                             Count( profile.getBytes ), Count( profile.sends ), Count( profile.sendBytes ) );
+
+                    first = false;
+                }
+            }
+
+            fprintf( file, "\n],\"displayTimeUnit\":\"ms\"}\n" );
+            fclose( file );
+        }
+
+        void ExportSummary( const std::string &path ) const
+        {
+            FILE *file = fopen( path.c_str(), "w" );
+
+            if ( !file )
+            {
+                fprintf( stderr, "Warning: could not write the profile to `%s`.\n", path.c_str() );
+                return;
+            }
+
+            fprintf( file, "superstep,pid,compute_us,wait_us,delivery_us,puts,put_bytes,gets,get_bytes,sends,send_bytes,"
+                     "straggler\n" );
+
+            size_t stepCount = 0;
+
+            for ( const auto &processor : mProcessors )
+            {
+                stepCount = std::max( stepCount, processor->steps.size() );
+            }
+
+            for ( size_t step = 0; step < stepCount; ++step )
+            {
+                // the straggler is the processor with the longest compute phase, that the others wait for
+                size_t straggler = 0;
+                double longest = -1.0;
+
+                for ( size_t pid = 0; pid < mProcessors.size(); ++pid )
+                {
+                    const std::vector< SuperstepProfile > &steps = mProcessors[pid]->steps;
+
+                    if ( step < steps.size() && steps[step].syncStart - steps[step].start > longest )
+                    {
+                        longest = steps[step].syncStart - steps[step].start;
+                        straggler = pid;
+                    }
+                }
+
+                for ( size_t pid = 0; pid < mProcessors.size(); ++pid )
+                {
+                    const std::vector< SuperstepProfile > &steps = mProcessors[pid]->steps;
+
+                    if ( step >= steps.size() )
+                    {
+                        continue;
+                    }
+
+                    const SuperstepProfile &profile = steps[step];
+
+                    fprintf( file, "%zu,%zu,%.3f,%.3f,%.3f,%llu,%llu,%llu,%llu,%llu,%llu,%d\n", step, pid,
+                             profile.syncStart - profile.start, profile.wait, Delivery( profile ), Count( profile.puts ),
+                             Count( profile.putBytes ), Count( profile.gets ), Count( profile.getBytes ),
+                             Count( profile.sends ), Count( profile.sendBytes ), pid == straggler ? 1 : 0 );
+                }
+            }
+
+            fclose( file );
+        }
+
+        static double Delivery( const SuperstepProfile &profile )
+        {
+            return std::max( 0.0, profile.end - profile.syncStart - profile.wait );
+        }
+
+        static unsigned long long Count( uint64_t value )
+        {
+            return static_cast< unsigned long long >( value );
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,479 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_RECORDER_H__
+#define __BSPLIB_RECORDER_H__
+
+#include "bsp/requests.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * One recorded operation of a processor. Only the shape of the communication is recorded, not the payloads.
+     */
+
+    struct ReplayRecord
+    {
+        enum Kind
+        {
+            Sync = 0,
+
+            /// Pushes a register of `size` bytes
+            Push,
+
+            /// Pops the register with global ID `id`
+            Pop,
+
+            /// Changes the tag size to `size`
+            TagSize,
+
+            /// Puts `size` bytes at `offset` in register `id` of `target`
+            Put,
+
+            /// Gets `size` bytes at `offset` in register `id` of `target`
+            Get,
+
+            /// Sends a payload of `size` bytes with a tag of `tagSize` bytes to `target`
+            Send,
+
+            /// Queues an exchange span of `size` bytes for `target`
+            Exchange,
+
+            /// Synchronises by an exchange, which delivers the queued spans
+            ExchangeSync
+        };
+
+        uint32_t kind;
+        uint32_t target;
+        uint64_t id;
+        int64_t offset;
+        uint64_t size;
+        uint64_t tagSize;
+    };
+
+    /**
+     * The recorded operations of all processors in a computation, stored in a binary file. The file starts with the
+     * magic `BSPR`, the format version and the amount of processors, followed per processor by the amount of records
+     * and the records themselves, in the byte order of the recording machine.
+     */
+
+    struct Recording
+    {
+        std::vector< std::vector< ReplayRecord > > processors;
+
+        /**
+         * Reads a recording. The file is not trusted: the counts must fit in the file, and the records must pass
+         * Validate.
+         *
+         * @param   path The path of the file.
+         *
+         * @return true if it succeeds, false if the file could not be read or is not a valid recording.
+         */
+
+        bool Load( const std::string &path )
+        {
+            processors.clear();
+
+            FILE *file = fopen( path.c_str(), "rb" );
+
+            if ( !file )
+            {
+                return false;
+            }
+
+            // the counts in the file are only allocated when the file holds the bytes they take
+            fseek( file, 0, SEEK_END );
+            const long fileSize = ftell( file );
+            fseek( file, 0, SEEK_SET );
+            uint64_t remaining = fileSize > 0 ? static_cast< uint64_t >( fileSize ) : 0;
+
+            char magic[4];
+            uint32_t version = 0;
+            uint32_t nProcs = 0;
+            bool valid = fread( magic, sizeof( magic ), 1, file ) == 1 && !memcmp( magic, "BSPR", 4 ) &&
+                         fread( &version, sizeof( version ), 1, file ) == 1 && version >= 1 && version <= Version() &&
+                         fread( &nProcs, sizeof( nProcs ), 1, file ) == 1;
+
+            remaining -= valid ? sizeof( magic ) + sizeof( version ) + sizeof( nProcs ) : 0;
+            valid = valid && nProcs > 0 && nProcs <= remaining / sizeof( uint64_t );
+
+            processors.resize( valid ? nProcs : 0 );
+
+            for ( auto &records : processors )
+            {
+                uint64_t count = 0;
+                valid = valid && fread( &count, sizeof( count ), 1, file ) == 1;
+                remaining -= valid ? sizeof( count ) : 0;
+                valid = valid && count <= remaining / sizeof( ReplayRecord );
+
+                if ( valid )
+                {
+                    records.resize( static_cast< size_t >( count ) );
+                    valid = count == 0 || fread( records.data(), sizeof( ReplayRecord ), records.size(), file ) == records.size();
+                    remaining -= count * sizeof( ReplayRecord );
+                }
+            }
+
+            fclose( file );
+
+            valid = valid && Validate();
+
+            if ( !valid )
+            {
+                processors.clear();
+            }
+
+            return valid;
+        }
+
+        /**
+         * Writes the recording.
+         *
+         * @param   path The path of the file.
+         *
+         * @return true if it succeeds, false if it fails.
+         */
+
+        bool Save( const std::string &path ) const
+        {
+            FILE *file = fopen( path.c_str(), "wb" );
+
+            if ( !file )
+            {
+                return false;
+            }
+
+            const uint32_t version = Version();
+            const uint32_t nProcs = static_cast< uint32_t >( processors.size() );
+            bool valid = fwrite( "BSPR", 4, 1, file ) == 1 && fwrite( &version, sizeof( version ), 1, file ) == 1 &&
+                         fwrite( &nProcs, sizeof( nProcs ), 1, file ) == 1;
+
+            for ( const auto &records : processors )
+            {
+                const uint64_t count = records.size();
+                valid = valid && fwrite( &count, sizeof( count ), 1, file ) == 1 &&
+                        ( count == 0 || fwrite( records.data(), sizeof( ReplayRecord ), records.size(), file ) == records.size() );
+            }
+
+            return fclose( file ) == 0 && valid;
+        }
+
+        /**
+         * Checks that the records can be replayed: every processor synchronises equally often, targets are
+         * processors of the recording, and puts, gets and pops only use registers the processor pushed before, within
+         * the size the target pushed them with.
+         *
+         * @return true if the recording can be replayed, false otherwise.
+         */
+
+        bool Validate() const
+        {
+            const size_t nProcs = processors.size();
+
+            // global IDs number the registers of a processor in the order it pushed them
+            std::vector< std::vector< uint64_t > > pushed( nProcs );
+
+            for ( size_t pid = 0; pid < nProcs; ++pid )
+            {
+                for ( const ReplayRecord &record : processors[pid] )
+                {
+                    if ( record.kind == ReplayRecord::Push )
+                    {
+                        pushed[pid].push_back( record.size );
+                    }
+                }
+            }
+
+            size_t syncs = 0;
+
+            for ( size_t pid = 0; pid < nProcs; ++pid )
+            {
+                size_t pushes = 0;
+                size_t processorSyncs = 0;
+
+                for ( const ReplayRecord &record : processors[pid] )
+                {
+                    switch ( record.kind )
+                    {
+                    case ReplayRecord::Sync:
+                    case ReplayRecord::ExchangeSync:
+                        ++processorSyncs;
+                        break;
+
+                    case ReplayRecord::Push:
+                        ++pushes;
+                        break;
+
+                    case ReplayRecord::Pop:
+                        if ( record.id >= pushes )
+                        {
+                            return false;
+                        }
+
+                        break;
+
+                    case ReplayRecord::TagSize:
+                        break;
+
+                    case ReplayRecord::Put:
+                    case ReplayRecord::Get:
+                        if ( record.target >= nProcs || record.offset < 0 )
+                        {
+                            return false;
+                        }
+
+                        if ( record.id == CollectiveRegister )
+                        {
+                            // only puts go to the collective buffer
+                            if ( record.kind == ReplayRecord::Get )
+                            {
+                                return false;
+                            }
+                        }
+                        else if ( record.id < FirstSlotRegister )
+                        {
+                            const std::vector< uint64_t > &sizes = pushed[record.target];
+                            const uint64_t offset = static_cast< uint64_t >( record.offset );
+
+                            if ( record.id >= pushes || record.id >= sizes.size() ||
+                                    offset > sizes[static_cast< size_t >( record.id )] ||
+                                    record.size > sizes[static_cast< size_t >( record.id )] - offset )
+                            {
+                                return false;
+                            }
+                        }
+
+                        break;
+
+                    case ReplayRecord::Send:
+                    case ReplayRecord::Exchange:
+                        if ( record.target >= nProcs )
+                        {
+                            return false;
+                        }
+
+                        break;
+
+                    default:
+                        return false;
+                    }
+                }
+
+                if ( pid == 0 )
+                {
+                    syncs = processorSyncs;
+                }
+                else if ( processorSyncs != syncs )
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// The format version, version 2 added the exchange records.
+        static uint32_t Version()
+        {
+            return 2;
+        }
+    };
+
+    /**
+     * Records the operations of every processor during a computation. At synchronisation every processor appends its
+     * own queued requests, so recording needs no synchronisation.
+     *
+     * Group puts and group synchronisations are not recorded, since replaying them needs the same hierarchy; a
+     * computation that uses them is not written, rather than written without part of its traffic.
+     */
+
+    class Recorder
+    {
+    public:
+
+        Recorder()
+            : mEnabled( false ),
+              mUsedGroups( false )
+        {
+        }
+
+        /**
+         * Starts recording a computation.
+         *
+         * @param   nProcs The amount of processors.
+         * @param   path   The path of the output file, an empty path disables recording.
+         */
+
+        void Reset( uint32_t nProcs, const std::string &path )
+        {
+            mPath = path;
+            mEnabled = !path.empty();
+            mRecording.processors.clear();
+            mTagSizes.clear();
+            mUsedGroups = false;
+
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            mRecording.processors.resize( nProcs );
+            mTagSizes.resize( nProcs, 0 );
+        }
+
+        bool IsEnabled() const
+        {
+            return mEnabled;
+        }
+
+        /**
+         * Records the queued requests of a processor in the current superstep, followed by its synchronisation.
+         *
+         * @param   pid         The processor ID.
+         * @param   pushSizes   The sizes of the registers pushed in this superstep.
+         * @param   popIds      The global IDs of the registers popped in this superstep.
+         * @param   tagSize     The tag size the processor requested.
+         * @param   putQueues   The put queues of the processor per target, or nullptr.
+         * @param   getQueues   The get queues of the processor per target, or nullptr.
+         * @param   sendQueues  The send queues of the processor per target, or nullptr.
+         * @param   exchangeQueues The exchange spans of the processor per target, or nullptr.
+         * @param   exchanging  Whether the processor synchronises by an exchange.
+         */
+
+        template< typename tPutQueue, typename tGetQueue, typename tSendQueue, typename tExchangeQueue >
+        void Capture( uint32_t pid, const std::vector< size_t > &pushSizes, const std::vector< size_t > &popIds,
+                      size_t tagSize, const tPutQueue *putQueues, const tGetQueue *getQueues,
+                      const tSendQueue *sendQueues, const tExchangeQueue *exchangeQueues, bool exchanging )
+        {
+            std::vector< ReplayRecord > &records = mRecording.processors[pid];
+            const uint32_t nProcs = static_cast< uint32_t >( mRecording.processors.size() );
+
+            for ( size_t size : pushSizes )
+            {
+                records.push_back( ReplayRecord{ ReplayRecord::Push, 0, 0, 0, size, 0 } );
+            }
+
+            for ( size_t id : popIds )
+            {
+                records.push_back( ReplayRecord{ ReplayRecord::Pop, 0, id, 0, 0, 0 } );
+            }
+
+            if ( tagSize != mTagSizes[pid] )
+            {
+                records.push_back( ReplayRecord{ ReplayRecord::TagSize, 0, 0, 0, tagSize, 0 } );
+                mTagSizes[pid] = tagSize;
+            }
+
+            for ( uint32_t target = 0; target < nProcs; ++target )
+            {
+                if ( putQueues )
+                {
+                    for ( const auto &request : putQueues[target] )
+                    {
+                        records.push_back( ReplayRecord{ ReplayRecord::Put, target, request.globalId, request.offset,
+                                                         request.size, 0 } );
+                    }
+                }
+
+                if ( getQueues )
+                {
+                    for ( const auto &request : getQueues[target] )
+                    {
+                        records.push_back( ReplayRecord{ ReplayRecord::Get, target, request.globalId, request.offset,
+                                                         request.size, 0 } );
+                    }
+                }
+
+                if ( sendQueues )
+                {
+                    for ( const auto &request : sendQueues[target] )
+                    {
+                        records.push_back( ReplayRecord{ ReplayRecord::Send, target, 0, 0, request.bufferSize,
+                                                         request.tagSize } );
+                    }
+                }
+
+                if ( exchangeQueues )
+                {
+                    for ( const auto &request : exchangeQueues[target] )
+                    {
+                        records.push_back( ReplayRecord{ ReplayRecord::Exchange, target, 0, 0, request.size, 0 } );
+                    }
+                }
+            }
+
+            records.push_back( ReplayRecord{ exchanging ? ReplayRecord::ExchangeSync : ReplayRecord::Sync, 0, 0, 0, 0,
+                                             0 } );
+        }
+
+        /**
+         * Marks that the computation put or synchronised within a group, so its recording is not written.
+         */
+
+        void UseGroups()
+        {
+            mUsedGroups = true;
+        }
+
+        const Recording &GetRecording() const
+        {
+            return mRecording;
+        }
+
+        /**
+         * Writes the recording to the file.
+         *
+         * @pre All processors have ended.
+         */
+
+        void Export() const
+        {
+            if ( mEnabled && mUsedGroups )
+            {
+                fprintf( stderr, "Warning: the computation used group communication, which can not be replayed; no "
+                         "recording is written to `%s`.\n", mPath.c_str() );
+            }
+            else if ( mEnabled && !mRecording.Save( mPath ) )
+            {
+                fprintf( stderr, "Warning: could not write the recording to `%s`.\n", mPath.c_str() );
+            }
+        }
+
+    private:
+
+        Recording mRecording;
+        std::vector< size_t > mTagSizes;
+        std::string mPath;
+        bool mEnabled;
+        std::atomic_bool mUsedGroups;
+    };
+}
+
+#endif
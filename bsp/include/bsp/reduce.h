@@ -0,0 +1,406 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_REDUCE_H__
+#define __BSPLIB_REDUCE_H__
+
+#include "bsp/group.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+/// Reductions of which every member sends at most this amount of bytes in total are done in one superstep.
+#ifndef BSP_REDUCE_ONE_PHASE_BYTES
+#   define BSP_REDUCE_ONE_PHASE_BYTES 65536
+#endif
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    enum class ReduceAlgorithm
+    {
+        /// Chooses the algorithm by the array size and the group size.
+        Automatic,
+        /// Every member puts its array to the receivers, in one superstep.
+        OnePhase,
+        /// Every member reduces one block of the arrays, and the reduced blocks are gathered, in two supersteps.
+        ReduceScatter,
+        /// Members exchange their partial results pairwise, in log2( size ) supersteps.
+        RecursiveDoubling
+    };
+
+    /// Adds two values.
+    struct Sum
+    {
+        template< typename tPrimitive >
+        tPrimitive operator()( const tPrimitive &a, const tPrimitive &b ) const
+        {
+            return a + b;
+        }
+    };
+
+    /// Multiplies two values.
+    struct Product
+    {
+        template< typename tPrimitive >
+        tPrimitive operator()( const tPrimitive &a, const tPrimitive &b ) const
+        {
+            return a * b;
+        }
+    };
+
+    /// Takes the smallest of two values.
+    struct Min
+    {
+        template< typename tPrimitive >
+        tPrimitive operator()( const tPrimitive &a, const tPrimitive &b ) const
+        {
+            return b < a ? b : a;
+        }
+    };
+
+    /// Takes the largest of two values.
+    struct Max
+    {
+        template< typename tPrimitive >
+        tPrimitive operator()( const tPrimitive &a, const tPrimitive &b ) const
+        {
+            return a < b ? b : a;
+        }
+    };
+
+    /**
+     * Chooses the reduction algorithm. Small arrays go in one superstep, arrays of at least one element per member
+     * are split in blocks so that every member sends about the array size, and smaller arrays on large groups are
+     * exchanged pairwise.
+     *
+     * @param   size   The group size.
+     * @param   nbytes The array size in bytes.
+     * @param   count  The amount of elements.
+     *
+     * @return The algorithm.
+     */
+
+    inline ReduceAlgorithm ChooseReduce( uint32_t size, size_t nbytes, size_t count )
+    {
+        if ( size <= 2 || static_cast< uint64_t >( size - 1 ) * nbytes <= BSP_REDUCE_ONE_PHASE_BYTES )
+        {
+            return ReduceAlgorithm::OnePhase;
+        }
+
+        return count >= size ? ReduceAlgorithm::ReduceScatter : ReduceAlgorithm::RecursiveDoubling;
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+namespace BspInternal
+{
+    /**
+     * Combines two arrays element wise, dst[i] = op( dst[i], src[i] ). The arrays do not overlap, so the loop is
+     * vectorised for the built-in operators.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    BSP_FORCEINLINE void Combine( tPrimitive *BSP_RESTRICT dst, const tPrimitive *BSP_RESTRICT src, size_t count, tOp op )
+    {
+        for ( size_t i = 0; i < count; ++i )
+        {
+            dst[i] = op( dst[i], src[i] );
+        }
+    }
+
+    /**
+     * Reduces the arrays of all members of a group. Partial results are always combined with the result of the lower
+     * ranks on the left, so the operator needs to be associative but not commutative, and every member gets the
+     * same result.
+     *
+     * @param [in,out]  values The array of this member, the result on the receivers.
+     * @param   count          The amount of elements.
+     * @param   op             The operator.
+     * @param   root           The rank of the receiver, or the group size for all members.
+     * @param   collective     The collective state.
+     * @param   algorithm      The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void Reduce( tPrimitive *values, size_t count, tOp op, uint32_t root, Collective &collective,
+                 BSP_NAMESPACE::ReduceAlgorithm algorithm )
+    {
+        typedef BSP_NAMESPACE::ReduceAlgorithm Algorithm;
+
+        const uint32_t size = collective.Size();
+        const uint32_t rank = collective.Rank();
+        const bool all = root >= size;
+        const size_t nbytes = count * sizeof( tPrimitive );
+
+        if ( algorithm == Algorithm::Automatic )
+        {
+            algorithm = BSP_NAMESPACE::ChooseReduce( size, nbytes, count );
+        }
+
+        switch ( algorithm )
+        {
+        case Algorithm::ReduceScatter:
+            {
+                // member r reduces block r of all arrays, and then puts it to the receivers
+                const size_t block = ( count + size - 1 ) / size;
+                const size_t begin = std::min( count, rank * block );
+                const size_t end = std::min( count, begin + block );
+                std::vector< tPrimitive > blocks( block * size );
+
+                collective.Receive( blocks.data() );
+
+                for ( uint32_t r = 0; r < size; ++r )
+                {
+                    const size_t first = std::min( count, r * block );
+                    const size_t last = std::min( count, first + block );
+
+                    if ( r == rank )
+                    {
+                        std::copy( values + first, values + last, blocks.begin() + rank * block );
+                    }
+                    else
+                    {
+                        collective.Put( r, values + first, rank * block * sizeof( tPrimitive ),
+                                        ( last - first ) * sizeof( tPrimitive ) );
+                    }
+                }
+
+                collective.Sync();
+
+                for ( uint32_t r = 1; r < size; ++r )
+                {
+                    Combine( blocks.data(), blocks.data() + r * block, end - begin, op );
+                }
+
+                std::copy( blocks.begin(), blocks.begin() + ( end - begin ), values + begin );
+                collective.Receive( values );
+
+                for ( uint32_t r = 0; r < size; ++r )
+                {
+                    if ( r != rank && ( all || r == root ) )
+                    {
+                        collective.Put( r, values + begin, begin * sizeof( tPrimitive ), ( end - begin ) * sizeof( tPrimitive ) );
+                    }
+                }
+
+                collective.Sync();
+            }
+            break;
+
+        case Algorithm::RecursiveDoubling:
+            {
+                // the first 2 e members fold pairwise, to leave a power of two of members in rank order
+                uint32_t power = 1;
+
+                while ( power * 2 <= size )
+                {
+                    power *= 2;
+                }
+
+                const uint32_t extra = size - power;
+                const bool folded = rank < 2 * extra && rank % 2 == 1;
+                const uint32_t virtualRank = rank < 2 * extra ? rank / 2 : rank - extra;
+
+                std::vector< tPrimitive > partner( count );
+                collective.Receive( partner.data() );
+
+                if ( folded )
+                {
+                    collective.Put( rank - 1, values, 0, nbytes );
+                }
+
+                collective.Sync();
+
+                if ( rank < 2 * extra && !folded )
+                {
+                    Combine( values, partner.data(), count, op );
+                }
+
+                for ( uint32_t mask = 1; mask < power; mask <<= 1 )
+                {
+                    const uint32_t other = virtualRank ^ mask;
+
+                    if ( !folded )
+                    {
+                        collective.Put( other < extra ? 2 * other : other + extra, values, 0, nbytes );
+                    }
+
+                    collective.Sync();
+
+                    if ( !folded )
+                    {
+                        // the partner with the lower rank holds the left operand
+                        if ( virtualRank & mask )
+                        {
+                            Combine( partner.data(), values, count, op );
+                            std::copy( partner.begin(), partner.end(), values );
+                        }
+                        else
+                        {
+                            Combine( values, partner.data(), count, op );
+                        }
+                    }
+                }
+
+                collective.Receive( values );
+
+                if ( rank < 2 * extra && !folded && ( all || rank + 1 == root ) )
+                {
+                    collective.Put( rank + 1, values, 0, nbytes );
+                }
+
+                collective.Sync();
+            }
+            break;
+
+        default:
+            {
+                const bool receiver = all || rank == root;
+                std::vector< tPrimitive > arrays( receiver ? count * size : 0 );
+
+                collective.Receive( arrays.data() );
+
+                for ( uint32_t r = 0; r < size; ++r )
+                {
+                    if ( r != rank && ( all || r == root ) )
+                    {
+                        collective.Put( r, values, rank * nbytes, nbytes );
+                    }
+                }
+
+                collective.Sync();
+
+                if ( receiver )
+                {
+                    std::copy( values, values + count, arrays.begin() + rank * count );
+
+                    for ( uint32_t r = 1; r < size; ++r )
+                    {
+                        Combine( arrays.data(), arrays.data() + r * count, count, op );
+                    }
+
+                    std::copy( arrays.begin(), arrays.begin() + count, values );
+                }
+            }
+            break;
+        }
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Reduces the arrays of all members of the group element wise, and stores the result on the root.
+     *
+     * @param [in,out]  begin The array of this member, the result on the root. Other members keep partial results.
+     * @param   count         The amount of elements, equal on all members.
+     * @param   op            The associative operator, such as Sum, Product, Min or Max.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void ReducePtrs( tPrimitive *begin, size_t count, tOp op, uint32_t root = 0, const Group &group = Group(),
+                     ReduceAlgorithm algorithm = ReduceAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Reduce( begin, count, op, group.Rank( root ), collective, algorithm );
+    }
+
+    /**
+     * Reduces the arrays of all members of the group element wise, and stores the result on all members.
+     *
+     * @param [in,out]  begin The array of this member, the result afterwards.
+     * @param   count         The amount of elements, equal on all members.
+     * @param   op            The associative operator, such as Sum, Product, Min or Max.
+     * @param   group         The group.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void AllReducePtrs( tPrimitive *begin, size_t count, tOp op, const Group &group = Group(),
+                        ReduceAlgorithm algorithm = ReduceAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Reduce( begin, count, op, collective.Size(), collective, algorithm );
+    }
+
+    /**
+     * Reduces a value over all members of the group, and stores the result on the root.
+     *
+     * @param [in,out]  value The value of this member, the result on the root.
+     * @param   op            The associative operator.
+     * @param   root          The processor ID of the root.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void Reduce( tPrimitive &value, tOp op, uint32_t root = 0, const Group &group = Group() )
+    {
+        ReducePtrs( &value, 1, op, root, group );
+    }
+
+    /**
+     * Reduces a value over all members of the group, and stores the result on all members.
+     *
+     * @param [in,out]  value The value of this member, the result afterwards.
+     * @param   op            The associative operator.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void AllReduce( tPrimitive &value, tOp op, const Group &group = Group() )
+    {
+        AllReducePtrs( &value, 1, op, group );
+    }
+
+    /**
+     * Reduces vectors over all members of the group element wise, and stores the result on all members.
+     *
+     * @param [in,out]  values The values of this member, the result afterwards.
+     * @param   op             The associative operator.
+     * @param   group          The group.
+     *
+     * @pre All members pass vectors of the same size.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void AllReduce( std::vector< tPrimitive > &values, tOp op, const Group &group = Group() )
+    {
+        AllReducePtrs( values.data(), values.size(), op, group );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
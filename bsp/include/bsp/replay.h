@@ -0,0 +1,211 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_REPLAY_H__
+#define __BSPLIB_REPLAY_H__
+
+#include "bsp/bspExt.h"
+#include "bsp/recorder.h"
+
+#include <algorithm>
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Replays a recorded computation. Every processor pushes registers of the recorded sizes, and performs the
+     * recorded puts, gets, sends and exchanges with synthetic payloads, so the synchronisation handles the same traffic as in
+     * the recorded computation.
+     *
+     * @param   recording The recording.
+     * @param   seconds   The wall time of the replay on the first processor.
+     *
+     * @return true if it succeeds, false if the recording does not validate or the replay fails.
+     */
+
+    inline bool Replay( const BspInternal::Recording &recording, double &seconds )
+    {
+        typedef BspInternal::ReplayRecord Record;
+
+        const uint32_t nProcs = static_cast< uint32_t >( recording.processors.size() );
+
+        if ( nProcs == 0 || !recording.Validate() )
+        {
+            return false;
+        }
+
+        // collective puts go to the collective buffer of the receiver, which must hold the largest of them, and
+        // communication with slots to buffers bound to the slots
+        size_t collectiveSize = 1;
+        std::vector< size_t > slotSizes( BSP_REGISTER_SLOTS, 1 );
+
+        for ( const auto &records : recording.processors )
+        {
+            for ( const Record &record : records )
+            {
+                const size_t end = static_cast< size_t >( record.offset + record.size );
+
+                if ( record.kind == Record::Put && record.id == BspInternal::CollectiveRegister )
+                {
+                    collectiveSize = std::max( collectiveSize, end );
+                }
+                else if ( ( record.kind == Record::Put || record.kind == Record::Get ) &&
+                          record.id >= BspInternal::FirstSlotRegister )
+                {
+                    size_t &slotSize = slotSizes[static_cast< size_t >( record.id - BspInternal::FirstSlotRegister )];
+                    slotSize = std::max( slotSize, end );
+                }
+            }
+        }
+
+        return Execute( [&recording, &seconds, collectiveSize, &slotSizes]
+        {
+            BSP &bsp = BSP::GetInstance();
+            BSP::Local local = bsp.GetLocal( ProcId() );
+            const std::vector< Record > &records = recording.processors[ProcId()];
+
+            size_t scratchSize = 1;
+
+            for ( const Record &record : records )
+            {
+                scratchSize = std::max( scratchSize, static_cast< size_t >( std::max( record.size, record.tagSize ) ) );
+            }
+
+            std::vector< char > scratch( scratchSize, 0 );
+            std::vector< char > collective( collectiveSize, 0 );
+            std::vector< std::vector< char > > registers;
+            std::vector< char > exchanged;
+            std::vector< size_t > exchangeOffsets;
+
+            bsp.SetCollectiveBuffer( local, collective.data() );
+
+            std::vector< std::vector< char > > slots;
+
+            for ( size_t slot = 0; slot < BSP_REGISTER_SLOTS; ++slot )
+            {
+                slots.emplace_back( slotSizes[slot], 0 );
+                bsp.BindSlot( local, slot, slots.back().data(), slots.back().size() );
+            }
+
+            const double start = Time();
+
+            for ( const Record &record : records )
+            {
+                switch ( record.kind )
+                {
+                case Record::Sync:
+                    Sync();
+                    break;
+
+                case Record::Push:
+                    registers.emplace_back( std::max< size_t >( static_cast< size_t >( record.size ), 1 ) );
+                    Classic::Push( registers.back().data(), static_cast< size_t >( record.size ) );
+                    break;
+
+                case Record::Pop:
+                    Classic::Pop( registers[static_cast< size_t >( record.id )].data() );
+                    break;
+
+                case Record::TagSize:
+                    {
+                        size_t size = static_cast< size_t >( record.size );
+                        Classic::SetTagSize( &size );
+                    }
+                    break;
+
+                case Record::Put:
+                    if ( record.id == BspInternal::CollectiveRegister )
+                    {
+                        bsp.CollectivePut( local, record.target, scratch.data(), static_cast< ptrdiff_t >( record.offset ),
+                                           static_cast< size_t >( record.size ) );
+                        break;
+                    }
+
+                    if ( record.id >= BspInternal::FirstSlotRegister )
+                    {
+                        bsp.PutId( local, record.target, scratch.data(), static_cast< size_t >( record.id ),
+                                   static_cast< ptrdiff_t >( record.offset ), static_cast< size_t >( record.size ) );
+                        break;
+                    }
+
+                    Classic::Put( record.target, scratch.data(), registers[static_cast< size_t >( record.id )].data(),
+                                  static_cast< ptrdiff_t >( record.offset ), static_cast< size_t >( record.size ) );
+                    break;
+
+                case Record::Get:
+                    if ( record.id >= BspInternal::FirstSlotRegister )
+                    {
+                        bsp.GetId( local, record.target, static_cast< size_t >( record.id ),
+                                   static_cast< ptrdiff_t >( record.offset ), scratch.data(),
+                                   static_cast< size_t >( record.size ) );
+                        break;
+                    }
+
+                    Classic::Get( record.target, registers[static_cast< size_t >( record.id )].data(),
+                                  static_cast< ptrdiff_t >( record.offset ), scratch.data(),
+                                  static_cast< size_t >( record.size ) );
+                    break;
+
+                case Record::Send:
+                    Classic::Send( record.target, scratch.data(), scratch.data(), static_cast< size_t >( record.size ) );
+                    break;
+
+                case Record::Exchange:
+                    bsp.ExchangeSpan( local, record.target, scratch.data(), static_cast< size_t >( record.size ) );
+                    break;
+
+                case Record::ExchangeSync:
+                    bsp.Exchange( local, exchanged, exchangeOffsets );
+                    break;
+                }
+            }
+
+            // the recording ends with a synchronisation, so all processors are done
+            if ( ProcId() == 0 )
+            {
+                seconds = Time() - start;
+            }
+        }, nProcs );
+    }
+
+    /**
+     * Replays a computation recorded to a file.
+     *
+     * @param   path    The path of the recording.
+     * @param   seconds The wall time of the replay on the first processor.
+     *
+     * @return true if it succeeds, false if the file could not be read or the replay fails.
+     */
+
+    inline bool Replay( const std::string &path, double &seconds )
+    {
+        BspInternal::Recording recording;
+        return recording.Load( path ) && Replay( recording, seconds );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
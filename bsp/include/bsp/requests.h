@@ -25,6 +25,15 @@
 
 #include "bsp/stackAllocator.h"
 
+#include <memory>
+#include <utility>
+#include <vector>
+
+/// The amount of registration slots of every processor.
+#ifndef BSP_REGISTER_SLOTS
+#   define BSP_REGISTER_SLOTS 16
+#endif
+
 namespace BspInternal
 {
     struct RegisterInfo
@@ -33,6 +42,19 @@ namespace BspInternal
         size_t registerCount;
     };
 
+    /// The global ID of put requests that write to the collective buffer of the receiving processor.
+    const size_t CollectiveRegister = static_cast< size_t >( -1 );
+
+    /// The global ID of the first registration slot, the slots lie just below the collective register.
+    const size_t FirstSlotRegister = CollectiveRegister - BSP_REGISTER_SLOTS;
+
+    /// A variable bound to a registration slot, see BSPLib::BindSlot.
+    struct RegisterSlot
+    {
+        const void *location;
+        size_t size;
+    };
+
     struct PutRequest
     {
         StackAllocator::StackLocation bufferLocation;
@@ -42,6 +64,13 @@ namespace BspInternal
         size_t size;
     };
 
+    /// A span of bytes for another processor, read straight from the memory of the sender by the receiver.
+    struct ExchangeRequest
+    {
+        const char *data;
+        size_t size;
+    };
+
     struct GetRequest
     {
         const void *destination;
@@ -50,6 +79,37 @@ namespace BspInternal
         size_t size;
     };
 
+    /// A payload of which the sender handed over ownership, instead of copying it to the send buffer.
+    class OwnedPayload
+    {
+    public:
+
+        virtual ~OwnedPayload()
+        {
+        }
+
+        virtual const char *Data() const = 0;
+    };
+
+    template< typename tPrimitive >
+    class OwnedVector
+        : public OwnedPayload
+    {
+    public:
+
+        explicit OwnedVector( std::vector< tPrimitive > &&payload )
+            : vector( std::move( payload ) )
+        {
+        }
+
+        const char *Data() const override
+        {
+            return reinterpret_cast< const char * >( vector.data() );
+        }
+
+        std::vector< tPrimitive > vector;
+    };
+
     struct SendRequest
     {
         StackAllocator::StackLocation bufferLocation;
@@ -57,6 +117,16 @@ namespace BspInternal
 
         StackAllocator::StackLocation tagLocation;
         size_t tagSize;
+
+        /// The payload when it was moved instead of copied, in which case bufferLocation is unused.
+        std::unique_ptr< OwnedPayload > owned;
+    };
+
+    /// A buffer of a processor pool, that is in use until the given superstep has ended.
+    struct PooledBuffer
+    {
+        size_t superstep;
+        std::vector< char > buffer;
     };
 
     struct PushRequest
@@ -0,0 +1,308 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_SCAN_H__
+#define __BSPLIB_SCAN_H__
+
+#include "bsp/reduce.h"
+
+#include <algorithm>
+#include <vector>
+
+/// Scans of which the first member sends at most this amount of bytes in total are done in one superstep.
+#ifndef BSP_SCAN_ONE_PHASE_BYTES
+#   define BSP_SCAN_ONE_PHASE_BYTES 65536
+#endif
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    enum class ScanAlgorithm
+    {
+        /// Chooses the algorithm by the array size and the group size.
+        Automatic,
+        /// Every member puts its array to all higher ranks, in one superstep.
+        OnePhase,
+        /// Members pass their partial results to the member 1, 2, 4, ... ranks higher, in ceil( log2( size ) )
+        /// supersteps.
+        Logarithmic
+    };
+
+    /**
+     * Chooses the scan algorithm. Scans go in one superstep while the first member sends little data, and take a
+     * logarithmic amount of supersteps otherwise.
+     *
+     * @param   size   The group size.
+     * @param   nbytes The array size in bytes.
+     *
+     * @return The algorithm.
+     */
+
+    inline ScanAlgorithm ChooseScan( uint32_t size, size_t nbytes )
+    {
+        if ( size <= 2 || static_cast< uint64_t >( size - 1 ) * nbytes <= BSP_SCAN_ONE_PHASE_BYTES )
+        {
+            return ScanAlgorithm::OnePhase;
+        }
+
+        return ScanAlgorithm::Logarithmic;
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+namespace BspInternal
+{
+    /**
+     * Computes the element wise prefixes of the arrays of the members of a group, in rank order.
+     *
+     * @param [in,out]  values The array of this member, the prefix afterwards.
+     * @param   count          The amount of elements.
+     * @param   op             The associative operator.
+     * @param   identity       The result of the exclusive scan on the first member, or null for the inclusive
+     *                         scan.
+     * @param   collective     The collective state.
+     * @param   algorithm      The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp >
+    void Scan( tPrimitive *values, size_t count, tOp op, const tPrimitive *identity, Collective &collective,
+               BSP_NAMESPACE::ScanAlgorithm algorithm )
+    {
+        typedef BSP_NAMESPACE::ScanAlgorithm Algorithm;
+
+        const uint32_t size = collective.Size();
+        const uint32_t rank = collective.Rank();
+        const size_t nbytes = count * sizeof( tPrimitive );
+
+        if ( algorithm == Algorithm::Automatic )
+        {
+            algorithm = BSP_NAMESPACE::ChooseScan( size, nbytes );
+        }
+
+        if ( algorithm == Algorithm::Logarithmic )
+        {
+            // partial covers the ranks ( rank - 2 d, rank ], and exclusive the ranks ( rank - 2 d, rank ) after
+            // the step of distance d
+            std::vector< tPrimitive > partial( values, values + count );
+            std::vector< tPrimitive > partner( count );
+            std::vector< tPrimitive > exclusive;
+
+            for ( uint32_t distance = 1; distance < size; distance <<= 1 )
+            {
+                collective.Receive( partner.data() );
+
+                if ( rank + distance < size )
+                {
+                    collective.Put( rank + distance, partial.data(), 0, nbytes );
+                }
+
+                collective.Sync();
+
+                if ( rank >= distance )
+                {
+                    if ( identity )
+                    {
+                        if ( exclusive.empty() )
+                        {
+                            exclusive = partner;
+                        }
+                        else
+                        {
+                            std::vector< tPrimitive > left( partner );
+                            Combine( left.data(), exclusive.data(), count, op );
+                            exclusive.swap( left );
+                        }
+                    }
+
+                    Combine( partner.data(), partial.data(), count, op );
+                    partial.swap( partner );
+                }
+            }
+
+            if ( !identity )
+            {
+                std::copy( partial.begin(), partial.end(), values );
+            }
+            else if ( rank == 0 )
+            {
+                std::fill( values, values + count, *identity );
+            }
+            else
+            {
+                std::copy( exclusive.begin(), exclusive.end(), values );
+            }
+
+            return;
+        }
+
+        std::vector< tPrimitive > arrays( count * rank );
+        collective.Receive( arrays.data() );
+
+        for ( uint32_t r = rank + 1; r < size; ++r )
+        {
+            collective.Put( r, values, rank * nbytes, nbytes );
+        }
+
+        collective.Sync();
+
+        if ( rank == 0 )
+        {
+            if ( identity )
+            {
+                std::fill( values, values + count, *identity );
+            }
+
+            return;
+        }
+
+        for ( uint32_t r = 1; r < rank; ++r )
+        {
+            Combine( arrays.data(), arrays.data() + r * count, count, op );
+        }
+
+        if ( !identity )
+        {
+            Combine( arrays.data(), values, count, op );
+        }
+
+        std::copy( arrays.begin(), arrays.begin() + count, values );
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Computes the inclusive prefixes of the arrays of the group members element wise, so that the member of rank r
+     * gets op( x_0, op( x_1, ... x_r ) ).
+     *
+     * @param [in,out]  begin The array of this member, the prefix afterwards.
+     * @param   count         The amount of elements, equal on all members.
+     * @param   op            The associative operator.
+     * @param   group         The group.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void ScanPtrs( tPrimitive *begin, size_t count, tOp op = tOp(), const Group &group = Group(),
+                   ScanAlgorithm algorithm = ScanAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Scan( begin, count, op, static_cast< const tPrimitive * >( nullptr ), collective, algorithm );
+    }
+
+    /**
+     * Computes the exclusive prefixes of the arrays of the group members element wise, so that the member of rank
+     * r > 0 gets op( x_0, op( x_1, ... x_r-1 ) ), and the member of rank 0 the identity.
+     *
+     * @param [in,out]  begin The array of this member, the prefix afterwards.
+     * @param   count         The amount of elements, equal on all members.
+     * @param   op            The associative operator.
+     * @param   group         The group.
+     * @param   identity      The result of the first member.
+     * @param   algorithm     The algorithm.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void ExScanPtrs( tPrimitive *begin, size_t count, tOp op = tOp(), const Group &group = Group(),
+                     const tPrimitive &identity = tPrimitive(), ScanAlgorithm algorithm = ScanAlgorithm::Automatic )
+    {
+        BspInternal::Collective collective( group );
+        BspInternal::Scan( begin, count, op, &identity, collective, algorithm );
+    }
+
+    /**
+     * Computes the inclusive prefix of a value over the group members.
+     *
+     * @param [in,out]  value The value of this member, the prefix afterwards.
+     * @param   op            The associative operator.
+     * @param   group         The group.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void Scan( tPrimitive &value, tOp op = tOp(), const Group &group = Group() )
+    {
+        ScanPtrs( &value, 1, op, group );
+    }
+
+    /**
+     * Computes the exclusive prefix of a value over the group members, such as the offset of the data of this
+     * member in the concatenation of the data of all members.
+     *
+     * @param [in,out]  value The value of this member, the prefix afterwards.
+     * @param   op            The associative operator.
+     * @param   group         The group.
+     * @param   identity      The result of the first member.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void ExScan( tPrimitive &value, tOp op = tOp(), const Group &group = Group(),
+                 const tPrimitive &identity = tPrimitive() )
+    {
+        ExScanPtrs( &value, 1, op, group, identity );
+    }
+
+    /**
+     * Computes the inclusive prefixes of vectors over the group members element wise.
+     *
+     * @param [in,out]  values The values of this member, the prefixes afterwards.
+     * @param   op             The associative operator.
+     * @param   group          The group.
+     *
+     * @pre All members pass vectors of the same size.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void Scan( std::vector< tPrimitive > &values, tOp op = tOp(), const Group &group = Group() )
+    {
+        ScanPtrs( values.data(), values.size(), op, group );
+    }
+
+    /**
+     * Computes the exclusive prefixes of vectors over the group members element wise, such as bucket offsets.
+     *
+     * @param [in,out]  values The values of this member, the prefixes afterwards.
+     * @param   op             The associative operator.
+     * @param   group          The group.
+     * @param   identity       The result of the first member.
+     *
+     * @pre All members pass vectors of the same size.
+     */
+
+    template< typename tPrimitive, typename tOp = Sum >
+    void ExScan( std::vector< tPrimitive > &values, tOp op = tOp(), const Group &group = Group(),
+                 const tPrimitive &identity = tPrimitive() )
+    {
+        ExScanPtrs( values.data(), values.size(), op, group, identity );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
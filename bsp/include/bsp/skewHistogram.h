@@ -0,0 +1,274 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_SKEWHISTOGRAM_H__
+#define __BSPLIB_SKEWHISTOGRAM_H__
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// The amount of buckets of a skew histogram, the last bucket holds all larger skews.
+#ifndef BSP_SKEW_BUCKETS
+#   define BSP_SKEW_BUCKETS 24
+#endif
+
+namespace BspInternal
+{
+    /**
+     * A histogram of barrier arrival skews, the time from the arrival of a processor at a synchronisation until the
+     * last processor arrived. Bucket 0 holds skews below 1 microsecond, and bucket b skews from 2^(b-1) up to 2^b
+     * microseconds.
+     */
+
+    struct SkewHistogram
+    {
+        SkewHistogram()
+            : supersteps( 0 ),
+              total( 0.0 ),
+              max( 0.0 )
+        {
+            for ( uint64_t &count : counts )
+            {
+                count = 0;
+            }
+        }
+
+        uint64_t counts[BSP_SKEW_BUCKETS];
+        uint64_t supersteps;
+
+        /// The sum of all skews in microseconds
+        double total;
+
+        /// The largest skew in microseconds
+        double max;
+
+        /**
+         * Adds a skew to the histogram.
+         *
+         * @param   skew The skew in microseconds.
+         */
+
+        void Add( double skew )
+        {
+            ++counts[Bucket( skew )];
+            ++supersteps;
+            total += skew;
+            max = skew > max ? skew : max;
+        }
+
+        /**
+         * Adds all skews of another histogram.
+         *
+         * @param   other The other histogram.
+         */
+
+        void Merge( const SkewHistogram &other )
+        {
+            for ( size_t bucket = 0; bucket < BSP_SKEW_BUCKETS; ++bucket )
+            {
+                counts[bucket] += other.counts[bucket];
+            }
+
+            supersteps += other.supersteps;
+            total += other.total;
+            max = other.max > max ? other.max : max;
+        }
+
+        double Mean() const
+        {
+            return supersteps > 0 ? total / supersteps : 0.0;
+        }
+
+        /**
+         * Gets the bucket of a skew.
+         *
+         * @param   skew The skew in microseconds.
+         *
+         * @return The bucket.
+         */
+
+        static size_t Bucket( double skew )
+        {
+            size_t bucket = 0;
+
+            for ( double limit = 1.0; skew >= limit && bucket + 1 < BSP_SKEW_BUCKETS; limit *= 2.0 )
+            {
+                ++bucket;
+            }
+
+            return bucket;
+        }
+
+        /**
+         * Gets the exclusive upper limit of a bucket.
+         *
+         * @param   bucket The bucket.
+         *
+         * @return The limit in microseconds.
+         */
+
+        static double Limit( size_t bucket )
+        {
+            return static_cast< double >( 1ull << bucket );
+        }
+    };
+
+    /**
+     * Records per processor a histogram of the arrival skews at its synchronisations. The arrival time of the last
+     * processor is passed through the barrier, so recording costs two clock reads per synchronisation and needs no
+     * extra synchronisation.
+     */
+
+    class ArrivalSkew
+    {
+    public:
+
+        ArrivalSkew()
+            : mEnabled( false )
+        {
+        }
+
+        /**
+         * Starts recording a computation.
+         *
+         * @param   nProcs     The amount of processors.
+         * @param   enabled    Whether to record.
+         * @param   reportPath The path of the report, an empty path writes no report.
+         */
+
+        void Reset( uint32_t nProcs, bool enabled, const std::string &reportPath )
+        {
+            mReportPath = reportPath;
+            mEnabled = enabled || !reportPath.empty();
+            mProcessors.clear();
+
+            if ( !mEnabled )
+            {
+                return;
+            }
+
+            for ( uint32_t pid = 0; pid < nProcs; ++pid )
+            {
+                mProcessors.emplace_back( new SkewHistogram() );
+            }
+        }
+
+        bool IsEnabled() const
+        {
+            return mEnabled;
+        }
+
+        void Add( uint32_t pid, double skew )
+        {
+            mProcessors[pid]->Add( skew );
+        }
+
+        /**
+         * Gets the histograms of every processor of the last computation.
+         *
+         * @return The histograms, empty when nothing was recorded.
+         *
+         * @pre The computation has ended.
+         */
+
+        std::vector< SkewHistogram > GetHistograms() const
+        {
+            std::vector< SkewHistogram > histograms;
+
+            for ( const auto &histogram : mProcessors )
+            {
+                histograms.push_back( *histogram );
+            }
+
+            return histograms;
+        }
+
+        /**
+         * Writes the histogram of every processor and of all processors combined as CSV.
+         *
+         * @pre The computation has ended.
+         */
+
+        void Report() const
+        {
+            if ( mReportPath.empty() )
+            {
+                return;
+            }
+
+            FILE *file = fopen( mReportPath.c_str(), "w" );
+
+            if ( !file )
+            {
+                fprintf( stderr, "Warning: could not write the skew report to `%s`.\n", mReportPath.c_str() );
+                return;
+            }
+
+            fprintf( file, "pid,supersteps,mean_us,max_us" );
+
+            for ( size_t bucket = 0; bucket + 1 < BSP_SKEW_BUCKETS; ++bucket )
+            {
+                fprintf( file, ",lt_%.0fus", SkewHistogram::Limit( bucket ) );
+            }
+
+            fprintf( file, ",ge_%.0fus\n", SkewHistogram::Limit( BSP_SKEW_BUCKETS - 2 ) );
+
+            SkewHistogram all;
+
+            for ( size_t pid = 0; pid < mProcessors.size(); ++pid )
+            {
+                char name[24];
+                snprintf( name, sizeof( name ), "%zu", pid );
+
+                WriteRow( file, name, *mProcessors[pid] );
+                all.Merge( *mProcessors[pid] );
+            }
+
+            WriteRow( file, "all", all );
+            fclose( file );
+        }
+
+    private:
+
+        std::vector< std::unique_ptr< SkewHistogram > > mProcessors;
+        std::string mReportPath;
+        bool mEnabled;
+
+        static void WriteRow( FILE *file, const char *name, const SkewHistogram &histogram )
+        {
+            fprintf( file, "%s,%llu,%.3f,%.3f", name, static_cast< unsigned long long >( histogram.supersteps ),
+                     histogram.Mean(), histogram.max );
+
+            for ( uint64_t count : histogram.counts )
+            {
+                fprintf( file, ",%llu", static_cast< unsigned long long >( count ) );
+            }
+
+            fprintf( file, "\n" );
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_SLOT_H__
+#define __BSPLIB_SLOT_H__
+
+#include "bsp/bspExt.h"
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Binds a variable to a registration slot, for variables that every run registers, such as timings or pivots.
+     * Unlike Push, binding needs no synchronisation, and puts and gets to a slot skip the register lookup. The slot
+     * is a compile-time ID, for example a value of an enumeration.
+     *
+     * @tparam  tSlot The slot, below BSP_REGISTER_SLOTS.
+     * @param [in,out]  var The variable.
+     *
+     * @pre Every processor binds the slot before the synchronisation that processes communication with it.
+     */
+
+    template< size_t tSlot, typename tPrimitive >
+    void BindSlot( tPrimitive &var )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.BindSlot( local, tSlot, &var, sizeof( tPrimitive ) );
+    }
+
+    template< size_t tSlot, typename tPrimitive >
+    void BindSlotPtrs( tPrimitive *begin, size_t count )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.BindSlot( local, tSlot, begin, count * sizeof( tPrimitive ) );
+    }
+
+    /**
+     * Unbinds a registration slot.
+     *
+     * @pre No communication with the slot is pending.
+     */
+
+    template< size_t tSlot >
+    void UnbindSlot()
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.BindSlot( local, tSlot, nullptr, 0 );
+    }
+
+    /**
+     * Puts a value in the variable bound to a slot of another processor.
+     *
+     * @param   pid The destination processor ID.
+     * @param   src The value, copied on the call.
+     */
+
+    template< size_t tSlot, typename tPrimitive >
+    void PutSlot( uint32_t pid, const tPrimitive &src )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.PutId( local, pid, &src, BspInternal::FirstSlotRegister + tSlot, 0, sizeof( tPrimitive ) );
+    }
+
+    /**
+     * Puts elements in the array bound to a slot of another processor.
+     *
+     * @param   pid    The destination processor ID.
+     * @param   src    The elements, copied on the call.
+     * @param   offset The offset in elements in the array.
+     * @param   count  The amount of elements.
+     */
+
+    template< size_t tSlot, typename tPrimitive >
+    void PutSlotPtrs( uint32_t pid, const tPrimitive *src, size_t offset, size_t count )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.PutId( local, pid, src, BspInternal::FirstSlotRegister + tSlot, offset * sizeof( tPrimitive ),
+                   count * sizeof( tPrimitive ) );
+    }
+
+    /**
+     * Gets the variable bound to a slot of another processor.
+     *
+     * @param   pid         The source processor ID.
+     * @param [out]  dst    The destination, written in the next synchronisation.
+     */
+
+    template< size_t tSlot, typename tPrimitive >
+    void GetSlot( uint32_t pid, tPrimitive &dst )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.GetId( local, pid, BspInternal::FirstSlotRegister + tSlot, 0, &dst, sizeof( tPrimitive ) );
+    }
+
+    /**
+     * Gets elements of the array bound to a slot of another processor.
+     *
+     * @param   pid         The source processor ID.
+     * @param   offset      The offset in elements in the array.
+     * @param [out]  dst    The destination, written in the next synchronisation.
+     * @param   count       The amount of elements.
+     */
+
+    template< size_t tSlot, typename tPrimitive >
+    void GetSlotPtrs( uint32_t pid, size_t offset, tPrimitive *dst, size_t count )
+    {
+        static_assert( tSlot < BSP_REGISTER_SLOTS, "the slot exceeds BSP_REGISTER_SLOTS" );
+
+        BSP &bsp = BSP::GetInstance();
+        BSP::Local local = bsp.GetLocal( bsp.ProcId() );
+        bsp.GetId( local, pid, BspInternal::FirstSlotRegister + tSlot, offset * sizeof( tPrimitive ), dst,
+                   count * sizeof( tPrimitive ) );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_SORT_H__
+#define __BSPLIB_SORT_H__
+
+#include "bsp/allToAll.h"
+#include "bsp/gather.h"
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+namespace BspInternal
+{
+    /**
+     * Merges consecutive sorted runs pairwise, so that merging q runs of n elements in total costs O( n log q ).
+     *
+     * @param [in,out]  values  The runs, sorted afterwards.
+     * @param   counts          The amount of elements of every run.
+     * @param   comp            The comparison.
+     */
+
+    template< typename tPrimitive, typename tCompare >
+    void MergeRuns( std::vector< tPrimitive > &values, const std::vector< size_t > &counts, tCompare comp )
+    {
+        std::vector< size_t > bounds( 1, 0 );
+
+        for ( size_t count : counts )
+        {
+            bounds.push_back( bounds.back() + count );
+        }
+
+        for ( size_t width = 1; width + 1 < bounds.size(); width *= 2 )
+        {
+            for ( size_t first = 0; first + width + 1 < bounds.size(); first += 2 * width )
+            {
+                const size_t last = std::min( first + 2 * width, bounds.size() - 1 );
+                std::inplace_merge( values.begin() + bounds[first], values.begin() + bounds[first + width],
+                                    values.begin() + bounds[last], comp );
+            }
+        }
+    }
+}
+
+#ifndef BSP_DISABLE_NAMESPACE
+namespace BSPLib
+{
+#endif
+
+    /**
+     * Sorts the elements distributed over the members of the group by parallel sorting by regular sampling. Every
+     * member sorts its elements and picks regular samples. The samples are gathered on all members, which choose
+     * the same splitters. The elements are then sent to the member of their range in one all-to-all exchange, and
+     * the received runs are merged.
+     *
+     * With n elements in total and distinct keys, no member ends up with more than about 2 n / q elements.
+     *
+     * @param [in,out]  values The elements of this member. Afterwards the elements of the range of this member,
+     *                         so that the concatenation in rank order is sorted.
+     * @param   comp           The strict weak ordering.
+     * @param   group          The group.
+     *
+     * @pre tPrimitive is trivially copyable.
+     */
+
+    template< typename tPrimitive, typename tCompare = std::less< tPrimitive > >
+    void Sort( std::vector< tPrimitive > &values, tCompare comp = tCompare(), const Group &group = Group() )
+    {
+        std::sort( values.begin(), values.end(), comp );
+
+        BspInternal::Collective collective( group );
+        const uint32_t size = collective.Size();
+
+        if ( size == 1 )
+        {
+            return;
+        }
+
+        // regular samples, of which members with fewer elements than members take all
+        std::vector< tPrimitive > samples;
+        const size_t sampleCount = std::min< size_t >( size, values.size() );
+
+        for ( size_t i = 0; i < sampleCount; ++i )
+        {
+            samples.push_back( values[( i * values.size() ) / sampleCount] );
+        }
+
+        std::vector< size_t > sampleCounts = BspInternal::AllGatherCounts( samples.size(), collective );
+        std::vector< tPrimitive > allSamples( BspInternal::RangeCount( sampleCounts, 0, size ) );
+        BspInternal::AllGather( samples.data(), sampleCounts, allSamples.data(), collective,
+                                AllGatherAlgorithm::Automatic );
+
+        if ( allSamples.empty() )
+        {
+            return;
+        }
+
+        std::sort( allSamples.begin(), allSamples.end(), comp );
+
+        // member r gets the elements after splitter r - 1 up to and including splitter r
+        std::vector< const tPrimitive * > sources( size );
+        std::vector< size_t > counts( size );
+        typename std::vector< tPrimitive >::const_iterator begin = values.begin();
+
+        for ( uint32_t r = 0; r < size; ++r )
+        {
+            typename std::vector< tPrimitive >::const_iterator end = values.end();
+
+            if ( r + 1 < size )
+            {
+                const tPrimitive &splitter = allSamples[( ( r + 1 ) * allSamples.size() ) / size];
+                end = std::upper_bound( begin, end, splitter, comp );
+            }
+
+            sources[r] = values.data() + ( begin - values.begin() );
+            counts[r] = static_cast< size_t >( end - begin );
+            begin = end;
+        }
+
+        std::vector< tPrimitive > received;
+        std::vector< size_t > receivedCounts;
+        BspInternal::AllToAllv( sources.data(), counts.data(), received, receivedCounts, collective );
+
+        BspInternal::MergeRuns( received, receivedCounts, comp );
+        values.swap( received );
+    }
+
+#ifndef BSP_DISABLE_NAMESPACE
+}
+#endif
+
+#endif
@@ -29,6 +29,11 @@
 #include <cstddef>
 #include <vector>
 
+/// The size in bytes a stack starts with on its first allocation.
+#ifndef BSP_STACK_MIN_SIZE
+#   define BSP_STACK_MIN_SIZE 64
+#endif
+
 namespace BspInternal
 {
     /**
@@ -43,12 +48,11 @@ namespace BspInternal
         typedef std::ptrdiff_t StackLocation;
 
         /**
-         * Default constructor. Starts with byte size 10.
+         * Default constructor. Starts empty, the stack is allocated on the first allocation.
          */
 
         StackAllocator()
-            : mStack( 10, '@' ),
-              mCursor( 0 )
+            : mCursor( 0 )
         {
         }
 
@@ -103,6 +107,28 @@ namespace BspInternal
             return loc;
         }
 
+        /**
+         * Allocates the given amount of bytes on the stack, for the caller to write.
+         *
+         * @param   size            The size of the content in bytes.
+         * @param [out]  location   The StackLocation that refers to the object.
+         *
+         * @return The first byte of the object, which stays valid until the next allocation.
+         */
+
+        BSP_FORCEINLINE char *Reserve( size_t size, StackLocation &location )
+        {
+            if ( !FitsInStack( size ) )
+            {
+                Grow( size );
+            }
+
+            location = mCursor;
+            mCursor += size;
+
+            return mStack.data() + location;
+        }
+
         /**
          * Extracts this object on the given stack location.
          *
@@ -116,6 +142,19 @@ namespace BspInternal
             memcpy( dst, mStack.data() + location, size );
         }
 
+        /**
+         * Gets the object on the given stack location, which stays valid until the stack grows or is cleared.
+         *
+         * @param   location The location of the object.
+         *
+         * @return The first byte of the object.
+         */
+
+        inline const char *Data( StackLocation location ) const
+        {
+            return mStack.data() + location;
+        }
+
         /**
          * Clears this object to its blank/initial state.
          */
@@ -163,7 +202,8 @@ namespace BspInternal
 
         BSP_FORCEINLINE void Grow( size_t size )
         {
-            mStack.resize( static_cast<size_t>( mStack.size() * 1.6f ) + size, '~' );
+            const size_t grown = static_cast<size_t>( mStack.size() * 1.6f ) + size;
+            mStack.resize( grown < BSP_STACK_MIN_SIZE ? BSP_STACK_MIN_SIZE : grown, '~' );
         }
     };
 }
@@ -0,0 +1,288 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#ifndef __BSPLIB_TOPOLOGY_H__
+#define __BSPLIB_TOPOLOGY_H__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#   include <sched.h>
+#endif
+
+namespace BspInternal
+{
+    /**
+     * Describes a single logical processor of the machine.
+     */
+
+    struct CpuInfo
+    {
+        uint32_t id;
+        uint32_t package;
+        uint32_t core;
+    };
+
+    /**
+     * The processor topology of the machine, restricted to the logical processors this process is allowed to run on.
+     * On Linux the topology is read from sysfs, on other platforms all logical processors are assumed to share a
+     * single package.
+     */
+
+    class Topology
+    {
+    public:
+
+        Topology()
+        {
+            Discover();
+        }
+
+        /**
+         * Gets the logical processors available to this process, ordered by identifier.
+         *
+         * @return The processors.
+         */
+
+        const std::vector< CpuInfo > &GetCpus() const
+        {
+            return mCpus;
+        }
+
+        /**
+         * Gets the number of packages (sockets) that hold at least one available processor.
+         *
+         * @return The package count.
+         */
+
+        uint32_t GetPackageCount() const
+        {
+            return mPackageCount;
+        }
+
+        /**
+         * Gets the processor identifiers ordered such that neighbouring entries share a core, and then a package.
+         *
+         * @return The compact processor order.
+         */
+
+        std::vector< uint32_t > GetCompactOrder() const
+        {
+            std::vector< CpuInfo > cpus( mCpus );
+
+            std::stable_sort( cpus.begin(), cpus.end(), []( const CpuInfo & a, const CpuInfo & b )
+            {
+                return a.package != b.package ? a.package < b.package : a.core < b.core;
+            } );
+
+            return Identifiers( cpus );
+        }
+
+        /**
+         * Gets the processor identifiers ordered such that neighbouring entries are on different packages, and
+         * hardware threads that share a core come last.
+         *
+         * @return The scattered processor order.
+         */
+
+        std::vector< uint32_t > GetScatterOrder() const
+        {
+            std::vector< CpuInfo > cpus( mCpus );
+            std::vector< uint32_t > rank( cpus.size() );
+            std::vector< uint32_t > coreRank( cpus.size() );
+
+            // rank each processor within its core (hardware thread index) and each core within its package
+            for ( size_t i = 0; i < cpus.size(); ++i )
+            {
+                for ( size_t j = 0; j < i; ++j )
+                {
+                    if ( cpus[j].package == cpus[i].package )
+                    {
+                        if ( cpus[j].core == cpus[i].core )
+                        {
+                            ++rank[i];
+                        }
+                        else if ( rank[j] == 0 )
+                        {
+                            ++coreRank[i];
+                        }
+                    }
+                }
+            }
+
+            std::vector< size_t > order( cpus.size() );
+
+            for ( size_t i = 0; i < order.size(); ++i )
+            {
+                order[i] = i;
+            }
+
+            std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b )
+            {
+                if ( rank[a] != rank[b] )
+                {
+                    return rank[a] < rank[b];
+                }
+
+                if ( coreRank[a] != coreRank[b] )
+                {
+                    return coreRank[a] < coreRank[b];
+                }
+
+                return cpus[a].package < cpus[b].package;
+            } );
+
+            std::vector< uint32_t > result;
+            result.reserve( order.size() );
+
+            for ( size_t i : order )
+            {
+                result.push_back( cpus[i].id );
+            }
+
+            return result;
+        }
+
+        /**
+         * Gets the package the given logical processor belongs to.
+         *
+         * @param   cpu The processor identifier.
+         *
+         * @return The package, or 0 when the processor is unknown.
+         */
+
+        uint32_t GetPackage( uint32_t cpu ) const
+        {
+            for ( const CpuInfo &info : mCpus )
+            {
+                if ( info.id == cpu )
+                {
+                    return info.package;
+                }
+            }
+
+            return 0;
+        }
+
+        /**
+         * Gets the static instance of the machine topology.
+         *
+         * @return The instance.
+         */
+
+        static const Topology &GetInstance()
+        {
+            static Topology mTopology;
+            return mTopology;
+        }
+
+    private:
+
+        std::vector< CpuInfo > mCpus;
+        uint32_t mPackageCount;
+
+        void Discover()
+        {
+            mCpus.clear();
+
+#ifdef __linux__
+            cpu_set_t allowed;
+            CPU_ZERO( &allowed );
+
+            if ( sched_getaffinity( 0, sizeof( cpu_set_t ), &allowed ) == 0 )
+            {
+                for ( uint32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+                {
+                    if ( CPU_ISSET( cpu, &allowed ) )
+                    {
+                        mCpus.push_back( CpuInfo{ cpu, ReadTopologyValue( cpu, "physical_package_id", 0 ),
+                                                  ReadTopologyValue( cpu, "core_id", cpu ) } );
+                    }
+                }
+            }
+
+#endif
+
+            if ( mCpus.empty() )
+            {
+                const uint32_t count = std::max( std::thread::hardware_concurrency(), 1u );
+
+                for ( uint32_t cpu = 0; cpu < count; ++cpu )
+                {
+                    mCpus.push_back( CpuInfo{ cpu, 0, cpu } );
+                }
+            }
+
+            std::vector< uint32_t > packages;
+
+            for ( const CpuInfo &info : mCpus )
+            {
+                if ( std::find( packages.begin(), packages.end(), info.package ) == packages.end() )
+                {
+                    packages.push_back( info.package );
+                }
+            }
+
+            mPackageCount = static_cast< uint32_t >( packages.size() );
+        }
+
+        static uint32_t ReadTopologyValue( uint32_t cpu, const char *name, uint32_t fallback )
+        {
+            char path[128];
+            snprintf( path, sizeof( path ), "/sys/devices/system/cpu/cpu%u/topology/%s", cpu, name );
+
+            FILE *file = fopen( path, "r" );
+            int32_t value = -1;
+
+            if ( file )
+            {
+                if ( fscanf( file, "%d", &value ) != 1 )
+                {
+                    value = -1;
+                }
+
+                fclose( file );
+            }
+
+            return value < 0 ? fallback : static_cast< uint32_t >( value );
+        }
+
+        static std::vector< uint32_t > Identifiers( const std::vector< CpuInfo > &cpus )
+        {
+            std::vector< uint32_t > result;
+            result.reserve( cpus.size() );
+
+            for ( const CpuInfo &info : cpus )
+            {
+                result.push_back( info.id );
+            }
+
+            return result;
+        }
+    };
+}
+
+#endif
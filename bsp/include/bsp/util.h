@@ -36,6 +36,17 @@
 #endif
 
 
+#if !defined(BSP_RESTRICT)
+#  if defined(_MSC_VER)
+#    define BSP_RESTRICT __restrict
+#  elif defined(__GNUC__) && __GNUC__ > 3
+// Clang also defines __GNUC__ (as 4)
+#    define BSP_RESTRICT __restrict__
+#  else
+#    define BSP_RESTRICT
+#  endif
+#endif
+
 #if !defined(BSP_TLS)
 #  if defined(_MSC_VER)
 #    define BSP_TLS __declspec(thread)
@@ -1,7 +1,14 @@
 #include "bspedupack.h"
 
+#include <string.h>
+
 /*  This program measures p, r, g, and l of a BSP computer
     using bsp_put for communication.
+
+    Afterwards it sweeps every communication primitive separately over
+    message sizes from MINBYTES to MAXBYTES and over thread counts
+    1, 2, 4, ..., P, fits g and l per primitive, and writes the results
+    as JSON to bspbench.json, or to the path in BSP_BENCH_JSON.
 */
 
 #define NITERS 10000     /* number of iterations */
@@ -9,7 +16,37 @@
 #define MAXH 256       /* maximum h in h-relation */
 #define MEGA 1000000.0
 
+#ifndef MINBYTES
+#define MINBYTES 8                 /* smallest message of the sweep */
+#endif
+#ifndef MAXBYTES
+#define MAXBYTES ( 64 << 20 )      /* largest message of the sweep */
+#endif
+#define MAXSIZES 64                /* maximum number of message sizes */
+#define SWEEPITERS 1000            /* maximum number of iterations per size */
+#define SWEEPTRAFFIC ( 256 << 20 ) /* bytes a processor sends per size */
+#ifndef SWEEPMEMORY
+#define SWEEPMEMORY ( ( size_t )1 << 30 ) /* bytes all processors may use */
+#endif
+#define SWEEPCOPIES 4              /* source, destination and two staging copies */
+
+enum Primitive
+{
+    PUT, GET, SEND, HPPUT, HPGET, HPSEND, BROADCAST, ALLREDUCE, NPRIMITIVES
+};
+
+const char *primitivenames[NPRIMITIVES] =
+{
+    "put", "get", "send", "hpput", "hpget", "hpsend", "broadcast", "allreduce"
+};
+
 uint32_t P; /* number of processors requested */
+double R;   /* computing rate in flop/s measured by bspbench */
+
+int nsizes;                             /* number of message sizes */
+int nrunsizes;                          /* number of sizes that fit in memory */
+size_t sizes[MAXSIZES];                 /* message sizes in bytes */
+double sweep[NPRIMITIVES][MAXSIZES];    /* time in sec of one superstep */
 
 void leastsquares( int h0, int h1, double *t, double *g, double *l )
 {
@@ -211,6 +248,22 @@ void bspbench()
         printf( "p= %d, r= %.3lf Mflop/s, g= %.1lf, l= %.1lf\n",
                 p, r / MEGA, g, l );
         fflush( stdout );
+        R = r;
+
+        /* Save the parameters for the cost model of the library */
+        BspInternal::MachineParams params;
+        params.p = p;
+        params.r = r;
+        params.g = g;
+        params.l = l;
+        params.word = SZDBL;
+
+        const char *paramsPath = getenv( "BSP_PARAMS" );
+
+        if ( params.Save( paramsPath ? paramsPath : "bsp.params" ) )
+        {
+            printf( "The parameters are written to %s\n", paramsPath ? paramsPath : "bsp.params" );
+        }
     }
 
     bsp_pop_reg( dest );
@@ -221,6 +274,272 @@ void bspbench()
     bsp_end();
 } /* end bspbench */
 
+void weightedleastsquares( int n, size_t *h, double *t, double *g, double *l )
+{
+    /* This function computes the parameters g and l of the
+       linear function T(h)= g*h+l that best fits the data
+       points (h[i],t[i]) with 0 <= i < n. The squared errors
+       are weighted by 1/t[i]^2, so that the relative errors
+       count, and the small messages that determine l are not
+       drowned out by the large messages that determine g. */
+
+    double w, sumw, sumh, sumhh, sumt, sumth, det;
+    int i;
+
+    sumw = sumh = sumhh = sumt = sumth = 0.0;
+
+    for ( i = 0; i < n; i++ )
+    {
+        if ( t[i] <= 0.0 )
+        {
+            continue;
+        }
+
+        w = 1.0 / ( t[i] * t[i] );
+        sumw  += w;
+        sumh  += w * h[i];
+        sumhh += w * h[i] * h[i];
+        sumt  += w * t[i];
+        sumth += w * t[i] * h[i];
+    }
+
+    /* Solve      sumw*l +  sumh*g =  sumt
+                  sumh*l + sumhh*g = sumth */
+    det = sumw * sumhh - sumh * sumh;
+
+    if ( det == 0.0 )
+    {
+        *g = 0.0;
+        *l = sumw > 0.0 ? sumt / sumw : 0.0;
+        return;
+    }
+
+    *g = ( sumw * sumth - sumh * sumt ) / det;
+    *l = ( sumt * sumhh - sumh * sumth ) / det;
+
+} /* end weightedleastsquares */
+
+void communicate( int primitive, int p, int s, size_t nbytes, char *src, char *dest )
+{
+    /* This function performs one superstep in which every processor
+       communicates one message of nbytes bytes with its right
+       neighbour, using the given primitive. */
+
+    size_t tag = 0;
+    void *tagptr = &tag, *payloadptr = dest;
+    int dst = ( s + 1 ) % p;
+
+    switch ( primitive )
+    {
+    case PUT:
+        bsp_put( dst, src, dest, 0, nbytes );
+        bsp_sync();
+        break;
+
+    case GET:
+        bsp_get( dst, src, 0, dest, nbytes );
+        bsp_sync();
+        break;
+
+    case SEND:
+        bsp_send( dst, &tag, src, nbytes );
+        bsp_sync();
+        bsp_move( dest, nbytes );
+        break;
+
+    case HPPUT:
+        bsp_hpput( dst, src, dest, 0, nbytes );
+        bsp_sync();
+        break;
+
+    case HPGET:
+        bsp_hpget( dst, src, 0, dest, nbytes );
+        bsp_sync();
+        break;
+
+    case HPSEND:
+        bsp_hpsend( dst, &tag, src, nbytes );
+        bsp_sync();
+        bsp_hpmove( &tagptr, &payloadptr );
+        break;
+
+    case BROADCAST:
+        /* the collectives synchronise themselves */
+        BSPLib::BroadcastPtrs( src, nbytes, 0 );
+        break;
+
+    case ALLREDUCE:
+        BSPLib::AllReducePtrs( ( double * )src, nbytes / SZDBL, BSPLib::Sum() );
+        break;
+    }
+
+} /* end communicate */
+
+void bspsweep()
+{
+    int p, s, s1, iter, niters, k, primitive;
+    size_t tagsize = sizeof( size_t );
+    char *src, *dest;
+    double time0, time, *Time, maxtime;
+
+    p = bsp_nprocs();
+    s = bsp_pid();
+
+    Time = vecallocd( p );
+    bsp_push_reg( Time, p * SZDBL );
+    bsp_set_tagsize( &tagsize );
+    bsp_sync();
+
+    for ( k = 0; k < nrunsizes; k++ )
+    {
+        /* Allocate per size, the sources are zero so that the sums of allreduce stay finite */
+        src = ( char * )calloc( sizes[k], 1 );
+        dest = ( char * )calloc( sizes[k], 1 );
+
+        if ( src == NULL || dest == NULL )
+        {
+            bsp_abort( "bspsweep: not enough memory" );
+        }
+
+        bsp_push_reg( src, sizes[k] );
+        bsp_push_reg( dest, sizes[k] );
+        bsp_sync();
+
+        /* Measure the time of niters supersteps, fewer for large messages */
+        niters = ( int )MAX( 1, MIN( SWEEPITERS, SWEEPTRAFFIC / sizes[k] ) );
+
+        for ( primitive = 0; primitive < NPRIMITIVES; primitive++ )
+        {
+            bsp_sync();
+            time0 = bsp_time();
+
+            for ( iter = 0; iter < niters; iter++ )
+            {
+                communicate( primitive, p, s, sizes[k], src, dest );
+            }
+
+            time = ( bsp_time() - time0 ) / niters;
+            bsp_put( 0, &time, Time, s * SZDBL, SZDBL );
+            bsp_sync();
+
+            /* Processor 0 records the time of the slowest processor */
+            if ( s == 0 )
+            {
+                maxtime = Time[0];
+
+                for ( s1 = 1; s1 < p; s1++ )
+                {
+                    maxtime = MAX( maxtime, Time[s1] );
+                }
+
+                sweep[primitive][k] = maxtime;
+            }
+        }
+
+        bsp_pop_reg( dest );
+        bsp_pop_reg( src );
+        bsp_sync();
+
+        free( dest );
+        free( src );
+    }
+
+    bsp_pop_reg( Time );
+    bsp_sync();
+
+    vecfreed( Time );
+} /* end bspsweep */
+
+void writesweep( FILE *fp, int p, int last )
+{
+    /* This function writes the sweep of p processors as a JSON object */
+
+    double g, l;
+    int primitive, k;
+
+    fprintf( fp, "    {\n      \"p\": %d,\n      \"primitives\": {\n", p );
+
+    for ( primitive = 0; primitive < NPRIMITIVES; primitive++ )
+    {
+        weightedleastsquares( nrunsizes, sizes, sweep[primitive], &g, &l );
+
+        fprintf( fp, "        \"%s\": {\n", primitivenames[primitive] );
+        fprintf( fp, "          \"g\": %.6e,\n          \"l\": %.6e,\n", g, l );
+        fprintf( fp, "          \"g_flops\": %.6e,\n          \"l_flops\": %.6e,\n", g * SZDBL * R, l * R );
+        fprintf( fp, "          \"samples\": [" );
+
+        for ( k = 0; k < nrunsizes; k++ )
+        {
+            fprintf( fp, "%s\n            { \"bytes\": %lu, \"seconds\": %.6e }", k > 0 ? "," : "",
+                     ( unsigned long )sizes[k], sweep[primitive][k] );
+        }
+
+        fprintf( fp, "\n          ]\n        }%s\n", primitive + 1 < NPRIMITIVES ? "," : "" );
+
+        printf( "p= %2d %-9s g= %.3e sec/byte, l= %.3e sec\n", p, primitivenames[primitive], g, l );
+    }
+
+    fprintf( fp, "      }\n    }%s\n", last ? "" : "," );
+    fflush( stdout );
+} /* end writesweep */
+
+void bspsweeps()
+{
+    /* This function runs the sweep for 1, 2, 4, ..., P processors */
+
+    const char *jsonpath = getenv( "BSP_BENCH_JSON" );
+    FILE *fp;
+    size_t nbytes;
+    uint32_t p;
+
+    if ( jsonpath == NULL )
+    {
+        jsonpath = "bspbench.json";
+    }
+
+    nsizes = 0;
+
+    for ( nbytes = MINBYTES; nbytes <= ( size_t )MAXBYTES && nsizes < MAXSIZES; nbytes *= 2 )
+    {
+        sizes[nsizes++] = nbytes;
+    }
+
+    fp = fopen( jsonpath, "w" );
+
+    if ( fp == NULL )
+    {
+        printf( "Sorry, cannot write %s.\n", jsonpath );
+        return;
+    }
+
+    fprintf( fp, "{\n  \"r\": %.6e,\n  \"word\": %d,\n  \"runs\": [\n", R, ( int )SZDBL );
+
+    for ( p = 1; p <= P; p = ( p < P && 2 * p > P ) ? P : 2 * p )
+    {
+        /* Every processor holds up to SWEEPCOPIES copies of a message, which must fit in SWEEPMEMORY */
+        nrunsizes = 1;
+
+        while ( nrunsizes < nsizes && SWEEPCOPIES * p * sizes[nrunsizes] <= ( size_t )SWEEPMEMORY )
+        {
+            nrunsizes++;
+        }
+
+        if ( nrunsizes < nsizes )
+        {
+            printf( "p= %2d sweeps up to %lu bytes to fit in memory\n", p, ( unsigned long )sizes[nrunsizes - 1] );
+        }
+
+        BSPLib::Execute( bspsweep, p );
+        writesweep( fp, p, p == P );
+    }
+
+    fprintf( fp, "  ]\n}\n" );
+    fclose( fp );
+
+    printf( "The sweep is written to %s\n", jsonpath );
+    fflush( stdout );
+} /* end bspsweeps */
+
 int main( int argc, char **argv )
 {
 
@@ -243,6 +562,7 @@ int main( int argc, char **argv )
     }
 
     bspbench();
+    bspsweeps();
     system( "pause" );
     exit( 0 );
 
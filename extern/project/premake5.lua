@@ -270,4 +270,75 @@ solution "bsp-edupack"
             root .. "edupack/bspedupack.cpp",
             root .. "edupack/bsplu.cpp",
             root .. "edupack/bsplu_test.cpp",
-            }
\ No newline at end of file
+            }
+            
+solution "bsp-tools"
+
+    location( root .. "tools/" )
+    objdir( root .. "bin/obj/" )
+	debugdir( root .. "bin/" )
+    
+    configurations { "Debug", "Release" }
+
+    platforms { "x64", "x32" }
+
+    vectorextensions "SSE2"
+
+    warnings "Extra"
+
+    flags "Unicode" 
+
+    configuration "x32"
+        targetdir( root .. "bin/x32/" )
+        architecture "x32"
+
+    configuration "x64"
+        targetdir( root .. "bin/x64/" )
+        architecture "x64"
+        
+    configuration "Debug"
+        targetsuffix "d"
+        defines "DEBUG"
+        flags "Symbols"
+        optimize "Off"
+
+    configuration "Release"     
+        flags "LinkTimeOptimization"
+        optimize "Speed"
+			
+    configuration "gmake"
+        linkoptions {
+            "-Wl,--no-as-needed",
+            "-pthread"
+            }
+            
+        buildoptions {
+            "-std=c++11",
+            "-pthread"
+            } 
+                             
+    configuration {}
+            
+    project "replay"                
+        kind "ConsoleApp"
+        flags "WinMain"
+
+        includedirs {
+            root .. "bsp/include/"
+            }   
+            
+        files { 
+            root .. "tools/replay.cpp"
+            }
+            
+    project "sortbench"                
+        kind "ConsoleApp"
+        flags "WinMain"
+
+        includedirs {
+            root .. "bsp/include/"
+            }   
+            
+        files { 
+            root .. "tools/sortbench.cpp"
+            }
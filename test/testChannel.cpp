@@ -0,0 +1,264 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct Edge
+{
+    uint32_t from;
+    uint32_t to;
+};
+
+struct Record
+{
+    std::string name;
+    std::vector< double > values;
+};
+
+namespace BSPLib
+{
+    template<>
+    struct Serializer< Record >
+    {
+        static size_t Size( const Record &record )
+        {
+            return Serializer< std::string >::Size( record.name ) + Serializer< std::vector< double > >::Size( record.values );
+        }
+
+        static char *Write( const Record &record, char *out )
+        {
+            out = Serializer< std::string >::Write( record.name, out );
+            return Serializer< std::vector< double > >::Write( record.values, out );
+        }
+
+        static const char *Read( const char *in, const char *end, Record &record )
+        {
+            in = Serializer< std::string >::Read( in, end, record.name );
+            return in == nullptr ? nullptr : Serializer< std::vector< double > >::Read( in, end, record.values );
+        }
+    };
+}
+
+template< typename tValue >
+void CheckRoundTrip( const tValue &value )
+{
+    std::vector< char > buffer( BSPLib::Serializer< tValue >::Size( value ) );
+    char *end = BSPLib::Serializer< tValue >::Write( value, buffer.data() );
+    EXPECT_EQ( buffer.data() + buffer.size(), end );
+
+    tValue result;
+    const char *read = BSPLib::Serializer< tValue >::Read( buffer.data(), buffer.data() + buffer.size(), result );
+    EXPECT_EQ( buffer.data() + buffer.size(), read );
+    EXPECT_EQ( value, result );
+}
+
+TEST( P( Channel ), Serializer )
+{
+    CheckRoundTrip( 42 );
+    CheckRoundTrip( std::string() );
+    CheckRoundTrip( std::string( "channel" ) );
+    CheckRoundTrip( std::vector< int >{ 1, 2, 3 } );
+    CheckRoundTrip( std::vector< std::vector< int > > { {}, { 1 }, { 2, 3, 4 } } );
+    CheckRoundTrip( std::vector< std::string > { "a", "", "bc" } );
+    CheckRoundTrip( std::make_pair( std::string( "key" ), std::vector< uint64_t > { 7, 8 } ) );
+}
+
+TEST( P( Channel ), SerializerMalformed )
+{
+    typedef BSPLib::Serializer< std::vector< uint32_t > > VectorSerializer;
+    typedef BSPLib::Serializer< std::vector< std::string > > StringsSerializer;
+
+    const std::vector< uint32_t > sent = { 1, 2 };
+    std::vector< char > buffer( VectorSerializer::Size( sent ) );
+    VectorSerializer::Write( sent, buffer.data() );
+    const char *end = buffer.data() + buffer.size();
+
+    // a truncated message and a garbage length are rejected before the sequence grows
+    std::vector< uint32_t > values;
+    EXPECT_EQ( nullptr, VectorSerializer::Read( buffer.data(), buffer.data() + 4, values ) );
+    EXPECT_EQ( nullptr, VectorSerializer::Read( buffer.data(), end - 1, values ) );
+
+    const uint64_t garbage = ~0ull;
+    memcpy( buffer.data(), &garbage, sizeof( uint64_t ) );
+
+    std::vector< std::string > strings;
+    EXPECT_EQ( nullptr, VectorSerializer::Read( buffer.data(), end, values ) );
+    EXPECT_EQ( nullptr, StringsSerializer::Read( buffer.data(), end, strings ) );
+    EXPECT_TRUE( values.empty() );
+    EXPECT_TRUE( strings.empty() );
+}
+
+void ChannelMismatchTest()
+{
+    BSPLib::SetTagsize< uint32_t >();
+    BSPLib::Sync();
+
+    BSPLib::Channel< uint32_t, uint32_t > sender;
+    sender.Send( 0, 0, 42u );
+
+    BSPLib::Sync();
+
+    // a four byte message does not hold a string
+    BSPLib::Channel< uint32_t, std::string > receiver;
+    std::string value;
+    receiver.Receive( value );
+
+    BSPLib::Sync();
+}
+
+TEST( P( Channel ), ReceiveMismatch )
+{
+    EXPECT_FALSE( BSPLib::Execute( ChannelMismatchTest, 2 ) );
+}
+
+void ChannelNestedTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    BSPLib::SetTagsize< uint32_t >();
+    BSPLib::Sync();
+
+    BSPLib::Channel< uint32_t, std::vector< std::vector< uint32_t > > > channel;
+
+    // processor s sends t rows of length s + row to processor t
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        std::vector< std::vector< uint32_t > > rows( t );
+
+        for ( uint32_t row = 0; row < t; ++row )
+        {
+            rows[row].assign( s + row, s * 100 + row );
+        }
+
+        channel.Send( t, s, rows );
+    }
+
+    BSPLib::Sync();
+
+    std::vector< bool > seen( p, false );
+    uint32_t sender;
+    std::vector< std::vector< uint32_t > > rows;
+
+    while ( channel.Receive( sender, rows ) )
+    {
+        ASSERT_LT( sender, p );
+        EXPECT_FALSE( seen[sender] );
+        seen[sender] = true;
+
+        ASSERT_EQ( s, rows.size() );
+
+        for ( uint32_t row = 0; row < s; ++row )
+        {
+            EXPECT_EQ( std::vector< uint32_t >( sender + row, sender * 100 + row ), rows[row] );
+        }
+    }
+
+    EXPECT_EQ( std::vector< bool >( p, true ), seen );
+}
+
+BspTest( Channel, 1, ChannelNestedTest );
+BspTest( Channel, 4, ChannelNestedTest );
+BspTest( Channel, 7, ChannelNestedTest );
+
+void ChannelRecordTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    BSPLib::SetTagsize< uint32_t >();
+    BSPLib::Sync();
+
+    BSPLib::Channel< uint32_t, Record > channel;
+    const uint32_t next = ( s + 1 ) % p;
+
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        Record record;
+        record.name = std::string( i + 1, static_cast< char >( 'a' + s % 26 ) );
+        record.values.assign( i, s + 0.5 );
+        channel.Send( next, i, record );
+    }
+
+    BSPLib::Sync();
+
+    const uint32_t prev = ( s + p - 1 ) % p;
+    uint32_t index;
+    Record record;
+    uint32_t count = 0;
+
+    // messages of the same sender arrive in order
+    while ( channel.Receive( index, record ) )
+    {
+        EXPECT_EQ( count, index );
+        EXPECT_EQ( std::string( index + 1, static_cast< char >( 'a' + prev % 26 ) ), record.name );
+        EXPECT_EQ( std::vector< double >( index, prev + 0.5 ), record.values );
+        ++count;
+    }
+
+    EXPECT_EQ( 3u, count );
+    EXPECT_FALSE( channel.Receive( record ) );
+}
+
+BspTest( Channel, 1, ChannelRecordTest );
+BspTest( Channel, 5, ChannelRecordTest );
+
+void ChannelTrivialTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    BSPLib::Channel< char, Edge > channel;
+
+    BSPLib::SetTagsize< char >();
+    BSPLib::Sync();
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        channel.Send( t, 'e', Edge{ s, t } );
+    }
+
+    BSPLib::Sync();
+
+    uint64_t sum = 0;
+    uint32_t count = 0;
+    char tag;
+    Edge edge;
+
+    while ( channel.Receive( tag, edge ) )
+    {
+        EXPECT_EQ( 'e', tag );
+        EXPECT_EQ( s, edge.to );
+        sum += edge.from;
+        ++count;
+    }
+
+    EXPECT_EQ( p, count );
+    EXPECT_EQ( p * ( p - 1 ) / 2, sum );
+}
+
+BspTest( Channel, 1, ChannelTrivialTest );
+BspTest( Channel, 8, ChannelTrivialTest );
@@ -134,6 +134,35 @@ inline void EmptyTest()
 {
 }
 
+static std::chrono::high_resolution_clock::time_point gAbortTime;
+
+inline void AbortLatencyTest()
+{
+    BSPLib::Sync();
+
+    if ( BSPLib::ProcId() == 1 )
+    {
+        // lets the other processors fall asleep in the barrier
+        std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+        gAbortTime = std::chrono::high_resolution_clock::now();
+        BSPLib::Classic::Abort( "" );
+    }
+
+    BSPLib::Sync();
+}
+
+TEST( P( Classic ), AbortLatency )
+{
+    EXPECT_FALSE( BSPLib::Execute( AbortLatencyTest, 8 ) );
+
+    // the main processor sleeps in the barrier, and is woken by the abort rather than by polling
+    const std::chrono::duration< double, std::milli > latency = std::chrono::high_resolution_clock::now() - gAbortTime;
+    EXPECT_GT( 100.0, latency.count() );
+
+    // the next program only starts after all processors of the aborted one have stopped
+    EXPECT_TRUE( BSPLib::Execute( EmptyTest, 8 ) );
+}
+
 template< uint32_t tProcs >
 void NProcsTest()
 {
@@ -0,0 +1,749 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+template< uint32_t tRoot >
+void BroadcastValueTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+
+    uint64_t value = s == tRoot ? 0xC0FFEEull : s;
+    BSPLib::Broadcast( value, tRoot );
+
+    EXPECT_EQ( 0xC0FFEEull, value );
+}
+
+BspTest1( Collective, 1, BroadcastValueTest, 0 );
+BspTest1( Collective, 5, BroadcastValueTest, 0 );
+BspTest1( Collective, 5, BroadcastValueTest, 3 );
+BspTest1( Collective, 16, BroadcastValueTest, 7 );
+
+template< uint32_t tAlgorithm, uint32_t tCount >
+void BroadcastPtrsTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t root = BSPLib::NProcs() / 2;
+
+    std::vector< uint32_t > values( tCount, s );
+
+    if ( s == root )
+    {
+        for ( uint32_t i = 0; i < tCount; ++i )
+        {
+            values[i] = i * 3 + 1;
+        }
+    }
+
+    BSPLib::BroadcastPtrs( values.data(), values.size(), root, BSPLib::Group(),
+                           static_cast< BSPLib::BroadcastAlgorithm >( tAlgorithm ) );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        EXPECT_EQ( i * 3 + 1, values[i] );
+    }
+}
+
+BspTest2( Collective, 7, BroadcastPtrsTest, 0, 1 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 0, 100000 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 1, 1 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 1, 1000 );
+BspTest2( Collective, 16, BroadcastPtrsTest, 1, 1000 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 2, 1 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 2, 3 );
+BspTest2( Collective, 7, BroadcastPtrsTest, 2, 1000 );
+BspTest2( Collective, 16, BroadcastPtrsTest, 2, 1000 );
+BspTest2( Collective, 5, BroadcastPtrsTest, 3, 1 );
+BspTest2( Collective, 16, BroadcastPtrsTest, 3, 1000 );
+BspTest2( Collective, 13, BroadcastPtrsTest, 3, 17 );
+
+void BroadcastContainerTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+
+    std::vector< double > values;
+    std::string string;
+
+    if ( s == 1 )
+    {
+        values = { 1.5, 2.5, 3.5 };
+        string = "broadcast";
+    }
+
+    BSPLib::Broadcast( values, 1 );
+    BSPLib::Broadcast( string, 1 );
+
+    EXPECT_EQ( std::vector< double >( { 1.5, 2.5, 3.5 } ), values );
+    EXPECT_EQ( "broadcast", string );
+
+    std::vector< int32_t > empty( s, 1 );
+    BSPLib::Broadcast( empty, 0 );
+    EXPECT_TRUE( empty.empty() );
+}
+
+BspTest( Collective, 4, BroadcastContainerTest );
+
+void BroadcastGroupTest()
+{
+    // a cyclic distribution over 3 x 4 processors, with s = i + j * 3
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t i = s % 3;
+    const uint32_t j = s / 3;
+
+    const BSPLib::Group column( j * 3, 1, 3 );
+    const BSPLib::Group row( i, 3, 4 );
+
+    uint32_t value = s;
+    BSPLib::Broadcast( value, column.Pid( 2 ), column );
+    EXPECT_EQ( 2 + j * 3, value );
+
+    std::vector< uint32_t > values( 64, s );
+    BSPLib::BroadcastPtrs( values.data(), values.size(), row.Pid( 1 ), row );
+    EXPECT_EQ( std::vector< uint32_t >( 64, i + 3 ), values );
+
+    EXPECT_TRUE( row.Contains( s ) );
+    EXPECT_TRUE( column.Contains( s ) );
+    EXPECT_EQ( j, row.Rank( s ) );
+    EXPECT_EQ( i, column.Rank( s ) );
+}
+
+BspTest( Collective, 12, BroadcastGroupTest );
+
+template< uint32_t tAlgorithm, uint32_t tCount >
+void AllReduceTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+    const BSPLib::ReduceAlgorithm algorithm = static_cast< BSPLib::ReduceAlgorithm >( tAlgorithm );
+
+    std::vector< uint64_t > sums( tCount );
+    std::vector< double > maxima( tCount );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        sums[i] = s * i + 1;
+        maxima[i] = static_cast< double >( ( s + i ) % p );
+    }
+
+    BSPLib::AllReducePtrs( sums.data(), sums.size(), BSPLib::Sum(), BSPLib::Group(), algorithm );
+    BSPLib::AllReducePtrs( maxima.data(), maxima.size(), BSPLib::Max(), BSPLib::Group(), algorithm );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        EXPECT_EQ( static_cast< uint64_t >( p ) * ( p - 1 ) / 2 * i + p, sums[i] );
+        EXPECT_EQ( p - 1.0, maxima[i] );
+    }
+}
+
+BspTest2( Collective, 1, AllReduceTest, 0, 3 );
+BspTest2( Collective, 7, AllReduceTest, 0, 1 );
+BspTest2( Collective, 7, AllReduceTest, 0, 100000 );
+BspTest2( Collective, 7, AllReduceTest, 1, 1 );
+BspTest2( Collective, 7, AllReduceTest, 1, 1000 );
+BspTest2( Collective, 16, AllReduceTest, 1, 1000 );
+BspTest2( Collective, 7, AllReduceTest, 2, 3 );
+BspTest2( Collective, 7, AllReduceTest, 2, 20 );
+BspTest2( Collective, 16, AllReduceTest, 2, 1000 );
+BspTest2( Collective, 5, AllReduceTest, 3, 1 );
+BspTest2( Collective, 13, AllReduceTest, 3, 17 );
+BspTest2( Collective, 16, AllReduceTest, 3, 1000 );
+
+// x -> a x + b, of which the composition is associative but not commutative
+struct Affine
+{
+    int64_t a;
+    int64_t b;
+};
+
+struct Compose
+{
+    Affine operator()( const Affine &f, const Affine &g ) const
+    {
+        return Affine{ g.a * f.a, g.a * f.b + g.b };
+    }
+};
+
+template< uint32_t tAlgorithm, uint32_t tRoot >
+void ReduceOrderTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+    const BSPLib::ReduceAlgorithm algorithm = static_cast< BSPLib::ReduceAlgorithm >( tAlgorithm );
+
+    Affine expected{ 1, 0 };
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        expected = Compose()( expected, Affine{ 2, t } );
+    }
+
+    std::vector< Affine > functions( 2 * p, Affine{ 2, s } );
+    BSPLib::ReducePtrs( functions.data(), functions.size(), Compose(), tRoot, BSPLib::Group(), algorithm );
+
+    if ( s == tRoot )
+    {
+        for ( const Affine &f : functions )
+        {
+            EXPECT_EQ( expected.a, f.a );
+            EXPECT_EQ( expected.b, f.b );
+        }
+    }
+
+    Affine function{ 2, s };
+    BSPLib::AllReducePtrs( &function, 1, Compose(), BSPLib::Group(), algorithm );
+
+    EXPECT_EQ( expected.a, function.a );
+    EXPECT_EQ( expected.b, function.b );
+}
+
+BspTest2( Collective, 6, ReduceOrderTest, 1, 0 );
+BspTest2( Collective, 6, ReduceOrderTest, 1, 4 );
+BspTest2( Collective, 6, ReduceOrderTest, 2, 0 );
+BspTest2( Collective, 6, ReduceOrderTest, 2, 5 );
+BspTest2( Collective, 6, ReduceOrderTest, 3, 2 );
+BspTest2( Collective, 6, ReduceOrderTest, 3, 5 );
+BspTest2( Collective, 11, ReduceOrderTest, 3, 9 );
+
+void ReduceGroupTest()
+{
+    // a cyclic distribution over 3 x 4 processors, with s = i + j * 3
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t i = s % 3;
+    const uint32_t j = s / 3;
+
+    const BSPLib::Group column( j * 3, 1, 3 );
+    const BSPLib::Group row( i, 3, 4 );
+
+    uint32_t value = s;
+    BSPLib::AllReduce( value, BSPLib::Sum(), column );
+    EXPECT_EQ( 9 * j + 3, value );
+
+    int32_t minimum = static_cast< int32_t >( s );
+    BSPLib::Reduce( minimum, BSPLib::Min(), row.Pid( 3 ), row );
+
+    if ( j == 3 )
+    {
+        EXPECT_EQ( static_cast< int32_t >( i ), minimum );
+    }
+
+    std::vector< double > norms( 5, 0.5 * s );
+    BSPLib::AllReduce( norms, BSPLib::Product(), row );
+    EXPECT_EQ( std::vector< double >( 5, 0.0625 * i * ( i + 3 ) * ( i + 6 ) * ( i + 9 ) ), norms );
+}
+
+BspTest( Collective, 12, ReduceGroupTest );
+
+template< uint32_t tAlgorithm, uint32_t tCount >
+void ScanTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const BSPLib::ScanAlgorithm algorithm = static_cast< BSPLib::ScanAlgorithm >( tAlgorithm );
+
+    std::vector< uint64_t > inclusive( tCount );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        inclusive[i] = s + i;
+    }
+
+    std::vector< uint64_t > exclusive( inclusive );
+
+    BSPLib::ScanPtrs( inclusive.data(), inclusive.size(), BSPLib::Sum(), BSPLib::Group(), algorithm );
+    BSPLib::ExScanPtrs( exclusive.data(), exclusive.size(), BSPLib::Sum(), BSPLib::Group(), uint64_t( 0 ), algorithm );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        EXPECT_EQ( static_cast< uint64_t >( s ) * ( s + 1 ) / 2 + ( s + 1 ) * i, inclusive[i] );
+        EXPECT_EQ( static_cast< uint64_t >( s ) * ( s - 1 ) / 2 + s * i, exclusive[i] );
+    }
+
+    // the composition checks the order of the operands
+    Affine expected{ 1, 0 };
+    Affine before = expected;
+
+    for ( uint32_t t = 0; t <= s; ++t )
+    {
+        before = expected;
+        expected = Compose()( expected, Affine{ 2, t } );
+    }
+
+    Affine function{ 2, s };
+    Affine previous{ 2, s };
+    BSPLib::ScanPtrs( &function, 1, Compose(), BSPLib::Group(), algorithm );
+    BSPLib::ExScanPtrs( &previous, 1, Compose(), BSPLib::Group(), Affine{ 1, 0 }, algorithm );
+
+    EXPECT_EQ( expected.a, function.a );
+    EXPECT_EQ( expected.b, function.b );
+    EXPECT_EQ( before.a, previous.a );
+    EXPECT_EQ( before.b, previous.b );
+}
+
+BspTest2( Collective, 1, ScanTest, 0, 3 );
+BspTest2( Collective, 7, ScanTest, 0, 1 );
+BspTest2( Collective, 7, ScanTest, 0, 100000 );
+BspTest2( Collective, 7, ScanTest, 1, 1 );
+BspTest2( Collective, 7, ScanTest, 1, 1000 );
+BspTest2( Collective, 16, ScanTest, 1, 20 );
+BspTest2( Collective, 16, ScanTest, 2, 1 );
+BspTest2( Collective, 5, ScanTest, 2, 1000 );
+BspTest2( Collective, 13, ScanTest, 2, 17 );
+
+void ScanGroupTest()
+{
+    // a cyclic distribution over 3 x 4 processors, with s = i + j * 3
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t i = s % 3;
+    const uint32_t j = s / 3;
+
+    const BSPLib::Group row( i, 3, 4 );
+
+    size_t offset = s;
+    BSPLib::ExScan( offset, BSPLib::Sum(), row );
+    EXPECT_EQ( j * i + 3 * j * ( j - 1 ) / 2, offset );
+
+    int32_t maximum = static_cast< int32_t >( ( 7 * s ) % 12 );
+    BSPLib::Scan( maximum, BSPLib::Max() );
+
+    int32_t expected = 0;
+
+    for ( uint32_t t = 0; t <= s; ++t )
+    {
+        expected = std::max( expected, static_cast< int32_t >( ( 7 * t ) % 12 ) );
+    }
+
+    EXPECT_EQ( expected, maximum );
+
+    std::vector< double > products( 3, 2.0 );
+    BSPLib::Scan( products, BSPLib::Product(), row );
+    EXPECT_EQ( std::vector< double >( 3, static_cast< double >( 2 << j ) ), products );
+}
+
+BspTest( Collective, 12, ScanGroupTest );
+
+void AllToAllvTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    std::vector< std::vector< uint32_t > > send( p );
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        for ( uint32_t i = 0; i < ( s + 2 * t ) % 5; ++i )
+        {
+            send[t].push_back( s * 10000 + t * 100 + i );
+        }
+    }
+
+    std::vector< std::vector< uint32_t > > received;
+    BSPLib::AllToAllv( send, received );
+
+    ASSERT_EQ( p, received.size() );
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        ASSERT_EQ( ( t + 2 * s ) % 5, received[t].size() );
+
+        for ( uint32_t i = 0; i < received[t].size(); ++i )
+        {
+            EXPECT_EQ( t * 10000 + s * 100 + i, received[t][i] );
+        }
+    }
+}
+
+BspTest( Collective, 1, AllToAllvTest );
+BspTest( Collective, 5, AllToAllvTest );
+BspTest( Collective, 16, AllToAllvTest );
+
+void AllToAllvPtrsTest()
+{
+    // a cyclic distribution over 3 x 4 processors, with s = i + j * 3
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t j = s / 3;
+    const BSPLib::Group column( j * 3, 1, 3 );
+    const uint32_t rank = column.Rank( s );
+
+    // rank r sends r + t doubles to rank t
+    std::vector< double > send;
+    std::vector< size_t > sendCounts;
+
+    for ( uint32_t t = 0; t < 3; ++t )
+    {
+        sendCounts.push_back( rank + t );
+        send.insert( send.end(), rank + t, s + 0.5 * t );
+    }
+
+    std::vector< double > received( 1, -1.0 );
+    std::vector< size_t > receivedCounts;
+    BSPLib::AllToAllvPtrs( send.data(), sendCounts.data(), received, receivedCounts, column );
+
+    std::vector< double > expected;
+
+    for ( uint32_t r = 0; r < 3; ++r )
+    {
+        EXPECT_EQ( r + rank, receivedCounts[r] );
+        expected.insert( expected.end(), r + rank, column.Pid( r ) + 0.5 * rank );
+    }
+
+    EXPECT_EQ( expected, received );
+}
+
+BspTest( Collective, 12, AllToAllvPtrsTest );
+
+template< uint32_t tAlgorithm, uint32_t tCount >
+void AllGatherPtrsTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    std::vector< uint32_t > send( tCount );
+
+    for ( uint32_t i = 0; i < tCount; ++i )
+    {
+        send[i] = s * 1000 + i;
+    }
+
+    std::vector< uint32_t > received( p * tCount );
+    BSPLib::AllGatherPtrs( send.data(), tCount, received.data(), BSPLib::Group(),
+                           static_cast< BSPLib::AllGatherAlgorithm >( tAlgorithm ) );
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        for ( uint32_t i = 0; i < tCount; ++i )
+        {
+            EXPECT_EQ( t * 1000 + i, received[t * tCount + i] );
+        }
+    }
+
+    // variable sizes, of which processor t contributes t % 4 elements
+    std::vector< uint32_t > variable( s % 4, s );
+    std::vector< uint32_t > all;
+    std::vector< size_t > counts;
+    BSPLib::AllGathervPtrs( variable.data(), variable.size(), all, counts, BSPLib::Group(),
+                            static_cast< BSPLib::AllGatherAlgorithm >( tAlgorithm ) );
+
+    std::vector< uint32_t > expected;
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        EXPECT_EQ( t % 4, counts[t] );
+        expected.insert( expected.end(), t % 4, t );
+    }
+
+    EXPECT_EQ( expected, all );
+}
+
+BspTest2( Collective, 1, AllGatherPtrsTest, 0, 3 );
+BspTest2( Collective, 7, AllGatherPtrsTest, 0, 1 );
+BspTest2( Collective, 7, AllGatherPtrsTest, 1, 1 );
+BspTest2( Collective, 7, AllGatherPtrsTest, 1, 100 );
+BspTest2( Collective, 8, AllGatherPtrsTest, 2, 1 );
+BspTest2( Collective, 13, AllGatherPtrsTest, 2, 17 );
+BspTest2( Collective, 16, AllGatherPtrsTest, 2, 100 );
+BspTest2( Collective, 33, AllGatherPtrsTest, 0, 5 );
+
+void GatherScatterTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+    const uint32_t root = p - 1;
+    const uint32_t second = p > 1 ? 1 : 0;
+
+    std::vector< uint64_t > values;
+    BSPLib::Gather( uint64_t( s * s ), values, root );
+
+    if ( s == root )
+    {
+        ASSERT_EQ( p, values.size() );
+
+        for ( uint32_t t = 0; t < p; ++t )
+        {
+            EXPECT_EQ( t * t, values[t] );
+            values[t] = t + 7;
+        }
+    }
+
+    uint64_t value = 0;
+    BSPLib::Scatter( values, value, root );
+    EXPECT_EQ( s + 7, value );
+
+    std::vector< std::vector< uint16_t > > parts;
+    BSPLib::Gather( std::vector< uint16_t >( s, static_cast< uint16_t >( s ) ), parts, second );
+
+    if ( s == second )
+    {
+        ASSERT_EQ( p, parts.size() );
+
+        for ( uint32_t t = 0; t < p; ++t )
+        {
+            EXPECT_EQ( std::vector< uint16_t >( t, static_cast< uint16_t >( t ) ), parts[t] );
+            parts[t].assign( p - t, static_cast< uint16_t >( 2 * t ) );
+        }
+    }
+
+    std::vector< uint16_t > part( 3, 0 );
+    BSPLib::Scatter( parts, part, second );
+    EXPECT_EQ( std::vector< uint16_t >( p - s, static_cast< uint16_t >( 2 * s ) ), part );
+
+    std::vector< uint32_t > ranks;
+    BSPLib::AllGather( s, ranks );
+    ASSERT_EQ( p, ranks.size() );
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        EXPECT_EQ( t, ranks[t] );
+    }
+
+    std::vector< std::vector< char > > strings;
+    BSPLib::AllGather( std::vector< char >( s % 3, 'a' + s ), strings );
+    ASSERT_EQ( p, strings.size() );
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        EXPECT_EQ( std::vector< char >( t % 3, 'a' + t ), strings[t] );
+    }
+}
+
+BspTest( Collective, 1, GatherScatterTest );
+BspTest( Collective, 6, GatherScatterTest );
+
+void GatherGroupTest()
+{
+    // a cyclic distribution over 3 x 4 processors, with s = i + j * 3
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t i = s % 3;
+    const BSPLib::Group row( i, 3, 4 );
+
+    std::vector< uint32_t > pair = { s, s + 100 };
+    std::vector< uint32_t > gathered( 8, 0 );
+    BSPLib::GatherPtrs( pair.data(), 2, gathered.data(), row.Pid( 2 ), row );
+
+    if ( row.Rank( s ) == 2 )
+    {
+        for ( uint32_t j = 0; j < 4; ++j )
+        {
+            EXPECT_EQ( row.Pid( j ), gathered[2 * j] );
+            EXPECT_EQ( row.Pid( j ) + 100, gathered[2 * j + 1] );
+        }
+    }
+
+    std::vector< uint32_t > scattered( 2, 0 );
+    BSPLib::ScatterPtrs( gathered.data(), scattered.data(), 2, row.Pid( 2 ), row );
+    EXPECT_EQ( pair, scattered );
+}
+
+BspTest( Collective, 12, GatherGroupTest );
+
+void ExchangeTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    // processor s sends t + 1 values to every t > s, in two spans, and nothing to the others
+    std::vector< uint32_t > values( p + 1 );
+
+    for ( uint32_t i = 0; i <= p; ++i )
+    {
+        values[i] = s * 100 + i;
+    }
+
+    std::vector< BSPLib::ExchangeSpan > spans;
+
+    for ( uint32_t t = s + 1; t < p; ++t )
+    {
+        spans.push_back( BSPLib::ExchangeSpan{ t, values.data(), sizeof( uint32_t ) } );
+        spans.push_back( BSPLib::ExchangeSpan{ t, values.data() + 1, t * sizeof( uint32_t ) } );
+    }
+
+    // exchanges complete other communication like a synchronisation
+    uint32_t neighbour = 0;
+    BSPLib::Push( neighbour );
+    BSPLib::Sync();
+
+    uint32_t self = s;
+    BSPLib::Put( ( s + 1 ) % p, self, neighbour );
+
+    BSPLib::ExchangeBuffer received;
+    BSPLib::Exchange( spans, received );
+
+    EXPECT_EQ( ( s + p - 1 ) % p, neighbour );
+
+    size_t total = 0;
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        if ( t < s )
+        {
+            ASSERT_EQ( s + 1, received.Count< uint32_t >( t ) );
+
+            std::vector< uint32_t > values( s + 1 );
+            EXPECT_EQ( values.data() + values.size(), received.Copy( t, values.data() ) );
+
+            for ( uint32_t i = 0; i <= s; ++i )
+            {
+                EXPECT_EQ( t * 100 + i, values[i] );
+            }
+        }
+        else
+        {
+            EXPECT_EQ( 0u, received.Size( t ) );
+        }
+
+        total += received.Size( t );
+    }
+
+    EXPECT_EQ( total, received.TotalSize() );
+
+    // a second exchange reuses the buffer, and may be empty
+    BSPLib::Exchange( std::vector< BSPLib::ExchangeSpan >(), received );
+    EXPECT_EQ( 0u, received.TotalSize() );
+    EXPECT_EQ( 0u, received.Size( 0 ) );
+
+    BSPLib::Pop( neighbour );
+    BSPLib::Sync();
+}
+
+BspTest( Collective, 1, ExchangeTest );
+BspTest( Collective, 4, ExchangeTest );
+BspTest( Collective, 16, ExchangeTest );
+
+template< uint32_t tCount, uint32_t tDistinct, bool tDescending >
+void SortTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    // processor s has s * tCount elements
+    std::vector< uint64_t > values;
+    uint64_t state = s * 7919 + 1;
+
+    for ( uint32_t i = 0; i < s * tCount; ++i )
+    {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        values.push_back( ( state >> 33 ) % tDistinct );
+    }
+
+    std::vector< uint64_t > totals = { values.size(), 0 };
+
+    for ( uint64_t value : values )
+    {
+        totals[1] += value;
+    }
+
+    BSPLib::AllReduce( totals, BSPLib::Sum() );
+
+    if ( tDescending )
+    {
+        BSPLib::Sort( values, std::greater< uint64_t >() );
+    }
+    else
+    {
+        BSPLib::Sort( values );
+    }
+
+    if ( tDescending )
+    {
+        EXPECT_TRUE( std::is_sorted( values.begin(), values.end(), std::greater< uint64_t >() ) );
+    }
+    else
+    {
+        EXPECT_TRUE( std::is_sorted( values.begin(), values.end() ) );
+    }
+
+    std::vector< uint64_t > after = { values.size(), 0 };
+
+    for ( uint64_t value : values )
+    {
+        after[1] += value;
+    }
+
+    BSPLib::AllReduce( after, BSPLib::Sum() );
+    EXPECT_EQ( totals, after );
+
+    // the ranges of consecutive processors follow each other
+    std::vector< std::vector< uint64_t > > bounds;
+    std::vector< uint64_t > own;
+
+    if ( !values.empty() )
+    {
+        own = { values.front(), values.back() };
+    }
+
+    BSPLib::AllGather( own, bounds );
+    const uint64_t *previous = nullptr;
+
+    for ( uint32_t t = 0; t < p; ++t )
+    {
+        if ( bounds[t].empty() )
+        {
+            continue;
+        }
+
+        if ( previous )
+        {
+            EXPECT_TRUE( tDescending ? *previous >= bounds[t][0] : *previous <= bounds[t][0] );
+        }
+
+        previous = &bounds[t][1];
+    }
+}
+
+BspTest3( Collective, 1, SortTest, 100, 1000, false );
+BspTest3( Collective, 4, SortTest, 0, 1000, false );
+BspTest3( Collective, 5, SortTest, 1000, 1000000, false );
+BspTest3( Collective, 5, SortTest, 1000, 3, false );
+BspTest3( Collective, 8, SortTest, 1, 1000, true );
+BspTest3( Collective, 16, SortTest, 500, 100000, true );
+
+TEST( P( Collective ), ChooseAllGather )
+{
+    EXPECT_EQ( BSPLib::AllGatherAlgorithm::OnePhase, BSPLib::ChooseAllGather( 16, 8 ) );
+    EXPECT_EQ( BSPLib::AllGatherAlgorithm::Bruck, BSPLib::ChooseAllGather( 64, 8 ) );
+    EXPECT_EQ( BSPLib::AllGatherAlgorithm::OnePhase, BSPLib::ChooseAllGather( 64, 1 << 20 ) );
+}
+
+TEST( P( Collective ), ChooseScan )
+{
+    EXPECT_EQ( BSPLib::ScanAlgorithm::OnePhase, BSPLib::ChooseScan( 2, 1 << 20 ) );
+    EXPECT_EQ( BSPLib::ScanAlgorithm::OnePhase, BSPLib::ChooseScan( 16, 8 ) );
+    EXPECT_EQ( BSPLib::ScanAlgorithm::Logarithmic, BSPLib::ChooseScan( 16, 1 << 20 ) );
+    EXPECT_EQ( BSPLib::ScanAlgorithm::Logarithmic, BSPLib::ChooseScan( 1024, 128 ) );
+}
+
+TEST( P( Collective ), ChooseReduce )
+{
+    EXPECT_EQ( BSPLib::ReduceAlgorithm::OnePhase, BSPLib::ChooseReduce( 2, 1 << 20, 1 << 17 ) );
+    EXPECT_EQ( BSPLib::ReduceAlgorithm::OnePhase, BSPLib::ChooseReduce( 16, 8, 1 ) );
+    EXPECT_EQ( BSPLib::ReduceAlgorithm::ReduceScatter, BSPLib::ChooseReduce( 16, 1 << 20, 1 << 17 ) );
+    EXPECT_EQ( BSPLib::ReduceAlgorithm::RecursiveDoubling, BSPLib::ChooseReduce( 1024, 800, 100 ) );
+}
+
+TEST( P( Collective ), ChooseBroadcast )
+{
+    EXPECT_EQ( BSPLib::BroadcastAlgorithm::OnePhase, BSPLib::ChooseBroadcast( 2, 1 << 20 ) );
+    EXPECT_EQ( BSPLib::BroadcastAlgorithm::OnePhase, BSPLib::ChooseBroadcast( 16, 8 ) );
+    EXPECT_EQ( BSPLib::BroadcastAlgorithm::TwoPhase, BSPLib::ChooseBroadcast( 16, 1 << 20 ) );
+    EXPECT_EQ( BSPLib::BroadcastAlgorithm::Tree, BSPLib::ChooseBroadcast( 256, 8192 ) );
+}
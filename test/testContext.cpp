@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <thread>
+
+template< uint32_t tProcs, uint32_t tSyncs >
+void ContextRingTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    EXPECT_EQ( tProcs, nProc );
+
+    uint32_t receive = 0;
+
+    BSPLib::Push( receive );
+    BSPLib::Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        uint32_t num = s * tProcs + i;
+        BSPLib::Put( ( s + 1 ) % nProc, num, receive );
+        BSPLib::Send( ( s + nProc - 1 ) % nProc, num );
+
+        BSPLib::Sync();
+
+        uint32_t message = 0;
+        BSPLib::Move( message );
+
+        EXPECT_EQ( ( ( s + nProc - 1 ) % nProc ) * tProcs + i, receive );
+        EXPECT_EQ( ( ( s + 1 ) % nProc ) * tProcs + i, message );
+    }
+
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+TEST( P( Context ), SideBySide )
+{
+    BSPLib::Context first;
+    BSPLib::Context second;
+
+    bool firstResult = false;
+    bool secondResult = false;
+
+    std::thread firstJob( [&]
+    {
+        firstResult = first.Execute( ContextRingTest< 4, 200 >, 4 );
+    } );
+
+    std::thread secondJob( [&]
+    {
+        secondResult = second.Execute( ContextRingTest< 7, 200 >, 7 );
+    } );
+
+    firstJob.join();
+    secondJob.join();
+
+    EXPECT_TRUE( firstResult );
+    EXPECT_TRUE( secondResult );
+}
+
+TEST( P( Context ), Nested )
+{
+    BSPLib::Context inner;
+
+    BSPLib::Execute( [&inner]
+    {
+        const uint32_t s = BSPLib::ProcId();
+
+        if ( s == 1 )
+        {
+            EXPECT_TRUE( inner.Execute( ContextRingTest< 3, 10 >, 3 ) );
+        }
+
+        EXPECT_EQ( s, BSPLib::ProcId() );
+        EXPECT_EQ( 2u, BSPLib::NProcs() );
+
+        BSPLib::Sync();
+    }, 2 );
+}
+
+TEST( P( Context ), Reuse )
+{
+    BSPLib::Context context;
+
+    for ( uint32_t i = 0; i < 5; ++i )
+    {
+        EXPECT_TRUE( context.Execute( ContextRingTest< 5, 3 >, 5 ) );
+    }
+
+    EXPECT_TRUE( BSPLib::Execute( ContextRingTest< 6, 3 >, 6 ) );
+}
+
+TEST( P( Context ), OutputSuffix )
+{
+    EXPECT_EQ( "spmv-context1.csv", BSP::InsertSuffix( "spmv.csv", "-context1" ) );
+    EXPECT_EQ( "out/run.1/spmv-context2", BSP::InsertSuffix( "out/run.1/spmv", "-context2" ) );
+    EXPECT_EQ( "out/.trace-context3", BSP::InsertSuffix( "out/.trace", "-context3" ) );
+    EXPECT_EQ( "spmv.csv", BSP::InsertSuffix( "spmv.csv", "" ) );
+    EXPECT_EQ( "", BSP::InsertSuffix( "", "-context1" ) );
+}
@@ -0,0 +1,206 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <algorithm>
+#include <vector>
+
+typedef BSPLib::BlockDistribution Block;
+typedef BSPLib::CyclicDistribution Cyclic;
+typedef BSPLib::BlockCyclicDistribution< 3 > BlockCyclic3;
+
+template< typename tDistribution >
+void CheckDistribution( size_t size, uint32_t nProcs )
+{
+    const tDistribution distribution( size, nProcs );
+    std::vector< size_t > counts( nProcs, 0 );
+
+    for ( size_t global = 0; global < size; ++global )
+    {
+        const uint32_t owner = distribution.Owner( global );
+        ASSERT_LT( owner, nProcs );
+
+        // local indices follow the global order
+        EXPECT_EQ( counts[owner], distribution.LocalIndex( global ) );
+        EXPECT_EQ( global, distribution.GlobalIndex( owner, counts[owner] ) );
+
+        for ( uint32_t pid = 0; pid < nProcs; ++pid )
+        {
+            EXPECT_EQ( counts[pid], distribution.LocalCount( pid, global ) );
+        }
+
+        ++counts[owner];
+    }
+
+    for ( uint32_t pid = 0; pid < nProcs; ++pid )
+    {
+        EXPECT_EQ( counts[pid], distribution.LocalSize( pid ) );
+        EXPECT_EQ( counts[pid], distribution.LocalCount( pid, size ) );
+    }
+}
+
+TEST( P( DistributedArray ), Distributions )
+{
+    const size_t sizes[] = { 0, 1, 7, 16, 100 };
+    const uint32_t procs[] = { 1, 3, 4, 16 };
+
+    for ( size_t size : sizes )
+    {
+        for ( uint32_t nProcs : procs )
+        {
+            CheckDistribution< Block >( size, nProcs );
+            CheckDistribution< Cyclic >( size, nProcs );
+            CheckDistribution< BlockCyclic3 >( size, nProcs );
+        }
+    }
+}
+
+TEST( P( DistributedArray ), CyclicLocalSize )
+{
+    // the local vector length of BSPedupack
+    const Cyclic distribution( 10, 4 );
+
+    for ( uint32_t s = 0; s < 4; ++s )
+    {
+        EXPECT_EQ( ( 10 + 4 - s - 1 ) / 4, distribution.LocalSize( s ) );
+    }
+}
+
+template< typename tDistribution, uint32_t tSize >
+void DistributedArrayTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t p = BSPLib::NProcs();
+
+    BSPLib::DistributedArray< uint64_t, tDistribution > array( tSize );
+    EXPECT_EQ( tSize, array.Size() );
+
+    for ( size_t local = 0; local < array.LocalSize(); ++local )
+    {
+        EXPECT_TRUE( array.IsLocal( array.GlobalIndex( local ) ) );
+        array[local] = array.GlobalIndex( local ) * 10;
+    }
+
+    array.Sync();
+
+    // every processor reads the whole array
+    std::vector< uint64_t > all( tSize );
+    array.GetRange( 0, tSize, all.data() );
+
+    uint64_t single = 0;
+
+    if ( tSize > 0 )
+    {
+        array.Get( ( s * 7 ) % tSize, single );
+    }
+
+    array.Sync();
+
+    for ( uint32_t i = 0; i < tSize; ++i )
+    {
+        EXPECT_EQ( i * 10, all[i] );
+    }
+
+    if ( tSize > 0 )
+    {
+        EXPECT_EQ( ( s * 7 ) % tSize * 10, single );
+    }
+
+    // processor s writes a range of its own, and the last processor writes element 0, which no range overlaps
+    const size_t first = std::max< size_t >( 1, tSize * s / p );
+    const size_t last = std::max< size_t >( first, tSize * ( s + 1 ) / p );
+    std::vector< uint64_t > values;
+
+    for ( size_t i = first; i < last; ++i )
+    {
+        values.push_back( i + 1000 );
+    }
+
+    array.PutRange( first, last - first, values.data() );
+
+    if ( s == p - 1 && tSize > 0 )
+    {
+        array.Put( 0, 42 );
+    }
+
+    array.Sync();
+
+    for ( size_t local = 0; local < array.LocalSize(); ++local )
+    {
+        const size_t global = array.GlobalIndex( local );
+        EXPECT_EQ( global == 0 ? 42 : global + 1000, array[local] );
+    }
+
+    // a partial range that starts inside a block
+    if ( tSize > 5 )
+    {
+        std::vector< uint64_t > part( tSize - 5 );
+        array.GetRange( 3, part.size(), part.data() );
+        array.Sync();
+
+        for ( size_t i = 0; i < part.size(); ++i )
+        {
+            EXPECT_EQ( i + 3 + 1000, part[i] );
+        }
+    }
+    else
+    {
+        array.Sync();
+    }
+}
+
+BspTest2( DistributedArray, 1, DistributedArrayTest, Block, 10 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, Block, 0 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, Block, 3 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, Block, 37 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, Cyclic, 3 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, Cyclic, 37 );
+BspTest2( DistributedArray, 7, DistributedArrayTest, Cyclic, 100 );
+BspTest2( DistributedArray, 4, DistributedArrayTest, BlockCyclic3, 37 );
+BspTest2( DistributedArray, 7, DistributedArrayTest, BlockCyclic3, 100 );
+
+void DistributedArraysTest()
+{
+    // arrays register and deregister in the same order on all processors
+    BSPLib::DistributedArray< double, Cyclic > x( 20 );
+    BSPLib::DistributedArray< double, Cyclic > y( 20 );
+
+    for ( size_t local = 0; local < x.LocalSize(); ++local )
+    {
+        x[local] = 1.0;
+        y[local] = 2.0;
+    }
+
+    BSPLib::Sync();
+
+    double dot = 0.0;
+
+    for ( size_t local = 0; local < x.LocalSize(); ++local )
+    {
+        dot += x[local] * y[local];
+    }
+
+    BSPLib::AllReduce( dot, BSPLib::Sum() );
+    EXPECT_EQ( 40.0, dot );
+}
+
+BspTest( DistributedArray, 6, DistributedArraysTest );
@@ -22,6 +22,10 @@
 #include "helper.h"
 
 #include <array>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
 
 template< int32_t tOffset, typename tPrimitive >
 void PutPaddedPrimitiveTest()
@@ -362,6 +366,854 @@ void TagPrimitiveStringOverloadTest()
     EXPECT_EQ( sizeof( uint32_t ), status );
 }
 
+inline void AffinityCompactTest()
+{
+    const std::vector< uint32_t > order = BspInternal::Topology::GetInstance().GetCompactOrder();
+
+#ifdef __linux__
+    EXPECT_EQ( ( int32_t )order[BSPLib::ProcId() % order.size()], BSPLib::GetAffinity() );
+#else
+    EXPECT_EQ( -1, BSPLib::GetAffinity() );
+#endif
+}
+
+inline void AffinityNoneTest()
+{
+    EXPECT_EQ( -1, BSPLib::GetAffinity() );
+}
+
+TEST( P( Extra ), AffinityCompact )
+{
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::Compact );
+    BSPLib::Execute( AffinityCompactTest, 4 );
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::Environment );
+}
+
+TEST( P( Extra ), AffinityNone )
+{
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::None );
+    BSPLib::Execute( AffinityNoneTest, 4 );
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::Environment );
+}
+
+inline void AffinityAbortTest()
+{
+    if ( BSPLib::ProcId() == 1 )
+    {
+        BSPLib::Classic::Abort( "" );
+    }
+
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), AffinityRestoredAfterAbort )
+{
+#ifdef __linux__
+    cpu_set_t before;
+    ASSERT_EQ( 0, sched_getaffinity( 0, sizeof( cpu_set_t ), &before ) );
+
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::Compact );
+    EXPECT_FALSE( BSPLib::Execute( AffinityAbortTest, 4 ) );
+
+    // the next program must restore the mask of the caller, not the pinning of the aborted program
+    EXPECT_TRUE( BSPLib::Execute( AffinityCompactTest, 4 ) );
+    BSPLib::SetAffinity( BSPLib::AffinityPolicy::Environment );
+
+    cpu_set_t after;
+    ASSERT_EQ( 0, sched_getaffinity( 0, sizeof( cpu_set_t ), &after ) );
+    EXPECT_TRUE( CPU_EQUAL( &before, &after ) );
+#endif
+}
+
+TEST( P( Extra ), AffinityParse )
+{
+    std::vector< uint32_t > cpus;
+
+    EXPECT_EQ( BSPLib::AffinityPolicy::Explicit, BspInternal::Affinity::Parse( "0,2-4", cpus ) );
+    EXPECT_EQ( std::vector< uint32_t >( { 0, 2, 3, 4 } ), cpus );
+
+    EXPECT_EQ( BSPLib::AffinityPolicy::Compact, BspInternal::Affinity::Parse( "compact", cpus ) );
+    EXPECT_EQ( BSPLib::AffinityPolicy::Scatter, BspInternal::Affinity::Parse( "scatter", cpus ) );
+    EXPECT_EQ( BSPLib::AffinityPolicy::None, BspInternal::Affinity::Parse( "none", cpus ) );
+    EXPECT_EQ( BSPLib::AffinityPolicy::None, BspInternal::Affinity::Parse( "3-1", cpus ) );
+    EXPECT_TRUE( cpus.empty() );
+}
+
+TEST( P( Extra ), LazyCommunicationQueues )
+{
+    BspInternal::CommunicationQueues< std::vector< uint32_t > > queues( 256 );
+
+    EXPECT_EQ( nullptr, queues.TryGetQueueToMe( 3, 5 ) );
+
+    queues.GetQueueFromMe( 5, 3 ).push_back( 42 );
+
+    ASSERT_NE( nullptr, queues.TryGetQueueToMe( 3, 5 ) );
+    EXPECT_EQ( std::vector< uint32_t >( { 42 } ), *queues.TryGetQueueToMe( 3, 5 ) );
+    EXPECT_TRUE( queues.TryGetQueueToMe( 3, 4 )->empty() );
+    EXPECT_EQ( nullptr, queues.TryGetQueueToMe( 5, 3 ) );
+}
+
+TEST( P( Extra ), LazyStackAllocator )
+{
+    BspInternal::StackAllocator stack;
+
+    EXPECT_EQ( 0, stack.Size() );
+
+    const uint64_t value = 0xdeadbeefcafe;
+    const BspInternal::StackAllocator::StackLocation location = stack.Alloc( sizeof( value ), reinterpret_cast< const char * >( &value ) );
+
+    uint64_t result = 0;
+    stack.Extract( location, sizeof( result ), reinterpret_cast< char * >( &result ) );
+
+    EXPECT_EQ( value, result );
+    EXPECT_EQ( ( BspInternal::StackAllocator::StackLocation )sizeof( value ), stack.Size() );
+}
+
+inline void ProfileTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    uint64_t receive = 0;
+
+    BSPLib::Push( receive );
+    BSPLib::Sync();
+
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        uint64_t value = s;
+        BSPLib::Put( ( s + 1 ) % nProc, value, receive );
+        BSPLib::Send( ( s + 1 ) % nProc, value );
+
+        BSPLib::Sync();
+    }
+
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), Profile )
+{
+    const std::string prefix = "bsp-profile-test";
+
+    BSPLib::SetProfile( prefix );
+    EXPECT_TRUE( BSPLib::Execute( ProfileTest, 4 ) );
+    BSPLib::SetProfile( "" );
+
+    std::ifstream csv( prefix + ".csv" );
+    ASSERT_TRUE( csv.good() );
+
+    std::string line;
+    std::getline( csv, line );
+    EXPECT_EQ( 0u, line.find( "superstep,pid,compute_us" ) );
+
+    // five synchronisations and the end give six supersteps for every processor
+    uint32_t rows = 0;
+    uint32_t stragglers = 0;
+    uint64_t puts = 0;
+    uint64_t putBytes = 0;
+    uint64_t sends = 0;
+
+    while ( std::getline( csv, line ) )
+    {
+        std::vector< std::string > fields;
+        std::stringstream stream( line );
+        std::string field;
+
+        while ( std::getline( stream, field, ',' ) )
+        {
+            fields.push_back( field );
+        }
+
+        ASSERT_EQ( 12u, fields.size() );
+
+        puts += std::stoull( fields[5] );
+        putBytes += std::stoull( fields[6] );
+        sends += std::stoull( fields[9] );
+        stragglers += std::stoul( fields[11] );
+        ++rows;
+    }
+
+    EXPECT_EQ( 24u, rows );
+    EXPECT_EQ( 6u, stragglers );
+    EXPECT_EQ( 12u, puts );
+    EXPECT_EQ( 12u * sizeof( uint64_t ), putBytes );
+    EXPECT_EQ( 12u, sends );
+
+    csv.close();
+
+    std::ifstream trace( prefix + ".json" );
+    ASSERT_TRUE( trace.good() );
+
+    std::getline( trace, line );
+    EXPECT_EQ( "{\"traceEvents\":[", line );
+
+    trace.close();
+
+    std::remove( ( prefix + ".csv" ).c_str() );
+    std::remove( ( prefix + ".json" ).c_str() );
+}
+
+inline std::string CostModelSummary( double r )
+{
+    const std::string paramsPath = "bsp-cost-test.params";
+    const std::string reportPath = "bsp-cost-test.txt";
+
+    BspInternal::MachineParams params;
+    params.p = 4;
+    params.r = r;
+    params.g = 1.0;
+    params.l = 1.0;
+    EXPECT_TRUE( params.Save( paramsPath ) );
+
+    BSPLib::SetCostModel( paramsPath, reportPath );
+    EXPECT_TRUE( BSPLib::Execute( ProfileTest, 4 ) );
+    BSPLib::SetCostModel( "" );
+
+    std::ifstream report( reportPath );
+    EXPECT_TRUE( report.good() );
+
+    std::string line;
+    std::string summary;
+    uint32_t rows = 0;
+
+    std::getline( report, line );
+    std::getline( report, line );
+    EXPECT_EQ( 0u, line.find( "superstep,work_us,h_bytes" ) );
+
+    while ( std::getline( report, line ) )
+    {
+        summary = line;
+        ++rows;
+    }
+
+    // six supersteps and the summary
+    EXPECT_EQ( 7u, rows );
+
+    report.close();
+
+    std::remove( paramsPath.c_str() );
+    std::remove( reportPath.c_str() );
+
+    return summary;
+}
+
+TEST( P( Extra ), CostModel )
+{
+    // an infinitely fast machine is always slower than predicted, an infinitely slow one never
+    EXPECT_EQ( 0u, CostModelSummary( 1e300 ).find( "6 of 6 supersteps" ) );
+    EXPECT_EQ( 0u, CostModelSummary( 1e-300 ).find( "0 of 6 supersteps" ) );
+}
+
+TEST( P( Extra ), MachineParams )
+{
+    BspInternal::MachineParams params;
+    params.p = 8;
+    params.r = 1.5e9;
+    params.g = 12.5;
+    params.l = 4000.0;
+    ASSERT_TRUE( params.Save( "bsp-params-test.params" ) );
+
+    BspInternal::MachineParams loaded;
+    ASSERT_TRUE( loaded.Load( "bsp-params-test.params" ) );
+    std::remove( "bsp-params-test.params" );
+
+    EXPECT_EQ( 8u, loaded.p );
+    EXPECT_DOUBLE_EQ( 1.5e9, loaded.r );
+    EXPECT_DOUBLE_EQ( 12.5, loaded.g );
+    EXPECT_DOUBLE_EQ( 4000.0, loaded.l );
+
+    // 16 bytes are 2 words: ( 2 * 12.5 + 4000 ) / 1.5e9 seconds
+    EXPECT_NEAR( 4025.0 / 1.5e9 * 1e6, loaded.Predict( 16 ), 1e-9 );
+
+    EXPECT_FALSE( loaded.Load( "bsp-params-missing.params" ) );
+
+    // a file without g and l would predict every superstep to be free
+    FILE *file = fopen( "bsp-params-test.params", "w" );
+    ASSERT_NE( nullptr, file );
+    fprintf( file, "p 8\nr 1500000000\nword 8\n" );
+    fclose( file );
+
+    BspInternal::MachineParams partial;
+    EXPECT_FALSE( partial.Load( "bsp-params-test.params" ) );
+    std::remove( "bsp-params-test.params" );
+}
+
+inline void CommunicationMatrixTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    uint64_t receive = 0;
+    uint64_t value = s;
+
+    BSPLib::Push( receive );
+    BSPLib::Push( value );
+    BSPLib::Sync();
+
+    BSPLib::Put( ( s + 1 ) % nProc, value, receive );
+    BSPLib::Send( ( s + 2 ) % nProc, value );
+    BSPLib::Get( ( s + 3 ) % nProc, value, receive );
+    BSPLib::Sync();
+
+    BSPLib::Pop( value );
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), CommunicationMatrix )
+{
+    const std::string path = "bsp-matrix-test.csv";
+
+    BSPLib::SetCommunicationMatrix( path );
+    EXPECT_TRUE( BSPLib::Execute( CommunicationMatrixTest, 4 ) );
+    BSPLib::SetCommunicationMatrix( "" );
+
+    std::ifstream csv( path );
+    ASSERT_TRUE( csv.good() );
+
+    std::vector< std::string > lines;
+    std::string line;
+
+    while ( std::getline( csv, line ) )
+    {
+        lines.push_back( line );
+    }
+
+    csv.close();
+    std::remove( path.c_str() );
+
+    // only the second superstep communicates, every processor to three others
+    ASSERT_EQ( 13u, lines.size() );
+    EXPECT_EQ( "superstep,source,target,puts,put_bytes,gets,get_bytes,sends,send_bytes,exchanges,exchange_bytes", lines[0] );
+    EXPECT_EQ( "1,0,1,1,8,0,0,0,0,0,0", lines[1] );
+    EXPECT_EQ( "1,0,2,0,0,0,0,1,8,0,0", lines[2] );
+    EXPECT_EQ( "1,0,3,0,0,1,8,0,0,0,0", lines[3] );
+    EXPECT_EQ( "1,3,0,1,8,0,0,0,0,0,0", lines[10] );
+    EXPECT_EQ( "1,3,1,0,0,0,0,1,8,0,0", lines[11] );
+    EXPECT_EQ( "1,3,2,0,0,1,8,0,0,0,0", lines[12] );
+}
+
+inline std::vector< std::string > ReadLines( const std::string &path )
+{
+    std::ifstream file( path );
+    std::vector< std::string > lines;
+    std::string line;
+
+    while ( std::getline( file, line ) )
+    {
+        lines.push_back( line );
+    }
+
+    return lines;
+}
+
+TEST( P( Extra ), RecordReplay )
+{
+    const std::string path = "bsp-record-test.bin";
+
+    BSPLib::SetRecord( path );
+    BSPLib::SetCommunicationMatrix( "bsp-record-test.csv" );
+    EXPECT_TRUE( BSPLib::Execute( CommunicationMatrixTest, 4 ) );
+    BSPLib::SetRecord( "" );
+
+    BspInternal::Recording recording;
+    ASSERT_TRUE( recording.Load( path ) );
+    ASSERT_EQ( 4u, recording.processors.size() );
+
+    typedef BspInternal::ReplayRecord Record;
+    const std::vector< Record > &records = recording.processors[0];
+
+    ASSERT_EQ( 10u, records.size() );
+    EXPECT_EQ( Record::Push, records[0].kind );
+    EXPECT_EQ( 8u, records[0].size );
+    EXPECT_EQ( Record::Push, records[1].kind );
+    EXPECT_EQ( Record::Sync, records[2].kind );
+
+    EXPECT_EQ( Record::Put, records[3].kind );
+    EXPECT_EQ( 1u, records[3].target );
+    EXPECT_EQ( 0u, records[3].id );
+    EXPECT_EQ( 8u, records[3].size );
+
+    EXPECT_EQ( Record::Send, records[4].kind );
+    EXPECT_EQ( 2u, records[4].target );
+    EXPECT_EQ( 8u, records[4].size );
+
+    EXPECT_EQ( Record::Get, records[5].kind );
+    EXPECT_EQ( 3u, records[5].target );
+    EXPECT_EQ( 1u, records[5].id );
+
+    EXPECT_EQ( Record::Sync, records[6].kind );
+    EXPECT_EQ( Record::Pop, records[7].kind );
+    EXPECT_EQ( 1u, records[7].id );
+    EXPECT_EQ( Record::Pop, records[8].kind );
+    EXPECT_EQ( 0u, records[8].id );
+    EXPECT_EQ( Record::Sync, records[9].kind );
+
+    // the replay produces the same traffic as the recorded computation
+    double seconds = -1.0;
+    BSPLib::SetCommunicationMatrix( "bsp-replay-test.csv" );
+    EXPECT_TRUE( BSPLib::Replay( path, seconds ) );
+    BSPLib::SetCommunicationMatrix( "" );
+
+    EXPECT_GE( seconds, 0.0 );
+    EXPECT_EQ( ReadLines( "bsp-record-test.csv" ), ReadLines( "bsp-replay-test.csv" ) );
+    EXPECT_EQ( 13u, ReadLines( "bsp-replay-test.csv" ).size() );
+
+    std::remove( path.c_str() );
+    std::remove( "bsp-record-test.csv" );
+    std::remove( "bsp-replay-test.csv" );
+
+    EXPECT_FALSE( BSPLib::Replay( "bsp-record-missing.bin", seconds ) );
+}
+
+inline bool LoadsWith( BspInternal::Recording recording, uint32_t pid, size_t index,
+                       const BspInternal::ReplayRecord &record )
+{
+    const std::string path = "bsp-record-corrupt.bin";
+
+    recording.processors[pid][index] = record;
+    EXPECT_TRUE( recording.Save( path ) );
+
+    BspInternal::Recording loaded;
+    const bool valid = loaded.Load( path );
+    std::remove( path.c_str() );
+
+    return valid;
+}
+
+TEST( P( Extra ), RecordRejectsCorrupt )
+{
+    const std::string path = "bsp-record-test.bin";
+
+    BSPLib::SetRecord( path );
+    EXPECT_TRUE( BSPLib::Execute( CommunicationMatrixTest, 4 ) );
+    BSPLib::SetRecord( "" );
+
+    BspInternal::Recording recording;
+    ASSERT_TRUE( recording.Load( path ) );
+    std::remove( path.c_str() );
+
+    // the put of processor 0 writes 8 bytes in register 0 of processor 1
+    typedef BspInternal::ReplayRecord Record;
+    const Record put = recording.processors[0][3];
+    ASSERT_EQ( Record::Put, put.kind );
+    EXPECT_TRUE( LoadsWith( recording, 0, 3, put ) );
+
+    Record corrupt = put;
+    corrupt.target = 4;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    corrupt = put;
+    corrupt.id = 2;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    corrupt = put;
+    corrupt.offset = 4;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    corrupt = put;
+    corrupt.offset = -8;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    corrupt = put;
+    corrupt.kind = 42;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    // a processor that synchronises less often than the others
+    corrupt = put;
+    corrupt.kind = Record::Sync;
+    EXPECT_FALSE( LoadsWith( recording, 0, 3, corrupt ) );
+
+    // counts larger than the file are rejected before they are allocated
+    const uint32_t version = BspInternal::Recording::Version();
+    const uint32_t nProcs = 0xffffffffu;
+    const uint64_t count = 0xffffffffffffull;
+
+    FILE *file = fopen( path.c_str(), "wb" );
+    ASSERT_NE( nullptr, file );
+    fwrite( "BSPR", 4, 1, file );
+    fwrite( &version, sizeof( version ), 1, file );
+    fwrite( &nProcs, sizeof( nProcs ), 1, file );
+    fclose( file );
+    EXPECT_FALSE( recording.Load( path ) );
+
+    const uint32_t oneProc = 1;
+    file = fopen( path.c_str(), "wb" );
+    ASSERT_NE( nullptr, file );
+    fwrite( "BSPR", 4, 1, file );
+    fwrite( &version, sizeof( version ), 1, file );
+    fwrite( &oneProc, sizeof( oneProc ), 1, file );
+    fwrite( &count, sizeof( count ), 1, file );
+    fclose( file );
+    EXPECT_FALSE( recording.Load( path ) );
+    EXPECT_TRUE( recording.processors.empty() );
+
+    std::remove( path.c_str() );
+}
+
+inline void ExchangeRecordTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    uint64_t values[2] = { s, s + 1 };
+    std::vector< BSPLib::ExchangeSpan > spans;
+    spans.push_back( BSPLib::ExchangeSpan{ ( s + 1 ) % nProc, values, sizeof( values ) } );
+
+    BSPLib::ExchangeBuffer received;
+    BSPLib::Exchange( spans, received );
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), ExchangeRecordReplay )
+{
+    const std::string path = "bsp-exchange-test.bin";
+
+    BSPLib::SetRecord( path );
+    BSPLib::SetCommunicationMatrix( "bsp-exchange-test.csv" );
+    EXPECT_TRUE( BSPLib::Execute( ExchangeRecordTest, 4 ) );
+    BSPLib::SetRecord( "" );
+
+    const std::vector< std::string > lines = ReadLines( "bsp-exchange-test.csv" );
+    ASSERT_EQ( 5u, lines.size() );
+    EXPECT_EQ( "0,0,1,0,0,0,0,0,0,1,16", lines[1] );
+    EXPECT_EQ( "0,3,0,0,0,0,0,0,0,1,16", lines[4] );
+
+    BspInternal::Recording recording;
+    ASSERT_TRUE( recording.Load( path ) );
+
+    typedef BspInternal::ReplayRecord Record;
+    const std::vector< Record > &records = recording.processors[1];
+
+    ASSERT_EQ( 3u, records.size() );
+    EXPECT_EQ( Record::Exchange, records[0].kind );
+    EXPECT_EQ( 2u, records[0].target );
+    EXPECT_EQ( 16u, records[0].size );
+    EXPECT_EQ( Record::ExchangeSync, records[1].kind );
+    EXPECT_EQ( Record::Sync, records[2].kind );
+
+    // the replay exchanges the same spans as the recorded computation
+    double seconds = -1.0;
+    BSPLib::SetCommunicationMatrix( "bsp-exchange-replay.csv" );
+    EXPECT_TRUE( BSPLib::Replay( path, seconds ) );
+    BSPLib::SetCommunicationMatrix( "" );
+
+    EXPECT_EQ( lines, ReadLines( "bsp-exchange-replay.csv" ) );
+
+    std::remove( path.c_str() );
+    std::remove( "bsp-exchange-test.csv" );
+    std::remove( "bsp-exchange-replay.csv" );
+}
+
+enum TestSlots
+{
+    TimeSlot,
+    RowSlot
+};
+
+void SlotTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    std::vector< double > times( nProc, 0.0 );
+    uint32_t row[4] = {};
+
+    // binding needs no synchronisation, so the first superstep already communicates
+    BSPLib::BindSlotPtrs< TimeSlot >( times.data(), nProc );
+    BSPLib::BindSlotPtrs< RowSlot >( row, 4 );
+
+    for ( uint32_t j = 0; j < 4; ++j )
+    {
+        row[j] = s * 10 + j;
+    }
+
+    const double time = s + 0.5;
+
+    for ( uint32_t t = 0; t < nProc; ++t )
+    {
+        BSPLib::PutSlotPtrs< TimeSlot >( t, &time, s, 1 );
+    }
+
+    uint32_t right[2] = {};
+    BSPLib::GetSlotPtrs< RowSlot >( ( s + 1 ) % nProc, 2, right, 2 );
+
+    BSPLib::Sync();
+
+    for ( uint32_t t = 0; t < nProc; ++t )
+    {
+        EXPECT_EQ( t + 0.5, times[t] );
+    }
+
+    EXPECT_EQ( ( s + 1 ) % nProc * 10 + 2, right[0] );
+    EXPECT_EQ( ( s + 1 ) % nProc * 10 + 3, right[1] );
+
+    // slots mix with registered variables
+    uint32_t value = s;
+    BSPLib::Push( value );
+    BSPLib::Sync();
+
+    uint32_t received = 0;
+    BSPLib::BindSlot< RowSlot >( received );
+    BSPLib::PutSlot< RowSlot >( ( s + 1 ) % nProc, value );
+    BSPLib::Put( ( s + 1 ) % nProc, value );
+    BSPLib::Sync();
+
+    EXPECT_EQ( ( s + nProc - 1 ) % nProc, received );
+    EXPECT_EQ( ( s + nProc - 1 ) % nProc, value );
+
+    BSPLib::Pop( value );
+    BSPLib::UnbindSlot< TimeSlot >();
+    BSPLib::UnbindSlot< RowSlot >();
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), SlotReplay )
+{
+    const std::string path = "bsp-slot-test.bin";
+
+    BSPLib::SetRecord( path );
+    EXPECT_TRUE( BSPLib::Execute( SlotTest, 3 ) );
+    BSPLib::SetRecord( "" );
+
+    double seconds = -1.0;
+    EXPECT_TRUE( BSPLib::Replay( path, seconds ) );
+    EXPECT_GE( seconds, 0.0 );
+
+    std::remove( path.c_str() );
+}
+
+void SlotBoundsTest()
+{
+    uint32_t values[2] = {};
+    BSPLib::BindSlotPtrs< RowSlot >( values, 2 );
+
+    // the third element lies outside the bound variable of the receiver
+    const uint32_t value = 1;
+    BSPLib::PutSlotPtrs< RowSlot >( ( BSPLib::ProcId() + 1 ) % BSPLib::NProcs(), &value, 2, 1 );
+
+    BSPLib::Sync();
+}
+
+TEST( P( Extra ), SlotOutOfBounds )
+{
+    EXPECT_FALSE( BSPLib::Execute( SlotBoundsTest, 3 ) );
+}
+
+inline void SkewTest()
+{
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        if ( BSPLib::ProcId() == 0 )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+        }
+
+        BSPLib::Sync();
+    }
+}
+
+TEST( P( Extra ), SkewHistograms )
+{
+    const std::string path = "bsp-skew-test.csv";
+
+    BSPLib::SetSkewHistograms( true, path );
+    EXPECT_TRUE( BSPLib::Execute( SkewTest, 4 ) );
+    BSPLib::SetSkewHistograms( false );
+
+    const std::vector< BspInternal::SkewHistogram > histograms = BSPLib::GetSkewHistograms();
+    ASSERT_EQ( 4u, histograms.size() );
+
+    // three synchronisations and the end
+    for ( const BspInternal::SkewHistogram &histogram : histograms )
+    {
+        EXPECT_EQ( 4u, histogram.supersteps );
+    }
+
+    // the others wait for the sleeping processor in every synchronisation
+    for ( uint32_t pid = 1; pid < 4; ++pid )
+    {
+        EXPECT_GE( histograms[pid].max, 50000.0 );
+
+        uint64_t waits = 0;
+
+        for ( size_t bucket = BspInternal::SkewHistogram::Bucket( 50000.0 ); bucket < BSP_SKEW_BUCKETS; ++bucket )
+        {
+            waits += histograms[pid].counts[bucket];
+        }
+
+        EXPECT_GE( waits, 3u );
+    }
+
+    const std::vector< std::string > lines = ReadLines( path );
+    std::remove( path.c_str() );
+
+    ASSERT_EQ( 6u, lines.size() );
+    EXPECT_EQ( 0u, lines[0].find( "pid,supersteps,mean_us,max_us,lt_1us,lt_2us" ) );
+    EXPECT_EQ( 0u, lines[5].find( "all,16," ) );
+
+    EXPECT_TRUE( BSPLib::Execute( SkewTest, 2 ) );
+    EXPECT_TRUE( BSPLib::GetSkewHistograms().empty() );
+}
+
+TEST( P( Extra ), SkewBuckets )
+{
+    EXPECT_EQ( 0u, BspInternal::SkewHistogram::Bucket( 0.0 ) );
+    EXPECT_EQ( 0u, BspInternal::SkewHistogram::Bucket( 0.999 ) );
+    EXPECT_EQ( 1u, BspInternal::SkewHistogram::Bucket( 1.0 ) );
+    EXPECT_EQ( 2u, BspInternal::SkewHistogram::Bucket( 2.0 ) );
+    EXPECT_EQ( 2u, BspInternal::SkewHistogram::Bucket( 3.999 ) );
+    EXPECT_EQ( 11u, BspInternal::SkewHistogram::Bucket( 1024.0 ) );
+    EXPECT_EQ( static_cast< size_t >( BSP_SKEW_BUCKETS - 1 ), BspInternal::SkewHistogram::Bucket( 1e30 ) );
+}
+
+template< uint32_t tSyncs >
+void SparseTrafficTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t receive = 0;
+
+    BSPLib::Push( receive );
+    BSPLib::Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        // only one processor communicates per superstep
+        if ( s == i % nProc )
+        {
+            uint32_t num = i + 1;
+            BSPLib::Put( ( s + 1 ) % nProc, num, receive );
+        }
+
+        BSPLib::Sync();
+
+        if ( s == ( i + 1 ) % nProc )
+        {
+            EXPECT_EQ( i + 1, receive );
+        }
+    }
+
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+template< uint32_t tSize >
+void SendMoveTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+    const uint32_t next = ( s + 1 ) % nProc;
+    const uint32_t prev = ( s + nProc - 1 ) % nProc;
+
+    BSPLib::SetTagsize< uint64_t >();
+    BSPLib::Sync();
+
+    // the tag carries the address of the buffer, which the receiver takes over
+    std::vector< uint32_t > owned( tSize, s );
+    const uint64_t address = reinterpret_cast< uint64_t >( owned.data() );
+    BSPLib::SendMove( next, address, std::move( owned ) );
+    EXPECT_TRUE( owned.empty() );
+
+    std::vector< uint32_t > copied( tSize, s + 1000 );
+    BSPLib::SendMove( next, address, std::move( copied ) );
+
+    uint64_t tag = 0;
+    BSPLib::Send( next, tag, s + 2000 );
+
+    BSPLib::Sync();
+
+    size_t packets, accumulatedSize;
+    BSPLib::Classic::QSize( &packets, &accumulatedSize );
+    EXPECT_EQ( 3u, packets );
+    EXPECT_EQ( 2 * tSize * sizeof( uint32_t ) + sizeof( uint32_t ), accumulatedSize );
+
+    size_t status;
+    BSPLib::Classic::GetTag( &status, &tag );
+
+    std::vector< uint32_t > received;
+    BSPLib::MoveOwned( received );
+    EXPECT_EQ( std::vector< uint32_t >( tSize, prev ), received );
+
+    EXPECT_EQ( tag, reinterpret_cast< uint64_t >( received.data() ) );
+
+    // an owned message can also be copied
+    std::vector< uint32_t > copy( tSize );
+    BSPLib::MoveContainer( copy );
+    EXPECT_EQ( std::vector< uint32_t >( tSize, prev + 1000 ), copy );
+
+    // and a copied message moved into a vector
+    BSPLib::MoveOwned( received );
+    EXPECT_EQ( std::vector< uint32_t >( 1, prev + 2000 ), received );
+
+    BSPLib::Sync();
+}
+
+void GetAsyncFanoutTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    std::vector< uint64_t > data( 64 );
+
+    for ( size_t i = 0; i < data.size(); ++i )
+    {
+        data[i] = s * 1000 + i;
+    }
+
+    BSPLib::PushContainer( data );
+    BSPLib::Sync();
+
+    const void *storage = nullptr;
+
+    for ( uint32_t round = 0; round < 3; ++round )
+    {
+        std::vector< BSPLib::Future< uint64_t > > futures;
+
+        for ( uint32_t t = 0; t < nProc; ++t )
+        {
+            futures.emplace_back( BSPLib::GetAsyncPtrs( t, data.data(), round, 8 ) );
+        }
+
+        BSPLib::GetAsync( ( s + 1 ) % nProc, data[0] );
+
+        BSPLib::Sync();
+
+        for ( uint32_t t = 0; t < nProc; ++t )
+        {
+            ASSERT_TRUE( futures[t].IsReady() );
+
+            for ( size_t i = 0; i < 8; ++i )
+            {
+                EXPECT_EQ( t * 1000 + round + i, futures[t][i] );
+            }
+        }
+
+        // the storage of the previous round is reused
+        if ( storage )
+        {
+            bool reused = false;
+
+            for ( const BSPLib::Future< uint64_t > &future : futures )
+            {
+                reused |= future.Data() == storage;
+            }
+
+            EXPECT_TRUE( reused );
+        }
+
+        storage = futures.back().Data();
+    }
+
+    BSPLib::Future< uint64_t > empty;
+    EXPECT_FALSE( empty.IsReady() );
+
+    BSPLib::PopContainer( data );
+    BSPLib::Sync();
+}
+
 BspTest2( Extra, 2, PutPaddedPrimitiveTest, 1, uint8_t );
 BspTest2( Extra, 4, PutPaddedPrimitiveTest, 3, uint8_t );
 BspTest2( Extra, 8, PutPaddedPrimitiveTest, 7, uint8_t );
@@ -406,9 +1258,21 @@ BspTest2( Extra, 32, PutPaddedTwicePrimitiveTest, 13, uint64_t );
 
 BspTest( Extra, 32, BSPAbortMessageTest );
 
+BspTest1( Extra, 256, SparseTrafficTest, 20 );
+
 BspTest3( Extra, 8, TagVectorOverloadTest, uint32_t, 23, 5 );
 BspTest3( Extra, 8, TagStdArrayOverloadTest, uint32_t, 23, 5 );
 BspTest3( Extra, 8, TagCArrayOverloadTest, uint32_t, 23, 5 );
 BspTest3( Extra, 8, TagCArrayOverloadTest2, uint32_t, 23, 5 );
 BspTest2( Extra, 8, TagPrimitiveOverloadTest, 5, uint32_t );
-BspTest1( Extra, 8, TagPrimitiveStringOverloadTest, 5 );
\ No newline at end of file
+BspTest1( Extra, 8, TagPrimitiveStringOverloadTest, 5 );
+
+BspTest1( Extra, 1, SendMoveTest, 3 );
+BspTest1( Extra, 4, SendMoveTest, 1 );
+BspTest1( Extra, 8, SendMoveTest, 100000 );
+
+BspTest( Extra, 1, GetAsyncFanoutTest );
+BspTest( Extra, 6, GetAsyncFanoutTest );
+
+BspTest( Extra, 1, SlotTest );
+BspTest( Extra, 7, SlotTest );
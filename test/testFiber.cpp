@@ -0,0 +1,164 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <thread>
+
+#define FiberTest( nProc, nWorkers, func )                  \
+TEST( P( Fiber ), func ## _ ## nProc ## _ ## nWorkers )     \
+{                                                           \
+    BSPLib::SetWorkers( nWorkers );                         \
+    EXPECT_TRUE( BSPLib::Execute( func, nProc ) );          \
+    BSPLib::SetWorkers( 0 );                                \
+}
+
+#define FiberTest1( nProc, nWorkers, func, a )                      \
+TEST( P( Fiber ), func ## _ ## nProc ## _ ## nWorkers ## _ ## a )   \
+{                                                                   \
+    BSPLib::SetWorkers( nWorkers );                                 \
+    EXPECT_TRUE( BSPLib::Execute( func< a >, nProc ) );             \
+    BSPLib::SetWorkers( 0 );                                        \
+}
+
+template< uint32_t tSyncs >
+void FiberPutTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    uint32_t receive = 0;
+
+    BSPLib::Push( receive );
+    BSPLib::Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        uint32_t num = s + i;
+        BSPLib::Put( ( s + 1 ) % nProc, num, receive );
+
+        BSPLib::Sync();
+
+        EXPECT_EQ( s, BSPLib::ProcId() );
+        EXPECT_EQ( ( s + nProc - 1 ) % nProc + i, receive );
+    }
+
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+inline void FiberSendTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t nProc = BSPLib::NProcs();
+
+    for ( uint32_t i = 0; i < nProc; ++i )
+    {
+        BSPLib::Send( i, s );
+    }
+
+    BSPLib::Sync();
+
+    size_t packets = 0;
+    BSPLib::QSize( packets );
+    EXPECT_EQ( nProc, packets );
+
+    uint64_t sum = 0;
+
+    for ( size_t i = 0; i < packets; ++i )
+    {
+        uint32_t message = 0;
+        BSPLib::Move( message );
+        sum += message;
+    }
+
+    EXPECT_EQ( ( uint64_t )nProc * ( nProc - 1 ) / 2, sum );
+}
+
+template< uint32_t tWorkers >
+void FiberWorkersTest()
+{
+    EXPECT_EQ( tWorkers, BSPLib::GetWorkers() );
+    BSPLib::Sync();
+}
+
+inline void FiberAbortTest()
+{
+    BSPLib::Sync();
+
+    if ( BSPLib::ProcId() == 3 )
+    {
+        BSPLib::Classic::Abort( "" );
+    }
+
+    BSPLib::Sync();
+}
+
+FiberTest1( 8, 1, FiberPutTest, 5 );
+FiberTest1( 8, 2, FiberPutTest, 5 );
+FiberTest1( 17, 3, FiberPutTest, 5 );
+FiberTest1( 64, 4, FiberPutTest, 3 );
+FiberTest1( 1024, 4, FiberPutTest, 2 );
+
+FiberTest( 8, 1, FiberSendTest );
+FiberTest( 16, 3, FiberSendTest );
+FiberTest( 64, 4, FiberSendTest );
+
+FiberTest1( 8, 2, FiberWorkersTest, 2 );
+FiberTest1( 8, 8, FiberWorkersTest, 8 );
+
+TEST( P( Fiber ), FiberAbortTest )
+{
+    BSPLib::SetWorkers( 2 );
+    EXPECT_FALSE( BSPLib::Execute( FiberAbortTest, 16 ) );
+    EXPECT_TRUE( BSPLib::Execute( FiberSendTest, 16 ) );
+    BSPLib::SetWorkers( 0 );
+}
+
+inline void FiberSkewTest()
+{
+    for ( uint32_t i = 0; i < 3; ++i )
+    {
+        if ( BSPLib::ProcId() == 0 )
+        {
+            std::this_thread::sleep_for( std::chrono::milliseconds( 100 ) );
+        }
+
+        BSPLib::Sync();
+    }
+}
+
+TEST( P( Fiber ), SkewHistograms )
+{
+    BSPLib::SetWorkers( 2 );
+    BSPLib::SetSkewHistograms( true );
+    EXPECT_TRUE( BSPLib::Execute( FiberSkewTest, 4 ) );
+    BSPLib::SetSkewHistograms( false );
+    BSPLib::SetWorkers( 0 );
+
+    const std::vector< BspInternal::SkewHistogram > histograms = BSPLib::GetSkewHistograms();
+    ASSERT_EQ( 4u, histograms.size() );
+
+    // the processors of the other worker wait for the sleeping processor
+    EXPECT_GE( histograms[2].max, 50000.0 );
+    EXPECT_GE( histograms[3].max, 50000.0 );
+    EXPECT_EQ( 4u, histograms[3].supersteps );
+}
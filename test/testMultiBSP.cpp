@@ -0,0 +1,197 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#include <cstdio>
+#include <string>
+
+#define MultiBSPTest( nProc, fanouts, func )                            \
+TEST( P( MultiBSP ), func ## _ ## nProc )                               \
+{                                                                       \
+    BSPLib::MultiBSP::SetFanouts( std::vector< uint32_t >fanouts );     \
+    EXPECT_TRUE( BSPLib::Execute( func, nProc ) );                      \
+    BSPLib::MultiBSP::SetFanouts( {} );                                 \
+}
+
+#define MultiBSPTest1( nProc, fanouts, func, a )                        \
+TEST( P( MultiBSP ), func ## _ ## nProc ## _ ## a )                     \
+{                                                                       \
+    BSPLib::MultiBSP::SetFanouts( std::vector< uint32_t >fanouts );     \
+    EXPECT_TRUE( BSPLib::Execute( func< a >, nProc ) );                 \
+    BSPLib::MultiBSP::SetFanouts( {} );                                 \
+}
+
+void LevelsTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+
+    EXPECT_EQ( 3u, BSPLib::MultiBSP::Levels() );
+
+    EXPECT_EQ( 12u, BSPLib::MultiBSP::GroupSize( 0 ) );
+    EXPECT_EQ( 0u, BSPLib::MultiBSP::GroupId( 0 ) );
+    EXPECT_EQ( s, BSPLib::MultiBSP::GroupPid( 0 ) );
+
+    EXPECT_EQ( 4u, BSPLib::MultiBSP::GroupSize( 1 ) );
+    EXPECT_EQ( s / 4, BSPLib::MultiBSP::GroupId( 1 ) );
+    EXPECT_EQ( s % 4, BSPLib::MultiBSP::GroupPid( 1 ) );
+
+    EXPECT_EQ( 1u, BSPLib::MultiBSP::GroupSize( 2 ) );
+    EXPECT_EQ( s, BSPLib::MultiBSP::GroupId( 2 ) );
+    EXPECT_EQ( 0u, BSPLib::MultiBSP::GroupPid( 2 ) );
+}
+
+MultiBSPTest( 12, ( { 3, 4 } ), LevelsTest );
+
+void TopologyTest()
+{
+    const uint32_t levels = BSPLib::MultiBSP::Levels();
+
+    EXPECT_EQ( 3u, levels );
+    EXPECT_EQ( BSPLib::NProcs(), BSPLib::MultiBSP::GroupSize( 0 ) );
+    EXPECT_EQ( 0u, BSPLib::NProcs() % BSPLib::MultiBSP::GroupSize( 1 ) );
+    EXPECT_EQ( 1u, BSPLib::MultiBSP::GroupSize( levels - 1 ) );
+
+    BSPLib::MultiBSP::Sync( 1 );
+    BSPLib::MultiBSP::Sync( 2 );
+    BSPLib::MultiBSP::Sync( 0 );
+}
+
+BspTest( MultiBSP, 8, TopologyTest );
+
+template< uint32_t tSyncs >
+void GroupRingTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+    const uint32_t groupPid = BSPLib::MultiBSP::GroupPid( 1 );
+    const uint32_t groupSize = BSPLib::MultiBSP::GroupSize( 1 );
+
+    uint32_t receive = 0;
+
+    BSPLib::Push( receive );
+    BSPLib::Sync();
+
+    // the groups synchronise a different amount of times
+    const uint32_t syncs = tSyncs + BSPLib::MultiBSP::GroupId( 1 );
+
+    for ( uint32_t i = 0; i < syncs; ++i )
+    {
+        uint32_t num = s * syncs + i;
+        BSPLib::MultiBSP::Put( 1, ( groupPid + 1 ) % groupSize, num, receive );
+
+        BSPLib::MultiBSP::Sync( 1 );
+
+        const uint32_t left = s - groupPid + ( groupPid + groupSize - 1 ) % groupSize;
+        EXPECT_EQ( left * syncs + i, receive );
+    }
+
+    BSPLib::Pop( receive );
+    BSPLib::Sync();
+}
+
+MultiBSPTest1( 8, ( { 2, 4 } ), GroupRingTest, 50 );
+MultiBSPTest1( 16, ( { 4, 2, 2 } ), GroupRingTest, 50 );
+
+void DeliverOnMachineSyncTest()
+{
+    const uint32_t s = BSPLib::ProcId();
+
+    std::vector< uint32_t > values( BSPLib::MultiBSP::GroupSize( 1 ), 0 );
+
+    BSPLib::PushPtrs( values.data(), values.size() );
+    BSPLib::Sync();
+
+    uint32_t value = s + 1;
+
+    for ( uint32_t target = 0; target < values.size(); ++target )
+    {
+        BSPLib::MultiBSP::PutPtrs( 1, target, &value, 1, values.data(), BSPLib::MultiBSP::GroupPid( 1 ) );
+    }
+
+    BSPLib::Sync();
+
+    const uint32_t first = BSPLib::MultiBSP::GroupId( 1 ) * BSPLib::MultiBSP::GroupSize( 1 );
+
+    for ( uint32_t i = 0; i < values.size(); ++i )
+    {
+        EXPECT_EQ( first + i + 1, values[i] );
+    }
+
+    BSPLib::PopPtrs( values.data() );
+    BSPLib::Sync();
+}
+
+MultiBSPTest( 12, ( { 3, 4 } ), DeliverOnMachineSyncTest );
+
+void GroupAbortTest()
+{
+    if ( BSPLib::ProcId() == 1 )
+    {
+        BSPLib::Classic::Abort( "" );
+    }
+
+    BSPLib::MultiBSP::Sync( 1 );
+    BSPLib::MultiBSP::Sync( 1 );
+}
+
+TEST( P( MultiBSP ), GroupAbortTest )
+{
+    BSPLib::MultiBSP::SetFanouts( { 2, 4 } );
+    EXPECT_FALSE( BSPLib::Execute( GroupAbortTest, 8 ) );
+    BSPLib::MultiBSP::SetFanouts( {} );
+}
+
+TEST( P( MultiBSP ), GroupRecordRefused )
+{
+    const std::string path = "bsp-group-record-test.bin";
+    std::remove( path.c_str() );
+
+    // the group puts can not be replayed, so no recording is written rather than one without them
+    BSPLib::SetRecord( path );
+    BSPLib::MultiBSP::SetFanouts( { 3, 4 } );
+    EXPECT_TRUE( BSPLib::Execute( DeliverOnMachineSyncTest, 12 ) );
+    BSPLib::MultiBSP::SetFanouts( {} );
+    BSPLib::SetRecord( "" );
+
+    FILE *file = fopen( path.c_str(), "rb" );
+    EXPECT_EQ( nullptr, file );
+
+    if ( file )
+    {
+        fclose( file );
+        std::remove( path.c_str() );
+    }
+}
+
+TEST( P( MultiBSP ), DefaultFanouts )
+{
+    typedef std::vector< uint32_t > Fanouts;
+
+    EXPECT_EQ( Fanouts( { 2, 3 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 0, 0, 1, 1, 1 } ) );
+    EXPECT_EQ( Fanouts( { 3, 2 } ), BspInternal::Hierarchy::DefaultFanouts( { 1, 1, 0, 0, 2, 2 } ) );
+    EXPECT_EQ( Fanouts( { 1, 4 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 0, 0, 0 } ) );
+
+    // unpinned threads, packages in several runs, and runs of different sizes
+    EXPECT_EQ( Fanouts( { 1, 4 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 0, 1, -1 } ) );
+    EXPECT_EQ( Fanouts( { 1, 4 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 1, 0, 1 } ) );
+    EXPECT_EQ( Fanouts( { 1, 4 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 0, 0, 1 } ) );
+    EXPECT_EQ( Fanouts( { 1, 6 } ), BspInternal::Hierarchy::DefaultFanouts( { 0, 0, 1, 1, 1, 1 } ) );
+}
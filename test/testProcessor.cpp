@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "helper.h"
+
+#define ProcessorTest( nProc, func )                                    \
+TEST( P( Processor ), func ## _ ## nProc )                              \
+{                                                                       \
+    EXPECT_TRUE( BSPLib::Execute( func, nProc ) );                      \
+}
+
+#define ProcessorTest1( nProc, func, a )                                \
+TEST( P( Processor ), func ## _ ## nProc ## _ ## a )                    \
+{                                                                       \
+    EXPECT_TRUE( BSPLib::Execute( func< a >, nProc ) );                 \
+}
+
+void IdentityTest( BSPLib::Processor &processor )
+{
+    EXPECT_EQ( BSPLib::ProcId(), processor.ProcId() );
+    EXPECT_EQ( BSPLib::NProcs(), processor.NProcs() );
+}
+
+ProcessorTest( 1, IdentityTest );
+ProcessorTest( 16, IdentityTest );
+
+template< uint32_t tSyncs >
+void RingPutTest( BSPLib::Processor &processor )
+{
+    const uint32_t s = processor.ProcId();
+    const uint32_t nProc = processor.NProcs();
+
+    uint32_t receive = 0;
+    uint32_t buffer[4] = {};
+
+    processor.Push( receive );
+    processor.PushPtrs( buffer, 4 );
+    processor.Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        uint32_t num = s * tSyncs + i;
+        uint32_t nums[2] = { num, num + 1 };
+
+        processor.Put( ( s + 1 ) % nProc, num, receive );
+        processor.PutPtrs( ( s + 1 ) % nProc, nums, 2, buffer, 1 );
+
+        processor.Sync();
+
+        const uint32_t left = ( s + nProc - 1 ) % nProc;
+        EXPECT_EQ( left * tSyncs + i, receive );
+        EXPECT_EQ( left * tSyncs + i, buffer[1] );
+        EXPECT_EQ( left * tSyncs + i + 1, buffer[2] );
+    }
+
+    processor.Pop( &receive );
+    processor.Pop( buffer );
+    processor.Sync();
+}
+
+ProcessorTest1( 8, RingPutTest, 100 );
+
+template< uint32_t tSyncs >
+void RingGetTest( BSPLib::Processor &processor )
+{
+    const uint32_t s = processor.ProcId();
+    const uint32_t nProc = processor.NProcs();
+
+    uint32_t value = 0;
+    uint32_t values[3] = {};
+
+    processor.Push( value );
+    processor.PushPtrs( values, 3 );
+    processor.Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        value = s * tSyncs + i;
+
+        for ( uint32_t j = 0; j < 3; ++j )
+        {
+            values[j] = value + j;
+        }
+
+        processor.Sync();
+
+        uint32_t result = 0;
+        uint32_t results[2] = {};
+        processor.Get( ( s + 1 ) % nProc, value, result );
+        processor.GetPtrs( ( s + 1 ) % nProc, values, 1, results, 2 );
+
+        processor.Sync();
+
+        const uint32_t right = ( s + 1 ) % nProc;
+        EXPECT_EQ( right * tSyncs + i, result );
+        EXPECT_EQ( right * tSyncs + i + 1, results[0] );
+        EXPECT_EQ( right * tSyncs + i + 2, results[1] );
+    }
+
+    processor.Pop( &value );
+    processor.Pop( values );
+    processor.Sync();
+}
+
+ProcessorTest1( 8, RingGetTest, 50 );
+
+template< uint32_t tSyncs >
+void RingGetAsyncTest( BSPLib::Processor &processor )
+{
+    const uint32_t s = processor.ProcId();
+    const uint32_t nProc = processor.NProcs();
+
+    uint32_t value = 0;
+    uint32_t values[3] = {};
+
+    processor.Push( value );
+    processor.PushPtrs( values, 3 );
+    processor.Sync();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        value = s * tSyncs + i;
+
+        for ( uint32_t j = 0; j < 3; ++j )
+        {
+            values[j] = value + j;
+        }
+
+        processor.Sync();
+
+        BSPLib::Future< uint32_t > result = processor.GetAsync( ( s + 1 ) % nProc, value );
+        BSPLib::Future< uint32_t > results = processor.GetAsyncPtrs( ( s + 1 ) % nProc, values, 1, 2 );
+        EXPECT_FALSE( result.IsReady() );
+
+        processor.Sync();
+
+        const uint32_t right = ( s + 1 ) % nProc;
+        ASSERT_TRUE( results.IsReady() );
+        EXPECT_EQ( right * tSyncs + i, result.Value() );
+        EXPECT_EQ( 2u, results.Size() );
+        EXPECT_EQ( right * tSyncs + i + 1, results[0] );
+        EXPECT_EQ( right * tSyncs + i + 2, results[1] );
+    }
+
+    processor.Pop( &value );
+    processor.Pop( values );
+    processor.Sync();
+}
+
+ProcessorTest1( 8, RingGetAsyncTest, 50 );
+
+template< uint32_t tSyncs >
+void RingSendTest( BSPLib::Processor &processor )
+{
+    const uint32_t s = processor.ProcId();
+    const uint32_t nProc = processor.NProcs();
+
+    for ( uint32_t i = 0; i < tSyncs; ++i )
+    {
+        processor.Send( ( s + 1 ) % nProc, s * tSyncs + i );
+
+        processor.Sync();
+
+        uint32_t message = 0;
+        processor.Move( message );
+
+        EXPECT_EQ( ( ( s + nProc - 1 ) % nProc ) * tSyncs + i, message );
+    }
+}
+
+ProcessorTest1( 8, RingSendTest, 100 );
+
+TEST( P( Processor ), Context )
+{
+    BSPLib::Context context;
+
+    EXPECT_TRUE( context.Execute( RingPutTest< 10 >, 5 ) );
+}
+
+TEST( P( Processor ), Fibers )
+{
+    BSPLib::SetWorkers( 2 );
+    EXPECT_TRUE( BSPLib::Execute( RingSendTest< 10 >, 16 ) );
+    BSPLib::SetWorkers( 0 );
+}
@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "bsp/bsp.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+/*  This program replays a computation recorded with BSP_RECORD, to benchmark
+    changes to the runtime against the traffic of a real application.
+
+    usage: replay <recording> [repetitions]
+*/
+
+int main( int argc, char **argv )
+{
+    if ( argc < 2 )
+    {
+        fprintf( stderr, "usage: %s <recording> [repetitions]\n", argv[0] );
+        return EXIT_FAILURE;
+    }
+
+    const int repetitions = argc > 2 ? atoi( argv[2] ) : 5;
+
+    BspInternal::Recording recording;
+
+    if ( !recording.Load( argv[1] ) )
+    {
+        fprintf( stderr, "Could not read the recording `%s`, or it is corrupt.\n", argv[1] );
+        return EXIT_FAILURE;
+    }
+
+    size_t supersteps = 0;
+    size_t messages = 0;
+    unsigned long long bytes = 0;
+
+    for ( const auto &records : recording.processors )
+    {
+        size_t syncs = 0;
+
+        for ( const auto &record : records )
+        {
+            switch ( record.kind )
+            {
+            case BspInternal::ReplayRecord::Sync:
+            case BspInternal::ReplayRecord::ExchangeSync:
+                ++syncs;
+                break;
+
+            case BspInternal::ReplayRecord::Put:
+            case BspInternal::ReplayRecord::Get:
+            case BspInternal::ReplayRecord::Send:
+            case BspInternal::ReplayRecord::Exchange:
+                ++messages;
+                bytes += record.size + record.tagSize;
+                break;
+            }
+        }
+
+        supersteps = syncs > supersteps ? syncs : supersteps;
+    }
+
+    printf( "p= %u, supersteps= %zu, messages= %zu, bytes= %llu\n",
+            static_cast< uint32_t >( recording.processors.size() ), supersteps, messages, bytes );
+
+    double total = 0.0;
+
+    for ( int i = 0; i < repetitions; ++i )
+    {
+        double seconds = 0.0;
+
+        if ( !BSPLib::Replay( recording, seconds ) )
+        {
+            fprintf( stderr, "The replay failed.\n" );
+            return EXIT_FAILURE;
+        }
+
+        printf( "run %2d: %10.6lf sec, %8.3lf usec per superstep\n", i, seconds,
+                supersteps > 0 ? seconds * 1e6 / supersteps : 0.0 );
+        total += seconds;
+    }
+
+    if ( repetitions > 0 )
+    {
+        printf( "average: %10.6lf sec\n", total / repetitions );
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2015 Mick van Duijn, Koen Visscher and Paul Visscher
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include "bsp/bsp.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/*  This program benchmarks BSPLib::Sort on random 64 bit keys, for key counts
+    from 4096 up to the given maximum in steps of 4, and for 1, 2, 4, ... up to
+    the given amount of processors. It reports the best time of the repetitions,
+    and the imbalance: the largest amount of keys a processor ends up with,
+    relative to the average.
+
+    usage: sortbench [max keys] [max processors] [repetitions]
+*/
+
+int main( int argc, char **argv )
+{
+    const size_t maxKeys = argc > 1 ? strtoull( argv[1], nullptr, 10 ) : ( 1u << 22 );
+    const uint32_t maxProcs = argc > 2 ? static_cast< uint32_t >( atoi( argv[2] ) ) : BSPLib::NProcs();
+    const int repetitions = argc > 3 ? atoi( argv[3] ) : 3;
+
+    printf( "%12s %5s %12s %12s %10s\n", "keys", "p", "seconds", "Mkeys/s", "imbalance" );
+
+    for ( size_t keys = 4096; keys <= maxKeys; keys *= 4 )
+    {
+        for ( uint32_t p = 1; p <= maxProcs; p *= 2 )
+        {
+            double best = 0.0;
+            size_t largest = 0;
+
+            for ( int run = 0; run < repetitions; ++run )
+            {
+                std::vector< double > seconds( p );
+                std::vector< size_t > sizes( p );
+
+                BSPLib::Execute( [&]
+                {
+                    const uint32_t s = BSPLib::ProcId();
+                    const size_t first = keys * s / p;
+                    const size_t last = keys * ( s + 1 ) / p;
+
+                    std::vector< uint64_t > values( last - first );
+                    uint64_t state = first * 2654435761ull + run + 1;
+
+                    for ( uint64_t &value : values )
+                    {
+                        state = state * 6364136223846793005ull + 1442695040888963407ull;
+                        value = state >> 11;
+                    }
+
+                    BSPLib::Sync();
+                    const double start = BSPLib::Time();
+
+                    BSPLib::Sort( values );
+
+                    BSPLib::Sync();
+                    seconds[s] = BSPLib::Time() - start;
+                    sizes[s] = values.size();
+                }, p );
+
+                const double time = *std::max_element( seconds.begin(), seconds.end() );
+
+                if ( run == 0 || time < best )
+                {
+                    best = time;
+                }
+
+                largest = std::max( largest, *std::max_element( sizes.begin(), sizes.end() ) );
+            }
+
+            printf( "%12zu %5u %12.6lf %12.3lf %10.3lf\n", keys, p, best, best > 0.0 ? keys / best * 1e-6 : 0.0,
+                    static_cast< double >( largest ) * p / keys );
+        }
+    }
+
+    return EXIT_SUCCESS;
+}